@@ -0,0 +1,11 @@
+#pragma once
+
+#include <atomic>                          // For the counters
+#include <cstdint>                         // Fixed-width integer types
+
+// Every allocation made by the process goes through these counters, so each benchmark can report
+// how many allocations and bytes one iteration costs. The replaced operator new and delete live in
+// their own translation unit so they are never inlined into a call site, where GCC would pair the
+// malloc() and free() inside them with the new and delete expressions and warn about a mismatch.
+extern std::atomic<uint64_t> allocationCount;
+extern std::atomic<uint64_t> allocationBytes;
@@ -0,0 +1,167 @@
+#include "asset_loader.h"
+
+#include <algorithm>                       // For std::min()/std::max()
+#include <chrono>                          // For timing the whole load
+#include <iostream>                        // Standard input/output stream library
+
+AssetLoader::~AssetLoader() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        cancelled_ = true;
+    }
+    reloadWake_.notify_all();
+    if (worker_.joinable())
+        worker_.join();
+    if (reloadThread_.joinable())
+        reloadThread_.join();
+}
+
+void AssetLoader::start(const std::vector<std::string>& paths, const LoadSettings& settings, bool buildPicking) {
+    settings_ = settings;
+    buildPicking_ = buildPicking;
+    pickable_.assign(paths.size(), nullptr);
+    worker_ = std::thread(&AssetLoader::run, this, paths, settings);
+}
+
+void AssetLoader::requestReload(uint32_t meshId, const std::string& path, std::chrono::steady_clock::time_point detectedAt) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const ReloadRequest& request : reloadRequests_) {
+        if (request.meshId == meshId)
+            return; // Already waiting; the re-parse will see the newest contents
+    }
+    reloadRequests_.push_back({meshId, path, detectedAt});
+    if (!reloadThread_.joinable())
+        reloadThread_ = std::thread(&AssetLoader::reloadLoop, this);
+    reloadWake_.notify_one();
+}
+
+bool AssetLoader::tryPopReload(ReloadBatch& batch) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (reloadResults_.empty())
+        return false;
+    batch = std::move(reloadResults_.front());
+    reloadResults_.pop_front();
+    return true;
+}
+
+void AssetLoader::reloadLoop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+        reloadWake_.wait(lock, [this] { return cancelled_ || !reloadRequests_.empty(); });
+        if (cancelled_)
+            return;
+        ReloadRequest request = std::move(reloadRequests_.front());
+        reloadRequests_.pop_front();
+        lock.unlock();
+
+        auto start = std::chrono::steady_clock::now();
+        Mesh mesh;
+        ReloadBatch batch;
+        bool loaded = loadMesh(request.path, settings_, mesh); // The stale mesh cache is rejected by its stamp
+        if (loaded) {
+            batch.meshId = request.meshId;
+            batch.geometry = buildIndexedGeometry(mesh, settings_.lodLevels, settings_.optimize, settings_.meshlets);
+            for (DrawShape& shape : batch.geometry.shapes)
+                shape.meshId = request.meshId;
+            batch.detectedAt = request.detectedAt;
+            batch.parseMillis = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            if (buildPicking_)
+                buildPicking(request.meshId, mesh, settings_.threads, false);
+        }
+
+        lock.lock();
+        if (loaded) // A half-written or broken file keeps the resident version
+            reloadResults_.push_back(std::move(batch));
+    }
+}
+
+bool AssetLoader::tryPop(IndexedGeometry& chunk) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (queue_.empty())
+        return false;
+    chunk = std::move(queue_.front());
+    queue_.pop_front();
+    return true;
+}
+
+std::vector<std::shared_ptr<const PickableMesh>> AssetLoader::pickableMeshes() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return pickable_;
+}
+
+void AssetLoader::buildPicking(uint32_t meshId, const Mesh& mesh, unsigned threads, bool verbose) {
+    auto start = std::chrono::steady_clock::now();
+    auto pickable = std::make_shared<PickableMesh>();
+    ThreadPool pool(threads);
+    buildPickableMesh(mesh, pool, *pickable);
+    if (verbose) {
+        double millis = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "Built BVH: " << pickable->bvh.triangleCount() << " triangles, " << pickable->bvh.nodeCount()
+                  << " nodes, depth " << pickable->bvh.depth() << " in " << millis << " ms" << std::endl;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    pickable_[meshId] = std::move(pickable);
+}
+
+bool AssetLoader::drained() {
+    if (!finished_) // Checked first: the worker sets it after queuing its last chunk
+        return false;
+    std::lock_guard<std::mutex> lock(mutex_);
+    return queue_.empty();
+}
+
+void AssetLoader::run(std::vector<std::string> paths, LoadSettings settings) {
+    auto start = std::chrono::steady_clock::now();
+
+    // One thread per file up to the core count; the parser threads are split between them
+    unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+    unsigned fileThreads = std::min<unsigned>(cores, static_cast<unsigned>(paths.size()));
+    if (settings.threads == 0)
+        settings.threads = std::max(1u, cores / std::max(1u, fileThreads));
+    settings.verbose = paths.size() == 1; // Per-file lines would drown out the summary
+
+    std::atomic<std::size_t> next{0};
+    std::vector<std::thread> threads;
+    for (unsigned t = 0; t < fileThreads; ++t) {
+        threads.emplace_back([&] {
+            for (std::size_t i = next++; i < paths.size() && !cancelled_; i = next++)
+                loadFile(static_cast<uint32_t>(i), paths[i], settings);
+        });
+    }
+    for (std::thread& thread : threads)
+        thread.join();
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "Loaded " << paths.size() << " model file(s) in " << seconds << " s" << std::endl;
+    printGeometryStats(stats_);
+    finished_ = true;
+}
+
+void AssetLoader::loadFile(uint32_t meshId, const std::string& path, const LoadSettings& settings) {
+    Mesh mesh;
+    if (!loadMesh(path, settings, mesh)) {
+        failed_ = true;
+        return;
+    }
+
+    // Every shape becomes its own chunk so the first objects can be drawn while the rest are still indexed
+    GeometryStats stats;
+    for (const MeshShape& shape : mesh.shapes) {
+        if (cancelled_)
+            return;
+        IndexedGeometry chunk;
+        appendIndexedShape(chunk, mesh, shape, settings.lodLevels, settings.optimize, settings.meshlets);
+        chunk.shapes.back().meshId = meshId;
+        stats += measureGeometry(chunk);
+        std::lock_guard<std::mutex> lock(mutex_);
+        queue_.push_back(std::move(chunk));
+    }
+    {
+        std::lock_guard<std::mutex> lock(statsMutex_);
+        stats_ += stats;
+    }
+
+    // Picking is not needed for the first frames, so the BVH waits until every shape is queued
+    if (buildPicking_ && !cancelled_)
+        buildPicking(meshId, mesh, settings.threads, settings.verbose);
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <atomic>                          // Completion flags shared with the render thread
+#include <chrono>                          // Reload latency timestamps
+#include <condition_variable>              // Wakes the reload thread
+#include <deque>                           // Queue of finished chunks
+#include <memory>                          // Shared BVHs
+#include <mutex>                           // Guards the queue
+#include <string>                          // For file paths
+#include <thread>                          // Background workers
+#include <vector>                          // For using the std::vector container
+#include "geometry.h"                      // Chunks are ready-to-upload indexed geometry
+#include "obj_loader.h"                    // For LoadSettings
+#include "picking.h"                       // BVHs for picking
+
+// Every shape of a re-parsed file, indexed as one geometry with ranges relative to the batch
+struct ReloadBatch {
+    uint32_t meshId = 0;                   // File that changed
+    IndexedGeometry geometry;
+    std::chrono::steady_clock::time_point detectedAt; // When the file watcher saw the write
+    double parseMillis = 0.0;              // Time spent re-parsing and indexing
+};
+
+// Loads OBJ files on background threads and hands finished shapes to the GL thread one chunk at a time
+class AssetLoader {
+public:
+    AssetLoader() = default;
+    ~AssetLoader();
+    AssetLoader(const AssetLoader&) = delete;
+    AssetLoader& operator=(const AssetLoader&) = delete;
+
+    // Start loading paths concurrently; chunks of paths[i] carry meshId i in their DrawShape.
+    // With buildPicking a BVH of every file is built after its chunks are queued, and again on reload.
+    void start(const std::vector<std::string>& paths, const LoadSettings& settings, bool buildPicking = false);
+
+    // Take the next finished chunk (one shape, indices relative to its own vertices), false if none is ready
+    bool tryPop(IndexedGeometry& chunk);
+
+    // True once the workers have queued their last chunk (or failed)
+    bool finished() const { return finished_; }
+    // Re-parse path on the reload thread; the result is returned by tryPopReload()
+    void requestReload(uint32_t meshId, const std::string& path, std::chrono::steady_clock::time_point detectedAt);
+    // Take the next re-parsed file, false if none is ready
+    bool tryPopReload(ReloadBatch& batch);
+
+    // BVH per meshId, null until built; the entries are replaced, never modified, on reload
+    std::vector<std::shared_ptr<const PickableMesh>> pickableMeshes();
+
+    // True once every chunk has been queued and taken
+    bool drained();
+    // True if any OBJ could not be loaded
+    bool failed() const { return failed_; }
+
+private:
+    void run(std::vector<std::string> paths, LoadSettings settings);
+    void loadFile(uint32_t meshId, const std::string& path, const LoadSettings& settings);
+    void reloadLoop();
+    // Build and publish the BVH of mesh
+    void buildPicking(uint32_t meshId, const Mesh& mesh, unsigned threads, bool verbose);
+
+    std::thread worker_;                   // Coordinates the per-file threads
+    std::mutex statsMutex_;
+    GeometryStats stats_;                  // Summed over all files
+    std::mutex mutex_;
+    std::deque<IndexedGeometry> queue_;
+    std::atomic<bool> finished_{false};
+    std::atomic<bool> failed_{false};
+    LoadSettings settings_;                // Settings of the initial load, reused for reloads
+    bool buildPicking_ = false;
+    std::vector<std::shared_ptr<const PickableMesh>> pickable_; // Guarded by mutex_
+
+    // Hot reload state
+    struct ReloadRequest {
+        uint32_t meshId;
+        std::string path;
+        std::chrono::steady_clock::time_point detectedAt;
+    };
+    std::thread reloadThread_;             // Started by the first reload request
+    std::condition_variable reloadWake_;
+    std::deque<ReloadRequest> reloadRequests_;
+    std::deque<ReloadBatch> reloadResults_;
+
+    std::atomic<bool> cancelled_{false};   // Set by the destructor to stop between files and shapes
+};
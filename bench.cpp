@@ -0,0 +1,1444 @@
+#include <algorithm>                       // For std::sort()/std::min()
+#include <chrono>                          // For timing
+#include <cfloat>                          // For FLT_MAX
+#include <cmath>                           // For std::abs()/std::sqrt()
+#include <cstdio>                          // For std::remove()
+#include <cstdlib>                         // For std::strtod()/std::atoi()
+#include <cstring>                         // For std::memcmp()/std::memset()
+#include <filesystem>                      // Temporary directory for synthetic meshes
+#include <fstream>                         // For writing the JSON report
+#include <functional>                      // For the benchmark bodies
+#include <iostream>                        // Standard input/output stream library
+#include <random>                          // Random views for the culling check
+#include <sstream>                         // For building the JSON report
+#include <string>                          // For names and paths
+#include <thread>                          // For std::thread::hardware_concurrency()
+#include <vector>                          // For using the std::vector container
+#include <sys/resource.h>                  // For the peak RSS of child processes
+#include <sys/wait.h>                      // For waiting on child processes
+#include <unistd.h>                        // For fork()
+#include <GL/glew.h>                       // GLEW library for managing OpenGL extensions
+#include <GLFW/glfw3.h>                    // GLFW library for the benchmark window
+#include <glm/glm.hpp>                     // GLM library for handling matrices and vectors
+#include <glm/gtc/matrix_transform.hpp>    // GLM utilities for matrix transformations
+#include <glm/gtc/type_ptr.hpp>            // GLM utilities for converting matrices to pointer types
+#include "allocation_counter.h"            // Allocations per benchmark iteration
+#include "camera_script.h"                 // Input recording under test
+#include "draw_table.h"                    // Culling under test
+#include "frame_timing.h"                  // Frame time percentiles under test
+#include "frustum.h"                       // Culling under test
+#include "gl_context.h"                    // Hidden or headless benchmark context
+#include "geometry.h"                      // Vertex extraction under test
+#include "image_file.h"                    // Frame files of headless runs under test
+#include "mapped_file.h"                   // Token lists point into the mapped OBJ
+#include "mesh_cache.h"                    // Warm-start path under test
+#include "obj_loader.h"                    // tinyobj path under test
+#include "obj_parser.h"                    // Parallel parser under test
+#include "obj_tokens.h"                    // Number kernels under test
+#include "page_file.h"                     // Out-of-core paging under test
+#include "page_pool.h"                     // Page residency under test
+#include "picking.h"                       // BVH under test
+#include "scene_buffers.h"                 // Buffer upload and draw under test
+#include "shader_program.h"                // Scene shaders for the frame benchmark
+#include "simulation_clock.h"              // Fixed-timestep scheduling under test
+#include "software_renderer.h"             // CPU rasteriser under test
+#include "stream_buffer.h"                 // Transient per-frame uploads under test
+#include "synthetic_obj.h"                 // Meshes of increasing size
+#include "thread_pool.h"                   // Threads for the parallel parser
+#include "triple_buffer.h"                 // Render thread handoff under test
+#include "vertex_format.h"                 // Compact vertices under test
+#include "vertex_transform.h"              // Transform kernels under test
+
+namespace {
+
+// Samples and allocation counts of one benchmark
+struct BenchResult {
+    std::string name;
+    std::string unit = "ms";
+    std::vector<double> samples;           // One per iteration
+    double allocations = 0.0;              // Mean per iteration
+    double allocatedBytes = 0.0;           // Mean per iteration
+    std::string note;                      // Reason the benchmark was skipped, if it was
+};
+
+// Settings from the command line
+struct BenchOptions {
+    std::string objPath = "../contingo.obj";
+    std::string outPath;                   // JSON report, stdout when empty
+    unsigned iterations = 10;              // Iterations per benchmark
+    double maxSeconds = 5.0;               // Stop after this long once three iterations ran
+    unsigned frames = 200;                 // Frames for the frame benchmark
+    std::vector<unsigned> gridSizes = {64, 256, 1024};
+    unsigned rssMegabytes = 1024;          // Size of the synthetic OBJ for the peak RSS comparison, 0 skips it
+    bool skipGl = false;
+};
+
+// Run body until options.iterations samples were taken or maxSeconds passed (at least three samples)
+BenchResult measure(const std::string& name, const BenchOptions& options, const std::function<void()>& body) {
+    BenchResult result;
+    result.name = name;
+    uint64_t allocationsBefore = allocationCount, bytesBefore = allocationBytes;
+    auto start = std::chrono::steady_clock::now();
+    while (result.samples.size() < options.iterations) {
+        auto iterationStart = std::chrono::steady_clock::now();
+        body();
+        auto iterationEnd = std::chrono::steady_clock::now();
+        result.samples.push_back(std::chrono::duration<double, std::milli>(iterationEnd - iterationStart).count());
+        if (result.samples.size() >= 3 && std::chrono::duration<double>(iterationEnd - start).count() > options.maxSeconds)
+            break;
+    }
+    result.allocations = double(allocationCount - allocationsBefore) / result.samples.size();
+    result.allocatedBytes = double(allocationBytes - bytesBefore) / result.samples.size();
+    std::cerr << name << ": " << result.samples.size() << " iterations" << std::endl;
+    return result;
+}
+
+BenchResult skipped(const std::string& name, const std::string& reason) {
+    BenchResult result;
+    result.name = name;
+    result.note = reason;
+    std::cerr << name << ": skipped (" << reason << ")" << std::endl;
+    return result;
+}
+
+// Nearest-rank percentile of sorted samples
+double percentile(const std::vector<double>& sorted, double p) {
+    std::size_t rank = static_cast<std::size_t>(p / 100.0 * (sorted.size() - 1) + 0.5);
+    return sorted[std::min(rank, sorted.size() - 1)];
+}
+
+std::string toJson(const std::vector<BenchResult>& results) {
+    std::ostringstream json;
+    json << "{\n  \"benchmarks\": [\n";
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        const BenchResult& result = results[i];
+        json << "    {\"name\": \"" << result.name << "\", \"unit\": \"" << result.unit << "\"";
+        if (result.samples.empty()) {
+            json << ", \"skipped\": \"" << result.note << "\"}";
+        } else {
+            std::vector<double> sorted = result.samples;
+            std::sort(sorted.begin(), sorted.end());
+            double sum = 0.0;
+            for (double sample : sorted)
+                sum += sample;
+            json << ", \"iterations\": " << sorted.size() << ", \"mean\": " << sum / sorted.size()
+                 << ", \"min\": " << sorted.front() << ", \"p50\": " << percentile(sorted, 50)
+                 << ", \"p90\": " << percentile(sorted, 90) << ", \"p95\": " << percentile(sorted, 95)
+                 << ", \"p99\": " << percentile(sorted, 99) << ", \"max\": " << sorted.back()
+                 << ", \"allocations\": " << result.allocations << ", \"allocated_bytes\": " << result.allocatedBytes << "}";
+        }
+        json << (i + 1 < results.size() ? ",\n" : "\n");
+    }
+    json << "  ]\n}\n";
+    return json.str();
+}
+
+// Parser benchmarks on one OBJ: tinyobj, then the parallel parser at 1, 2, 4, ... threads
+void benchmarkLoading(const std::string& label, const std::string& path, const BenchOptions& options,
+                      std::vector<BenchResult>& results) {
+    results.push_back(measure("load/tinyobj/" + label, options, [&] {
+        Mesh mesh;
+        std::string message;
+        if (!loadObjWithTinyobj(path, mesh, message))
+            std::cerr << message << std::endl;
+    }));
+
+    unsigned maxThreads = std::max(1u, std::thread::hardware_concurrency());
+    for (unsigned threads = 1;; threads = std::min(threads * 2, maxThreads)) {
+        ThreadPool pool(threads);
+        results.push_back(measure("load/parallel/" + label + "/threads=" + std::to_string(threads), options, [&] {
+            Mesh mesh;
+            std::string message;
+            if (!parseObjParallel(path, pool, mesh, message))
+                std::cerr << message << std::endl;
+        }));
+        if (threads == maxThreads)
+            break;
+    }
+}
+
+// Run body in a forked child and return the child's peak resident set size in MiB, or a
+// negative value if the child failed. A fresh process per measurement keeps the high-water
+// marks of earlier loads out of the number.
+double peakRssOfChild(const std::function<bool()>& body) {
+    std::cout.flush();
+    pid_t child = fork();
+    if (child == 0)
+        _exit(body() ? 0 : 1);
+    if (child < 0)
+        return -1.0;
+    int status = 0;
+    struct rusage usage;
+    if (wait4(child, &status, 0, &usage) != child || !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+        return -1.0;
+#ifdef __APPLE__
+    return usage.ru_maxrss / (1024.0 * 1024.0); // Bytes on macOS
+#else
+    return usage.ru_maxrss / 1024.0;            // Kilobytes on Linux
+#endif
+}
+
+void addPeakRss(const std::string& name, const std::function<bool()>& body, std::vector<BenchResult>& results) {
+    double megabytes = peakRssOfChild(body);
+    if (megabytes < 0.0) {
+        results.push_back(skipped(name, "child process failed"));
+        return;
+    }
+    BenchResult result;
+    result.name = name;
+    result.unit = "MiB";
+    result.samples.push_back(megabytes);
+    std::cerr << name << ": " << megabytes << " MiB" << std::endl;
+    results.push_back(result);
+}
+
+// Peak RSS of turning an OBJ into upload-ready geometry with tinyobj, with the mapped parser and
+// with the out-of-core pager under a 64 MiB budget
+void benchmarkPeakRss(const std::string& label, const std::string& path, std::vector<BenchResult>& results) {
+    addPeakRss("rss/tinyobj/" + label, [&] {
+        Mesh mesh;
+        std::string message;
+        if (!loadObjWithTinyobj(path, mesh, message))
+            return false;
+        IndexedGeometry geometry = buildIndexedGeometry(mesh);
+        return !geometry.vertices.empty();
+    }, results);
+    addPeakRss("rss/parallel/" + label, [&] {
+        ThreadPool pool;
+        Mesh mesh;
+        std::string message;
+        if (!parseObjParallel(path, pool, mesh, message))
+            return false;
+        IndexedGeometry geometry = buildIndexedGeometry(mesh);
+        return !geometry.vertices.empty();
+    }, results);
+    addPeakRss("rss/paged-64mb/" + label, [&] {
+        PageFile pages;
+        std::string message;
+        return pages.create(0) && buildPageFile(path, std::size_t(64) << 20, pages, message);
+    }, results);
+}
+
+// Number tokens of an OBJ, pointing into its mapping
+struct ObjTokens {
+    std::vector<std::pair<const char*, const char*>> floats; // Every v/vn/vt coordinate
+    std::vector<std::pair<const char*, const char*>> faces;  // Every f record after the "f"
+    std::size_t floatBytes = 0;
+    std::size_t faceBytes = 0;
+};
+
+ObjTokens collectTokens(const MappedFile& file) {
+    ObjTokens tokens;
+    const char* end = file.data() + file.size();
+    for (const char* p = file.data(); p < end;) {
+        const char* lineEnd = findLineEnd(p, end);
+        if (lineEnd - p > 2 && p[0] == 'v' && (isObjSpace(p[1]) || isObjSpace(p[2]))) {
+            for (const char* q = p + 2; q < lineEnd;) {
+                while (q < lineEnd && isObjSpace(*q))
+                    ++q;
+                const char* begin = q;
+                while (q < lineEnd && !isObjSpace(*q))
+                    ++q;
+                if (q > begin) {
+                    tokens.floats.push_back({begin, q});
+                    tokens.floatBytes += static_cast<std::size_t>(q - begin);
+                }
+            }
+        } else if (lineEnd - p > 1 && p[0] == 'f' && isObjSpace(p[1])) {
+            tokens.faces.push_back({p + 1, lineEnd});
+            tokens.faceBytes += static_cast<std::size_t>(lineEnd - p - 1);
+        }
+        p = lineEnd + 1;
+    }
+    return tokens;
+}
+
+// Reference conversion every float kernel is held to
+bool parseWithStrtod(const char* begin, const char* end, float& value) {
+    std::string token(begin, end);
+    char* stop = nullptr;
+    double parsed = std::strtod(token.c_str(), &stop);
+    value = static_cast<float>(parsed);
+    return stop == token.c_str() + token.size();
+}
+
+// Turn the millisecond samples of a kernel that processed bytes per iteration into MB/s
+BenchResult throughput(BenchResult result, std::size_t bytes) {
+    for (double& sample : result.samples)
+        sample = bytes / (sample / 1000.0) / 1e6;
+    result.unit = "MB/s";
+    return result;
+}
+
+// Number kernel throughput on the records of one OBJ
+void benchmarkKernels(const std::string& label, const ObjTokens& tokens, const BenchOptions& options,
+                      std::vector<BenchResult>& results) {
+    volatile float floatSink = 0.0f;       // Keeps the parsed values alive
+    volatile int32_t intSink = 0;
+    results.push_back(throughput(measure("kernel/float/" + label, options, [&] {
+        float sum = 0.0f, value = 0.0f;
+        for (const auto& token : tokens.floats) {
+            const char* p = token.first;
+            parseObjFloat(p, token.second, value);
+            sum += value;
+        }
+        floatSink = sum;
+    }), tokens.floatBytes));
+    results.push_back(throughput(measure("kernel/float-strtod/" + label, options, [&] {
+        float sum = 0.0f, value = 0.0f;
+        for (const auto& token : tokens.floats) {
+            parseWithStrtod(token.first, token.second, value);
+            sum += value;
+        }
+        floatSink = sum;
+    }), tokens.floatBytes));
+    results.push_back(throughput(measure("kernel/face-ints/" + label, options, [&] {
+        int32_t sum = 0, value = 0;
+        for (const auto& face : tokens.faces) {
+            for (const char* p = face.first; p < face.second;) {
+                if (parseObjInt(p, face.second, value))
+                    sum += value;
+                else
+                    ++p; // Separator
+            }
+        }
+        intSink = sum;
+    }), tokens.faceBytes));
+    results.push_back(throughput(measure("kernel/face-corners/" + label, options, [&] {
+        int32_t sum = 0;
+        for (const auto& face : tokens.faces)
+            sum += static_cast<int32_t>(countTokens(face.first, face.second));
+        intSink = sum;
+    }), tokens.faceBytes));
+}
+
+// Check the float kernel against strtod on every coordinate of the OBJ, and the parallel parser's
+// mesh against tinyobj's: attribute arrays bit for bit, then face indices, per-triangle material
+// ids (both resolve usemtl through the same mtllib files) and shapes. Returns false and prints the
+// differences if anything differs.
+bool verifyParser(const std::string& path, const ObjTokens& tokens) {
+    bool passed = true;
+    std::size_t floatMismatches = 0;
+    for (const auto& token : tokens.floats) {
+        const char* p = token.first;
+        float fast = 0.0f, reference = 0.0f;
+        bool parsed = parseObjFloat(p, token.second, fast);
+        bool referenceParsed = parseWithStrtod(token.first, token.second, reference);
+        if (parsed != referenceParsed || (parsed && std::memcmp(&fast, &reference, sizeof(float)) != 0)) {
+            if (floatMismatches++ < 10)
+                std::cerr << "verify: \"" << std::string(token.first, token.second) << "\" parses to " << fast
+                          << ", strtod gives " << reference << std::endl;
+        }
+    }
+    std::cerr << "verify: " << tokens.floats.size() - floatMismatches << "/" << tokens.floats.size()
+              << " coordinates bit-identical to strtod" << std::endl;
+    passed = passed && floatMismatches == 0;
+
+    Mesh expected, actual;
+    std::string message;
+    ThreadPool pool;
+    if (!loadObjWithTinyobj(path, expected, message) || !parseObjParallel(path, pool, actual, message)) {
+        std::cerr << "verify: " << message << std::endl;
+        return false;
+    }
+    auto compare = [&](const char* what, bool equal) {
+        if (!equal)
+            std::cerr << "verify: " << what << " differ from tinyobj" << std::endl;
+        passed = passed && equal;
+    };
+    auto sameFloats = [](const std::vector<float>& a, const std::vector<float>& b) {
+        return a.size() == b.size() && (a.empty() || std::memcmp(a.data(), b.data(), a.size() * sizeof(float)) == 0);
+    };
+    compare("positions", sameFloats(expected.positions, actual.positions));
+    compare("normals", sameFloats(expected.normals, actual.normals));
+    compare("texcoords", sameFloats(expected.texcoords, actual.texcoords));
+    bool sameMaterials = expected.materialIds.size() == actual.materialIds.size();
+    for (std::size_t i = 0; sameMaterials && i < expected.materialIds.size(); ++i) {
+        sameMaterials = expected.materialIds[i] == actual.materialIds[i];
+        if (!sameMaterials)
+            std::cerr << "verify: triangle " << i << " has material " << actual.materialIds[i] << ", tinyobj gives "
+                      << expected.materialIds[i] << std::endl;
+    }
+    compare("material ids", sameMaterials);
+    bool sameIndices = expected.indices.size() == actual.indices.size();
+    for (std::size_t i = 0; sameIndices && i < expected.indices.size(); ++i) {
+        const MeshIndex& a = expected.indices[i];
+        const MeshIndex& b = actual.indices[i];
+        sameIndices = a.vertex == b.vertex && a.normal == b.normal && a.texcoord == b.texcoord;
+    }
+    compare("face indices", sameIndices);
+    bool sameShapes = expected.shapes.size() == actual.shapes.size();
+    for (std::size_t i = 0; sameShapes && i < expected.shapes.size(); ++i) {
+        const MeshShape& a = expected.shapes[i];
+        const MeshShape& b = actual.shapes[i];
+        sameShapes = a.name == b.name && a.firstIndex == b.firstIndex && a.indexCount == b.indexCount;
+    }
+    compare("shapes", sameShapes);
+    std::cerr << "verify: parallel parser " << (passed ? "matches" : "does not match") << " tinyobj on " << path
+              << " (positions, normals and texcoords bit for bit; face indices, material ids and shapes exactly)" << std::endl;
+    return passed;
+}
+
+// Turn per-iteration times of count queries into queries per second
+BenchResult queriesPerSecond(BenchResult result, std::size_t count) {
+    for (double& sample : result.samples)
+        sample = count / (sample / 1000.0);
+    result.unit = "queries/s";
+    return result;
+}
+
+// BVH build time and ray, segment and nearest-point query rates on one mesh. The first rays are
+// checked against testing every triangle; returns false if any closest hit differs.
+bool benchmarkBvh(const std::string& label, const Mesh& mesh, const BenchOptions& options, std::vector<BenchResult>& results) {
+    ThreadPool pool;
+    PickableMesh pickable;
+    results.push_back(measure("bvh/build/" + label, options, [&] {
+        buildPickableMesh(mesh, pool, pickable);
+    }));
+    const Bvh& bvh = pickable.bvh;
+
+    // Rays from random points around the model towards random points near its centre
+    glm::vec3 lowest(FLT_MAX), highest(-FLT_MAX);
+    for (std::size_t i = 0; i + 2 < mesh.positions.size(); i += 3) {
+        glm::vec3 p(mesh.positions[i], mesh.positions[i + 1], mesh.positions[i + 2]);
+        lowest = glm::min(lowest, p);
+        highest = glm::max(highest, p);
+    }
+    glm::vec3 centre = (lowest + highest) * 0.5f;
+    float size = glm::length(highest - lowest);
+    std::mt19937 random(7);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    auto around = [&](float scale) { return centre + glm::vec3(unit(random), unit(random), unit(random)) * (size * scale); };
+    const std::size_t queryCount = 100000;
+    std::vector<glm::vec3> origins(queryCount), targets(queryCount);
+    for (std::size_t i = 0; i < queryCount; ++i) {
+        origins[i] = around(1.0f);
+        targets[i] = around(0.2f);
+    }
+
+    std::size_t checked = std::min<std::size_t>(100, queryCount), wrong = 0;
+    for (std::size_t i = 0; i < checked; ++i) {
+        glm::vec3 direction = targets[i] - origins[i];
+        float best = FLT_MAX;
+        for (std::size_t t = 0; t + 2 < mesh.indices.size(); t += 3) {
+            glm::vec3 corners[3];
+            for (int k = 0; k < 3; ++k) {
+                const float* p = &mesh.positions[3 * std::size_t(mesh.indices[t + k].vertex)];
+                corners[k] = glm::vec3(p[0], p[1], p[2]);
+            }
+            // The same Moller-Trumbore arithmetic as the BVH leaves
+            glm::vec3 edge1 = corners[1] - corners[0], edge2 = corners[2] - corners[0];
+            glm::vec3 p = glm::cross(direction, edge2);
+            float determinant = glm::dot(edge1, p);
+            if (std::fabs(determinant) < 1e-20f)
+                continue;
+            float inverse = 1.0f / determinant;
+            glm::vec3 s = origins[i] - corners[0];
+            float u = glm::dot(s, p) * inverse;
+            glm::vec3 q = glm::cross(s, edge1);
+            float v = glm::dot(direction, q) * inverse;
+            float t0 = glm::dot(edge2, q) * inverse;
+            if (u >= 0.0f && u <= 1.0f && v >= 0.0f && u + v <= 1.0f && t0 >= 0.0f && t0 < best)
+                best = t0;
+        }
+        RayHit hit;
+        bool found = bvh.intersectRay(origins[i], direction, FLT_MAX, hit);
+        if (found != (best != FLT_MAX) || (found && hit.t != best))
+            ++wrong;
+    }
+    std::cerr << "verify: BVH on " << label << " (" << bvh.nodeCount() << " nodes, depth " << bvh.depth() << ") "
+              << (wrong == 0 ? "matches" : "does not match") << " brute force on " << checked << " rays" << std::endl;
+
+    std::size_t hits = 0;
+    results.push_back(queriesPerSecond(measure("bvh/ray/" + label, options, [&] {
+        for (std::size_t i = 0; i < queryCount; ++i) {
+            RayHit hit;
+            hits += bvh.intersectRay(origins[i], targets[i] - origins[i], FLT_MAX, hit) ? 1 : 0;
+        }
+    }), queryCount));
+    results.push_back(queriesPerSecond(measure("bvh/segment/" + label, options, [&] {
+        for (std::size_t i = 0; i < queryCount; ++i) {
+            RayHit hit;
+            hits += bvh.intersectSegment(origins[i], targets[i], hit) ? 1 : 0;
+        }
+    }), queryCount));
+    results.push_back(queriesPerSecond(measure("bvh/nearest/" + label, options, [&] {
+        for (std::size_t i = 0; i < queryCount; ++i) {
+            NearestHit hit;
+            hits += bvh.nearestPoint(targets[i], size, hit) ? 1 : 0;
+        }
+    }), queryCount));
+    volatile std::size_t sink = hits; // Keeps the queries from being optimised away
+    (void)sink;
+    return wrong == 0;
+}
+
+// Check on random views that culling never hides a shape with a vertex inside the clip volume, and
+// time culling the draw table of a grid of instances mostly off screen
+bool verifyCulling(const IndexedGeometry& geometry, const BenchOptions& options, std::vector<BenchResult>& results) {
+    std::mt19937 random(12345);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    uint64_t tests = 0, culled = 0, wrong = 0;
+    for (int view = 0; view < 200; ++view) {
+        glm::mat4 clip = glm::translate(glm::mat4(1.0f), glm::vec3(unit(random), unit(random), 0.5f * unit(random)));
+        clip = glm::rotate(clip, 3.14159f * unit(random), glm::normalize(glm::vec3(unit(random), unit(random), unit(random)) + 1e-3f));
+        clip = glm::scale(clip, glm::vec3(1.0f + 1.5f * unit(random)));
+        Frustum frustum = extractFrustum(clip);
+        for (const DrawShape& shape : geometry.shapes) {
+            bool visible = boundsVisible(frustum, shape.bounds);
+            bool inside = false;
+            for (uint32_t v = 0; v < shape.vertexCount && !inside; ++v) {
+                const float* position = geometry.vertices[shape.baseVertex + v].position;
+                glm::vec4 p = clip * glm::vec4(position[0], position[1], position[2], 1.0f);
+                inside = std::abs(p.x) <= p.w && std::abs(p.y) <= p.w && std::abs(p.z) <= p.w;
+            }
+            ++tests;
+            culled += visible ? 0 : 1;
+            wrong += !visible && inside ? 1 : 0;
+        }
+    }
+    std::cerr << "verify: culling hid " << culled << " of " << tests << " shapes over 200 random views, "
+              << wrong << " of them with a vertex in view" << std::endl;
+
+    Scene scene;
+    scene.instances = {{0, glm::mat4(1.0f)}};
+    repeatInstances(scene, 4096);
+    std::vector<std::vector<DrawShape>> meshShapes = {geometry.shapes};
+    DrawTable table; // Never created: rebuilding and culling without multi-draw touch no GL state
+    table.rebuild(meshShapes, scene.instances);
+    glm::mat4 zoomed = glm::scale(glm::mat4(1.0f), glm::vec3(8.0f));
+    results.push_back(measure("cull/contingo-x4096", options, [&] {
+        table.cull(meshShapes, zoomed);
+    }));
+    return wrong == 0;
+}
+
+// Build every level of detail of contingo, timed, and measure how far each level strays from the
+// full-detail surface: the largest distance of any original vertex to the simplified triangles,
+// next to the simplifier's own error estimate. Returns false if a level indexes outside its shape.
+bool verifyLods(const Mesh& mesh, const BenchOptions& options, std::vector<BenchResult>& results) {
+    IndexedGeometry geometry;
+    results.push_back(measure("lod/build/contingo", options, [&] {
+        geometry = buildIndexedGeometry(mesh, maxLodLevels);
+    }));
+    GeometryStats stats = measureGeometry(geometry);
+
+    std::vector<float> positions;
+    positions.reserve(3 * geometry.vertices.size());
+    for (const Vertex& vertex : geometry.vertices)
+        positions.insert(positions.end(), vertex.position, vertex.position + 3);
+    bool valid = true;
+    ThreadPool pool;
+    for (unsigned level = 1; level <= maxLodLevels; ++level) {
+        // Shapes without this level contribute their coarsest one
+        std::vector<uint32_t> corners;
+        for (const DrawShape& shape : geometry.shapes) {
+            uint32_t drawn = std::min(level, shape.lodCount);
+            uint32_t first = drawn == 0 ? 0 : shape.lods[drawn - 1].firstIndex;
+            uint32_t count = drawn == 0 ? shape.indexCount : shape.lods[drawn - 1].indexCount;
+            for (uint32_t i = first; i < first + count; ++i) {
+                uint32_t index = shapeIndex(geometry, shape, i);
+                valid = valid && index < shape.vertexCount;
+                corners.push_back(shape.baseVertex + index);
+            }
+        }
+        Bvh bvh;
+        bvh.build(positions.data(), corners.data(), corners.size() / 3, pool);
+        float deviation = 0.0f;
+        for (const Vertex& vertex : geometry.vertices) {
+            NearestHit hit;
+            if (bvh.nearestPoint(glm::vec3(vertex.position[0], vertex.position[1], vertex.position[2]), FLT_MAX, hit))
+                deviation = std::max(deviation, std::sqrt(hit.distanceSquared));
+        }
+        std::cerr << "verify: LOD" << level << " of contingo has " << stats.lodTriangles[level] << " of "
+                  << stats.lodTriangles[0] << " triangles, quadric error " << stats.lodError[level]
+                  << ", largest vertex distance " << deviation << std::endl;
+    }
+    if (!valid)
+        std::cerr << "verify: a level of detail indexes outside its shape" << std::endl;
+    return valid;
+}
+
+// Triangles of one shape as sorted vertex triples, each rotated to start at its smallest vertex so
+// the comparison ignores triangle order and vertex numbering but not winding
+std::vector<std::vector<float>> canonicalTriangles(const IndexedGeometry& geometry, const DrawShape& shape) {
+    std::vector<std::vector<float>> triangles;
+    for (uint32_t i = 0; i + 3 <= shape.indexCount; i += 3) {
+        const float* corners[3];
+        for (int k = 0; k < 3; ++k)
+            corners[k] = &geometry.vertices[shape.baseVertex + shapeIndex(geometry, shape, i + k)].position[0];
+        int first = 0;
+        for (int k = 1; k < 3; ++k) {
+            if (std::lexicographical_compare(corners[k], corners[k] + 8, corners[first], corners[first] + 8))
+                first = k;
+        }
+        std::vector<float> triangle;
+        for (int k = 0; k < 3; ++k)
+            triangle.insert(triangle.end(), corners[(first + k) % 3], corners[(first + k) % 3] + 8);
+        triangles.push_back(std::move(triangle));
+    }
+    std::sort(triangles.begin(), triangles.end());
+    return triangles;
+}
+
+// Time the indexed build with the vertex cache and fetch optimisation, print every shape's ACMR and
+// ATVR before and after, and check the optimised shapes draw the same triangles
+bool verifyOptimizer(const Mesh& mesh, const BenchOptions& options, std::vector<BenchResult>& results) {
+    IndexedGeometry optimized;
+    results.push_back(measure("optimize/contingo", options, [&] {
+        optimized = buildIndexedGeometry(mesh, 0, true);
+    }));
+    IndexedGeometry plain = buildIndexedGeometry(mesh);
+    bool same = plain.shapes.size() == optimized.shapes.size();
+    for (std::size_t s = 0; same && s < plain.shapes.size(); ++s)
+        same = canonicalTriangles(plain, plain.shapes[s]) == canonicalTriangles(optimized, optimized.shapes[s]);
+    GeometryStats stats = measureGeometry(optimized);
+    for (const ShapeCacheStats& shape : stats.shapeCache) {
+        std::cerr << "verify: " << shape.name << " ACMR " << shape.acmr(shape.missesBefore) << " -> "
+                  << shape.acmr(shape.missesAfter) << ", ATVR " << shape.atvr(shape.missesBefore) << " -> "
+                  << shape.atvr(shape.missesAfter) << std::endl;
+    }
+    if (!same)
+        std::cerr << "verify: the optimised shapes draw different triangles" << std::endl;
+    return same;
+}
+
+// Check the compact vertex encoding of contingo against the vertices built from the OBJ, time the
+// encoding, and report the VBO plus EBO bytes of every format
+bool verifyVertexFormats(const Mesh& mesh, const BenchOptions& options, std::vector<BenchResult>& results) {
+    IndexedGeometry geometry = buildIndexedGeometry(mesh, maxLodLevels, true);
+    QuantizationError error = measureQuantizationError(geometry);
+    std::cerr << "verify: compact vertices of contingo are off by at most " << error.position << " ("
+              << error.positionSteps << " 16-bit steps) in position, " << error.normalDegrees << " degrees in normal, "
+              << error.texcoord << " in texture coordinate" << (error.withinBounds ? "" : ", outside the format's bounds")
+              << std::endl;
+
+    std::vector<uint8_t> encoded;
+    results.push_back(measure("encode/compact/contingo", options, [&] {
+        encodeGeometry(VertexFormat::Compact, geometry, encoded);
+    }));
+    for (VertexFormat format : {VertexFormat::Float, VertexFormat::Compact}) {
+        BenchResult result;
+        result.name = std::string("memory/") + vertexFormatName(format) + "/contingo";
+        result.unit = "bytes";
+        result.samples.push_back(double(geometry.vertices.size() * vertexStride(format) + geometry.indexData.size()));
+        std::cerr << result.name << ": " << result.samples[0] << " bytes" << std::endl;
+        results.push_back(result);
+    }
+    return error.withinBounds;
+}
+
+// Time the meshlet build, check every meshlet's limits and that the meshlets cover their shape's
+// triangles, then check on random views that no meshlet culled for lying outside the frustum has a
+// vertex in the clip volume and none culled for facing away has a front-facing triangle. Finally
+// time culling the meshlets of a grid of instances on a thread pool.
+bool verifyMeshlets(const Mesh& mesh, const BenchOptions& options, std::vector<BenchResult>& results) {
+    IndexedGeometry geometry;
+    results.push_back(measure("meshlets/build/contingo", options, [&] {
+        geometry = buildIndexedGeometry(mesh, 0, true, true);
+    }));
+    IndexedGeometry plain = buildIndexedGeometry(mesh, 0, true);
+    bool valid = plain.shapes.size() == geometry.shapes.size();
+    for (std::size_t s = 0; valid && s < geometry.shapes.size(); ++s) {
+        const DrawShape& shape = geometry.shapes[s];
+        valid = canonicalTriangles(plain, plain.shapes[s]) == canonicalTriangles(geometry, shape);
+        uint32_t next = 0;
+        for (const Meshlet& meshlet : shape.meshlets) {
+            std::vector<uint32_t> vertices;
+            for (uint32_t i = 0; i < meshlet.indexCount; ++i)
+                vertices.push_back(shapeIndex(geometry, shape, meshlet.firstIndex + i));
+            std::sort(vertices.begin(), vertices.end());
+            std::size_t unique = std::unique(vertices.begin(), vertices.end()) - vertices.begin();
+            valid = valid && meshlet.firstIndex == next && meshlet.indexCount % 3 == 0 && unique <= maxMeshletVertices &&
+                    meshlet.indexCount <= 3 * maxMeshletTriangles;
+            next += meshlet.indexCount;
+        }
+        valid = valid && next == shape.indexCount;
+    }
+    GeometryStats stats = measureGeometry(geometry);
+    std::cerr << "verify: contingo has " << stats.meshlets << " meshlets, " << double(stats.meshletTriangles) / stats.meshlets
+              << " triangles each on average" << (valid ? "" : ", some over the limits or not covering their shape") << std::endl;
+
+    // Half the views are affine like the viewer's, the other half perspective from around the model, some mirrored
+    std::mt19937 random(54321);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    uint64_t tests = 0, frustumCulled = 0, backfaceCulled = 0, wrong = 0;
+    for (int view = 0; view < 200; ++view) {
+        glm::mat4 clip;
+        glm::vec3 axis = glm::normalize(glm::vec3(unit(random), unit(random), unit(random)) + 1e-3f);
+        if (view % 2 == 0) {
+            clip = glm::translate(glm::mat4(1.0f), glm::vec3(unit(random), unit(random), 0.5f * unit(random)));
+            clip = glm::rotate(clip, 3.14159f * unit(random), axis);
+            clip = glm::scale(clip, glm::vec3(1.0f + 1.5f * unit(random)));
+        } else {
+            glm::vec3 eye = axis * (1.2f + unit(random));
+            clip = glm::perspective(glm::radians(60.0f), 1.0f, 0.05f, 10.0f) *
+                   glm::lookAt(eye, glm::vec3(0.3f * unit(random), 0.3f * unit(random), 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+        }
+        if (view % 3 == 0)
+            clip = glm::scale(clip, glm::vec3(-1.0f, 1.0f, 1.0f));
+        Frustum frustum = extractFrustum(clip);
+        Viewer viewer = extractViewer(clip);
+        for (const DrawShape& shape : geometry.shapes) {
+            for (const Meshlet& meshlet : shape.meshlets) {
+                ++tests;
+                bool outside = !sphereVisible(frustum, meshlet.center, meshlet.radius);
+                bool away = !outside && meshletFacingAway(viewer, meshlet);
+                frustumCulled += outside ? 1 : 0;
+                backfaceCulled += away ? 1 : 0;
+                if (!outside && !away)
+                    continue;
+                for (uint32_t i = meshlet.firstIndex; i < meshlet.firstIndex + meshlet.indexCount; i += 3) {
+                    glm::vec4 corners[3];
+                    for (int k = 0; k < 3; ++k) {
+                        const float* position = geometry.vertices[shape.baseVertex + shapeIndex(geometry, shape, i + k)].position;
+                        corners[k] = clip * glm::vec4(position[0], position[1], position[2], 1.0f);
+                    }
+                    bool bad = false;
+                    if (outside) {
+                        for (const glm::vec4& p : corners)
+                            bad = bad || (std::abs(p.x) <= p.w && std::abs(p.y) <= p.w && std::abs(p.z) <= p.w);
+                    } else {
+                        // Window-space winding of the (clipped) triangle is the sign of det(xyw of the corners)
+                        glm::vec3 a(corners[0].x, corners[0].y, corners[0].w);
+                        glm::vec3 b(corners[1].x, corners[1].y, corners[1].w);
+                        glm::vec3 c(corners[2].x, corners[2].y, corners[2].w);
+                        float winding = glm::dot(a, glm::cross(b, c));
+                        bad = winding > 1e-6f * glm::length(a) * glm::length(b) * glm::length(c);
+                    }
+                    if (bad) {
+                        ++wrong;
+                        break;
+                    }
+                }
+            }
+        }
+    }
+    std::cerr << "verify: over 200 random views " << frustumCulled << " of " << tests << " meshlets were outside the view and "
+              << backfaceCulled << " facing away, " << wrong << " of them wrongly" << std::endl;
+
+    Scene scene;
+    scene.instances = {{0, glm::mat4(1.0f)}};
+    repeatInstances(scene, 64);
+    std::vector<std::vector<DrawShape>> meshShapes = {geometry.shapes};
+    DrawTable table; // Never created: culling touches no GL state
+    table.rebuild(meshShapes, scene.instances);
+    ThreadPool pool;
+    glm::mat4 zoomed = glm::rotate(glm::scale(glm::mat4(1.0f), glm::vec3(2.0f)), 0.5f, glm::vec3(0.0f, 1.0f, 0.0f));
+    results.push_back(measure("cull-clusters/contingo-x64", options, [&] {
+        table.cull(meshShapes, zoomed);
+        table.cullClusters(meshShapes, zoomed, true, pool);
+    }));
+    return valid && wrong == 0;
+}
+
+// Check every transform kernel the CPU runs against the scalar one, bit for bit in position and
+// outcode, on 64 copies of contingo's vertices plus a few so the vector loops leave a tail, under a
+// zoomed view that puts some of them outside. Then time each kernel and a glm::vec4 loop over the
+// same vertices and report vertices per second.
+bool benchmarkTransform(const Mesh& mesh, const BenchOptions& options, std::vector<BenchResult>& results) {
+    IndexedGeometry geometry = buildIndexedGeometry(mesh);
+    std::vector<glm::vec4> positions;
+    for (int copy = 0; copy < 64; ++copy)
+        for (const Vertex& vertex : geometry.vertices)
+            positions.push_back(glm::vec4(vertex.position[0], vertex.position[1], vertex.position[2], 1.0f));
+    positions.resize(positions.size() + 7, glm::vec4(3.0f, -1.0f, 0.5f, 1.0f));
+    std::size_t count = positions.size();
+    std::vector<float> x(count), y(count), z(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        x[i] = positions[i].x;
+        y[i] = positions[i].y;
+        z[i] = positions[i].z;
+    }
+    glm::mat4 zoomed = glm::rotate(glm::scale(glm::mat4(1.0f), glm::vec3(2.0f)), 0.5f, glm::vec3(0.0f, 1.0f, 0.0f));
+
+    auto report = [&](const BenchResult& result) {
+        double meanMillis = 0.0;
+        for (double sample : result.samples)
+            meanMillis += sample / result.samples.size();
+        std::cerr << result.name << ": " << count / meanMillis / 1000.0 << " Mvertices/s" << std::endl;
+    };
+    std::vector<glm::vec4> transformed(count);
+    BenchResult loop = measure("transform/glm", options, [&] {
+        for (std::size_t i = 0; i < count; ++i)
+            transformed[i] = zoomed * positions[i];
+    });
+    report(loop);
+    results.push_back(loop);
+
+    std::vector<float> expected[4], clip[4];
+    for (int axis = 0; axis < 4; ++axis) {
+        expected[axis].resize(count);
+        clip[axis].resize(count);
+    }
+    std::vector<uint8_t> expectedOutcodes(count), outcodes(count);
+    ClipSummary expectedSummary = transformPositions(zoomed, {x.data(), y.data(), z.data()}, count,
+                                                     {expected[0].data(), expected[1].data(), expected[2].data(), expected[3].data()},
+                                                     expectedOutcodes.data(), TransformKernel::Scalar);
+    bool valid = expectedSummary.anyOutside != 0 && expectedSummary.allOutside == 0;
+    for (TransformKernel kernel : {TransformKernel::Scalar, TransformKernel::SSE2, TransformKernel::AVX2,
+                                   TransformKernel::AVX512, TransformKernel::NEON}) {
+        std::string name = std::string("transform/") + transformKernelName(kernel);
+        if (!transformKernelSupported(kernel)) {
+            results.push_back(skipped(name, "not supported on this CPU"));
+            continue;
+        }
+        ClipArrays arrays = {clip[0].data(), clip[1].data(), clip[2].data(), clip[3].data()};
+        ClipSummary summary;
+        BenchResult result = measure(name, options, [&] {
+            summary = transformPositions(zoomed, {x.data(), y.data(), z.data()}, count, arrays, outcodes.data(), kernel);
+        });
+        bool same = summary.allOutside == expectedSummary.allOutside && summary.anyOutside == expectedSummary.anyOutside &&
+                    outcodes == expectedOutcodes;
+        for (int axis = 0; axis < 4; ++axis)
+            same = same && std::memcmp(clip[axis].data(), expected[axis].data(), count * sizeof(float)) == 0;
+        if (!same)
+            std::cerr << "verify: the " << transformKernelName(kernel) << " transform differs from the scalar one" << std::endl;
+        valid = same && valid;
+        report(result);
+        results.push_back(result);
+    }
+    return valid;
+}
+
+// Check the software renderer on two triangles: the pixels one covers match its area and the nearer
+// one is seen where they overlap, whatever the submission order. Then check that contingo renders the
+// same image on one thread as on all of them, and time 800x800 frames of a grid of 64 contingos,
+// filled and as a wireframe, against the thread count.
+bool benchmarkSoftware(const Mesh& mesh, const BenchOptions& options, std::vector<BenchResult>& results) {
+    // A flat triangle at depth 0.5 and a tilted one in front of it, as meshes 0 and 1
+    const float corners[2][3][3] = {{{-0.8f, -0.8f, 0.5f}, {0.8f, -0.8f, 0.5f}, {0.0f, 0.8f, 0.5f}},
+                                    {{-0.4f, -0.4f, -0.6f}, {0.4f, -0.4f, -0.4f}, {0.0f, 0.4f, -0.5f}}};
+    SoftwareRenderer renderer;
+    renderer.resize(800, 800);
+    for (uint32_t meshId = 0; meshId < 2; ++meshId) {
+        IndexedGeometry triangle;
+        for (const auto& corner : corners[meshId])
+            triangle.vertices.push_back({{corner[0], corner[1], corner[2]}, {0.0f, 0.0f, 1.0f}, {0.0f, 0.0f}});
+        uint32_t indices[3] = {0, 1, 2};
+        triangle.indexData.resize(sizeof(indices));
+        std::memcpy(triangle.indexData.data(), indices, sizeof(indices));
+        DrawShape shape = {};
+        shape.meshId = meshId;
+        shape.vertexCount = 3;
+        shape.indexCount = 3;
+        shape.indexSize = 4;
+        shape.bounds = computeBounds(triangle.vertices.data(), 3);
+        triangle.shapes.push_back(shape);
+        renderer.addShapes(triangle);
+    }
+    ThreadPool pool;
+    auto pixelAt = [&](int x, int y) { return renderer.pixels()[3 * (std::size_t(y) * 800 + x)]; };
+    renderer.render({{0, glm::mat4(1.0f)}}, glm::mat4(1.0f), false, true, false, pool);
+    std::size_t covered = 0;
+    for (std::size_t i = 0; i < renderer.pixels().size(); i += 3)
+        covered += renderer.pixels()[i] != 51;
+    double area = 0.5 * (1.6 * 400.0) * (1.6 * 400.0);
+    bool valid = std::abs(double(covered) - area) < 0.01 * area;
+    uint8_t far = pixelAt(400, 400);
+    bool depthValid = true;
+    for (uint32_t front : {0u, 1u}) {      // The tilted triangle drawn first, then last
+        renderer.render({{front, glm::mat4(1.0f)}, {1 - front, glm::mat4(1.0f)}}, glm::mat4(1.0f), false, true, false, pool);
+        uint8_t near = pixelAt(400, 400);
+        depthValid = depthValid && near != far && near != 51 && pixelAt(400, 120) == far;
+    }
+    std::cerr << "verify: software triangle covers " << covered << " pixels of " << area << ", depth test "
+              << (depthValid ? "ok" : "wrong") << std::endl;
+    valid = valid && depthValid;
+
+    // Contingo on one thread and on all of them
+    IndexedGeometry geometry = buildIndexedGeometry(mesh);
+    SoftwareRenderer contingo;
+    contingo.resize(800, 800);
+    contingo.addShapes(geometry);
+    glm::mat4 view = glm::rotate(glm::scale(glm::mat4(1.0f), glm::vec3(0.5f)), 0.5f, glm::vec3(0.0f, 1.0f, 0.0f));
+    std::vector<ModelInstance> single = {{0, glm::mat4(1.0f)}};
+    ThreadPool one(1);
+    for (bool wireframe : {true, false}) {
+        contingo.render(single, view, wireframe, true, false, one);
+        std::vector<uint8_t> expected = contingo.pixels();
+        contingo.render(single, view, wireframe, true, false, pool);
+        if (contingo.pixels() != expected) {
+            std::cerr << "verify: the software " << (wireframe ? "wireframe" : "fill") << " differs between thread counts" << std::endl;
+            valid = false;
+        }
+    }
+
+    // Frames per second against threads, rotating a degree per frame
+    Scene grid;
+    grid.instances = single;
+    repeatInstances(grid, 64);
+    std::vector<unsigned> threadCounts;
+    for (unsigned threads = 1; threads < pool.size(); threads *= 2)
+        threadCounts.push_back(threads);
+    threadCounts.push_back(pool.size());
+    for (unsigned threads : threadCounts) {
+        ThreadPool workers(threads);
+        for (bool wireframe : {false, true}) {
+            std::string name = std::string("software/contingo-x64-") + (wireframe ? "wire-" : "fill-") + std::to_string(threads) + "t";
+            glm::mat4 transform = glm::scale(glm::mat4(1.0f), glm::vec3(0.5f));
+            SoftwareStats frames;
+            BenchResult result = measure(name, options, [&] {
+                transform = glm::rotate(transform, glm::radians(1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+                frames += contingo.render(grid.instances, transform, wireframe, true, false, workers);
+            });
+            double meanMillis = 0.0;
+            for (double sample : result.samples)
+                meanMillis += sample / result.samples.size();
+            std::cerr << name << ": " << 1000.0 / meanMillis << " frames/s (vertex " << frames.vertexMillis / frames.frames
+                      << " ms, binning " << frames.binMillis / frames.frames << " ms, raster " << frames.rasterMillis / frames.frames
+                      << " ms per frame)" << std::endl;
+            results.push_back(result);
+        }
+    }
+    return valid;
+}
+
+// Check the rolling frame time histogram against exact percentiles of the last window of a
+// long-tailed run of durations, and time adding a million of them
+bool verifyFrameHistogram(const BenchOptions& options, std::vector<BenchResult>& results) {
+    std::mt19937 random(7);
+    std::lognormal_distribution<double> millis(1.0, 0.8);
+    std::vector<double> durations(5 * frameTimingWindow);
+    for (double& duration : durations)
+        duration = millis(random);
+    RollingHistogram histogram;
+    for (double duration : durations)
+        histogram.add(duration);
+    std::vector<double> window(durations.end() - frameTimingWindow, durations.end());
+    std::sort(window.begin(), window.end());
+    bool valid = histogram.count() == frameTimingWindow;
+    for (double fraction : {0.5, 0.95, 0.99}) {
+        double exact = window[static_cast<std::size_t>(std::ceil(fraction * window.size())) - 1];
+        double estimate = histogram.percentile(fraction);
+        if (std::abs(estimate - exact) > 0.1 * exact) {
+            std::cerr << "verify: histogram percentile " << fraction << " is " << estimate << " ms, not " << exact << std::endl;
+            valid = false;
+        }
+    }
+    results.push_back(measure("timing/histogram-add-1M", options, [&] {
+        for (std::size_t i = 0; i < 1000000; ++i)
+            histogram.add(durations[i % durations.size()]);
+    }));
+    return valid;
+}
+
+// Replay a script on virtual clocks at several frame rates and check that each runs through the
+// script's ticks, reaching the same transform, and draws it unblended on its last frame; then check
+// that turning and scaling, or moving, go as far in a second at 30 ticks per second as at 240
+bool verifySimulationClock() {
+    std::vector<ScriptStep> script = {{"QF", 200}, {"", 7}, {"WD", 50}};
+    bool valid = true;
+    glm::mat4 expected(1.0f);
+    for (unsigned frameRate : {0u, 24u, 60u, 144u, 1000u}) {
+        SimulationClock clock(60, frameRate, false);
+        glm::mat4 previous(1.0f), current(1.0f), drawn(1.0f);
+        for (unsigned frame = clock.framesFor(scriptLength(script)); frame > 0; --frame) {
+            unsigned ticks = clock.advance();
+            for (uint64_t tick = clock.ticks() - ticks; tick < clock.ticks(); ++tick) {
+                previous = current;
+                applyKeys(scriptKeys(script, tick), clock.tickSeconds(), current);
+            }
+            drawn = interpolateTransform(previous, current, clock.alpha());
+        }
+        if (frameRate == 0)
+            expected = current;
+        if (clock.ticks() < scriptLength(script) || std::memcmp(&current, &expected, sizeof(glm::mat4)) != 0 ||
+            std::memcmp(&drawn, &current, sizeof(glm::mat4)) != 0) {
+            std::cerr << "verify: the script replays differently at " << frameRate << " frames/s" << std::endl;
+            valid = false;
+        }
+    }
+    // Keys whose moves commute, so only rounding separates the two rates
+    for (const char* keys : {"QR", "WD"}) {
+        glm::mat4 second[2] = {glm::mat4(1.0f), glm::mat4(1.0f)};
+        for (int rate = 0; rate < 2; ++rate) {
+            unsigned ticksPerSecond = rate == 0 ? 30 : 240;
+            for (unsigned tick = 0; tick < ticksPerSecond; ++tick)
+                applyKeys(keys, 1.0 / ticksPerSecond, second[rate]);
+        }
+        for (int column = 0; column < 4; ++column) {
+            for (int row = 0; row < 4; ++row) {
+                float a = second[0][column][row], b = second[1][column][row];
+                if (std::abs(a - b) > 1e-4f * std::max(1.0f, std::abs(a))) {
+                    std::cerr << "verify: " << keys << " moves differently at 30 and 240 ticks per second" << std::endl;
+                    valid = false;
+                }
+            }
+        }
+    }
+    return valid;
+}
+
+// Publish numbered snapshots from one thread while another reads them through a triple buffer,
+// checking that the reader never sees a torn snapshot or an older one than it already saw and that
+// it ends on the last; then time a million publishes against a reader that keeps taking them
+bool verifyTripleBuffer(const BenchOptions& options, std::vector<BenchResult>& results) {
+    struct Snapshot {
+        uint64_t words[32] = {};           // All equal to the snapshot's number
+    };
+    auto handOff = [](uint64_t count) {
+        TripleBuffer<Snapshot> buffer;
+        std::thread writer([&] {
+            for (uint64_t number = 1; number <= count; ++number) {
+                Snapshot& snapshot = buffer.back();
+                for (uint64_t& word : snapshot.words)
+                    word = number;
+                buffer.publish();
+            }
+        });
+        bool valid = true;
+        uint64_t last = 0;
+        while (last < count && valid) {
+            if (!buffer.acquire())
+                continue;
+            const Snapshot& snapshot = buffer.front();
+            uint64_t number = snapshot.words[0];
+            for (uint64_t word : snapshot.words)
+                valid = valid && word == number;
+            valid = valid && number > last;
+            last = number;
+        }
+        writer.join();
+        return valid;
+    };
+    bool valid = handOff(200000);
+    if (!valid)
+        std::cerr << "verify: the triple buffer handed over a torn or stale snapshot" << std::endl;
+    results.push_back(measure("snapshot/triple-buffer-1M", options, [&] { valid = handOff(1000000) && valid; }));
+    return valid;
+}
+
+// Record a thousand ticks of random keys, held for random runs as a person would, save and reload
+// the recording, and check that replaying it holds the same keys every tick and moves the
+// transform to exactly the same matrix
+bool verifyInputRecording(const std::filesystem::path& directory) {
+    std::mt19937 random(11);
+    std::vector<ScriptStep> recording;
+    std::vector<std::string> held;
+    glm::mat4 recorded(1.0f);
+    while (held.size() < 1000) {
+        std::string keys;
+        for (char key : std::string("WSADQERF")) {
+            if (random() % 4 == 0)
+                keys += key;
+        }
+        for (unsigned ticks = 1 + random() % 30; ticks > 0; --ticks) {
+            recordKeys(recording, keys);
+            applyKeys(keys, 1.0 / 60, recorded);
+            held.push_back(keys);
+        }
+    }
+    std::string path = (directory / "a3_bench_input.script").string();
+    std::vector<ScriptStep> replay;
+    std::string message;
+    if (!saveCameraScript(path, recording, message) || !loadCameraScript(path, replay, message)) {
+        std::cerr << "verify: " << message << std::endl;
+        return false;
+    }
+    bool valid = scriptLength(replay) == held.size();
+    glm::mat4 replayed(1.0f);
+    for (unsigned tick = 0; valid && tick < held.size(); ++tick) {
+        std::string keys = scriptKeys(replay, tick);
+        valid = keys == held[tick];
+        applyKeys(keys, 1.0 / 60, replayed);
+    }
+    valid = valid && std::memcmp(&recorded, &replayed, sizeof(glm::mat4)) == 0;
+    std::error_code error;
+    std::cerr << "verify: " << held.size() << " ticks of input recorded in " << recording.size() << " steps, "
+              << std::filesystem::file_size(path, error) << " bytes" << (valid ? "" : ", replayed differently") << std::endl;
+    std::remove(path.c_str());
+    return valid;
+}
+
+// Write an 800x800 frame as PPM and PNG, check that the PPM reads back unchanged and that the PNG
+// has the size of its stored blocks, and time writing each format
+bool verifyImageFiles(const std::filesystem::path& directory, const BenchOptions& options, std::vector<BenchResult>& results) {
+    const int size = 800;
+    std::vector<uint8_t> rgb(3 * size * size);
+    for (std::size_t i = 0; i < rgb.size(); ++i)
+        rgb[i] = static_cast<uint8_t>((i * 7) ^ (i / 2400));
+    bool valid = true;
+    for (const char* format : {"ppm", "png"}) {
+        std::string path = (directory / (std::string("a3_bench_frame.") + format)).string();
+        results.push_back(measure(std::string("image/") + format + "-800", options, [&] {
+            valid = writeImage(path, size, size, rgb.data()) && valid;
+        }));
+        if (std::string(format) == "ppm") {
+            int width = 0, height = 0;
+            std::vector<uint8_t> read;
+            valid = readPpm(path, width, height, read) && width == size && height == size && read == rgb && valid;
+        } else {
+            // Signature, IHDR, one IDAT of zlib header, stored blocks of 5 header bytes and Adler-32, IEND
+            std::size_t raw = std::size_t(size) * (3 * size + 1);
+            std::size_t blocks = (raw + 65534) / 65535;
+            std::size_t expected = 8 + 25 + 12 + 2 + raw + 5 * blocks + 4 + 12;
+            std::error_code error;
+            valid = std::filesystem::file_size(path, error) == expected && valid;
+        }
+        std::remove(path.c_str());
+    }
+    if (!valid)
+        std::cerr << "verify: frame images do not round trip" << std::endl;
+    return valid;
+}
+
+// Upload and frame benchmarks in a hidden window, or a headless context when there is no display;
+// skipped when no GL context can be created
+const char* const glBenchmarks[] = {"upload/contingo", "upload/contingo-compact", "stream/1mib-persistent", "stream/1mib-orphan",
+                                    "frame/contingo", "frame/contingo-compact",
+                                    "frame/contingo-x64-mdi", "frame/contingo-x64-mdi-compact", "frame/contingo-x64-loop",
+                                    "frame/contingo-x64-zoom-cull", "frame/contingo-x64-zoom-nocull", "frame/contingo-x64-lod0",
+                                    "frame/contingo-x64-lod1", "frame/contingo-x64-lod2", "frame/contingo-x64-lod3",
+                                    "frame/contingo-x64-lod4", "frame/contingo-x64-lod-auto"};
+
+// Page a synthetic grid into a pool holding half its pages, then sweep a zoomed-in view across the
+// grid seen from above and check that every page is made resident while it is in view; needs a
+// current GL context
+bool verifyPageResidency(const std::filesystem::path& directory) {
+    std::string path = (directory / "a3_bench_paging.obj").string();
+    std::vector<std::unique_ptr<PageFile>> files;
+    files.push_back(std::make_unique<PageFile>());
+    PageFile& pages = *files[0];
+    std::string message;
+    bool built = writeSyntheticObj(path, 512) && pages.create(0) && buildPageFile(path, std::size_t(64) << 20, pages, message);
+    std::remove(path.c_str());
+    if (!built || pages.pageCount() < 4) {
+        std::cerr << "verify: cannot page the synthetic grid " << message << std::endl;
+        return false;
+    }
+    std::vector<ModelInstance> instances = {{0, glm::mat4(1.0f)}};
+
+    // The grid spans -1 to 1 in x and z; each view covers an eighth of it on a side
+    PagePool pool;
+    std::size_t slotBytes = std::size_t(pageMaxVertices) * sizeof(Vertex) + 3 * std::size_t(pageMaxTriangles) * sizeof(uint16_t);
+    pool.create(pages.pageCount() / 2 * slotBytes);
+    glm::mat4 topDown = glm::rotate(glm::mat4(1.0f), glm::radians(90.0f), glm::vec3(1.0f, 0.0f, 0.0f));
+    std::vector<bool> seen(pages.pageCount(), false);
+    for (int row = 0; row < 8; ++row) {
+        for (int column = 0; column < 8; ++column) {
+            glm::mat4 view = glm::scale(glm::mat4(1.0f), glm::vec3(8.0f, 8.0f, 1.0f));
+            view = glm::translate(view, glm::vec3(1.0f - (column + 0.5f) / 4.0f, 1.0f - (row + 0.5f) / 4.0f, 0.0f)) * topDown;
+            pool.update(files, instances, view, SIZE_MAX);
+            for (std::size_t p = 0; p < seen.size(); ++p)
+                seen[p] = seen[p] || pool.pageResident(0, p);
+        }
+    }
+    bool valid = std::count(seen.begin(), seen.end(), false) == 0;
+    if (!valid)
+        std::cerr << "verify: " << std::count(seen.begin(), seen.end(), false) << " of " << seen.size()
+                  << " pages never became resident in a pool of " << pool.slotCount() << " slots" << std::endl;
+    pool.destroy();
+    return valid;
+}
+
+// Returns false when a check that needs the GL context fails; true when it cannot run
+bool benchmarkGl(const Mesh& mesh, const std::filesystem::path& directory, const BenchOptions& options, std::vector<BenchResult>& results) {
+    GLFWwindow* window = options.skipGl ? nullptr : createGlWindow(800, 800, "a3_bench", WindowMode::Hidden);
+    bool headless = window == nullptr && !options.skipGl;
+    if (headless)
+        window = createGlWindow(800, 800, "a3_bench", WindowMode::Headless);
+    OffscreenTarget offscreen;
+    if (window != nullptr && headless && !offscreen.create(800, 800)) {
+        glfwDestroyWindow(window);
+        glfwTerminate();
+        window = nullptr;
+    }
+    if (window == nullptr) {
+        for (const char* name : glBenchmarks)
+            results.push_back(skipped(name, "no GL context"));
+        return true;
+    }
+    if (headless)
+        std::cerr << "GL benchmarks run headless on " << glGetString(GL_RENDERER) << std::endl;
+    else
+        glfwSwapInterval(0); // Never wait for vsync while measuring
+    glViewport(0, 0, 800, 800);
+
+    IndexedGeometry geometry = buildIndexedGeometry(mesh);
+    for (VertexFormat format : {VertexFormat::Float, VertexFormat::Compact}) {
+        std::string suffix = format == VertexFormat::Float ? "" : std::string("-") + vertexFormatName(format);
+        results.push_back(measure("upload/contingo" + suffix, options, [&] {
+            SceneBuffers buffers;
+            buffers.create(true, format);
+            buffers.uploadNow(geometry); // Includes encoding the vertices
+            glFinish(); // Include the driver's copy in the sample
+            buffers.destroy();
+        }));
+    }
+
+    // One sample per frame of 1 MiB of transient vertex data in 16 KiB allocations, through a ring of four frames
+    for (bool persistent : {true, false}) {
+        std::string name = std::string("stream/1mib-") + (persistent ? "persistent" : "orphan");
+        StreamBuffer stream;
+        stream.create(GL_ARRAY_BUFFER, 4u << 20, persistent);
+        if (persistent && !stream.persistent()) {
+            results.push_back(skipped(name, "no buffer storage"));
+        } else {
+            BenchOptions frameOptions = options;
+            frameOptions.iterations = options.frames;
+            frameOptions.maxSeconds = 1e9;
+            results.push_back(measure(name, frameOptions, [&] {
+                for (int i = 0; i < 64; ++i) {
+                    StreamAllocation allocation = stream.allocate(16u << 10);
+                    std::memset(allocation.data, i, 16u << 10);
+                }
+                stream.flush();
+                stream.endFrame();
+                glFlush();
+            }));
+            const StreamStats& totals = stream.totals();
+            std::cerr << name << ": " << totals.bytes / std::max<uint64_t>(totals.frames, 1) << " bytes per frame, "
+                      << totals.fenceWaits << " fence waits, " << totals.fenceWaitMillis << " ms waiting" << std::endl;
+        }
+        stream.destroy();
+    }
+
+    GLuint shaderPrograms[] = {createShaderProgram(VertexFormat::Float), createShaderProgram(VertexFormat::Compact)};
+    glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+    Scene single;
+    single.instances = {{0, glm::mat4(1.0f)}};
+    Scene grid = single;
+    repeatInstances(grid, 64);
+
+    // One sample per frame: a fixed rotation each frame, finished before the clock stops. lodLevel
+    // is passed to selectLods(), fullDetail skips level selection. Vertices are stored in format.
+    BenchOptions frameOptions = options;
+    frameOptions.iterations = options.frames;
+    frameOptions.maxSeconds = 1e9;
+    const int fullDetail = -2;
+    IndexedGeometry lodGeometry = buildIndexedGeometry(mesh, maxLodLevels);
+    auto frames = [&](const std::string& name, bool multiDraw, const std::vector<ModelInstance>& instances, float zoom, bool cull,
+                      int lodLevel, VertexFormat format) {
+        GLuint shaderProgram = shaderPrograms[format == VertexFormat::Float ? 0 : 1];
+        GLint transformLoc = glGetUniformLocation(shaderProgram, "transform");
+        SceneBuffers buffers;
+        buffers.create(multiDraw, format);
+        buffers.uploadNow(lodLevel == fullDetail ? geometry : lodGeometry);
+        if (multiDraw && !buffers.drawTable().multiDrawIndirect()) {
+            results.push_back(skipped(name, "no multi-draw indirect"));
+        } else {
+            glm::mat4 transform = glm::scale(glm::mat4(1.0f), glm::vec3(zoom));
+            results.push_back(measure(name, frameOptions, [&] {
+                transform = glm::rotate(transform, glm::radians(1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+                glClearColor(0.2f, 0.2f, 0.2f, 1.0f);
+                glClear(GL_COLOR_BUFFER_BIT);
+                glUseProgram(shaderProgram);
+                glUniformMatrix4fv(transformLoc, 1, GL_FALSE, glm::value_ptr(transform));
+                if (cull)
+                    buffers.cull(instances, transform);
+                if (lodLevel != fullDetail)
+                    buffers.selectLods(instances, transform, 400.0f, 1.0f, lodLevel); // 800 pixels high
+                buffers.draw(instances);
+                if (!headless)
+                    glfwSwapBuffers(window);
+                glFinish();
+            }));
+        }
+        buffers.destroy();
+    };
+    frames("frame/contingo", true, single.instances, 0.5f, false, fullDetail, VertexFormat::Float);
+    frames("frame/contingo-x64-mdi", true, grid.instances, 0.5f, false, fullDetail, VertexFormat::Float);   // Two indirect calls per frame
+    frames("frame/contingo-compact", true, single.instances, 0.5f, false, fullDetail, VertexFormat::Compact);
+    frames("frame/contingo-x64-mdi-compact", true, grid.instances, 0.5f, false, fullDetail, VertexFormat::Compact);
+    frames("frame/contingo-x64-loop", false, grid.instances, 0.5f, false, fullDetail, VertexFormat::Float); // One call per shape per instance
+    frames("frame/contingo-x64-zoom-cull", true, grid.instances, 4.0f, true, fullDetail, VertexFormat::Float); // Most instances off screen
+    frames("frame/contingo-x64-zoom-nocull", true, grid.instances, 4.0f, false, fullDetail, VertexFormat::Float);
+    for (int level = 0; level <= static_cast<int>(maxLodLevels); ++level) // Every record at one level
+        frames("frame/contingo-x64-lod" + std::to_string(level), true, grid.instances, 0.5f, false, level, VertexFormat::Float);
+    frames("frame/contingo-x64-lod-auto", true, grid.instances, 0.5f, false, -1, VertexFormat::Float); // Levels by projected error
+
+    for (GLuint shaderProgram : shaderPrograms)
+        glDeleteProgram(shaderProgram);
+
+    // Models larger than the page pool
+    bool valid = verifyPageResidency(directory);
+
+    offscreen.destroy();
+    glfwDestroyWindow(window);
+    glfwTerminate();
+    return valid;
+}
+
+void printUsage(const char* program) {
+    std::cerr << "Usage: " << program << " [options]\n"
+              << "  --obj <file>           OBJ used for the contingo benchmarks (default ../contingo.obj)\n"
+              << "  --out <file>           write the JSON report to a file instead of stdout\n"
+              << "  --iterations <n>       iterations per benchmark (default 10)\n"
+              << "  --max-seconds <s>      stop a benchmark after this long once it has 3 samples (default 5)\n"
+              << "  --frames <n>           frames for the frame benchmark (default 200)\n"
+              << "  --grid-sizes <a,b,..>  synthetic grid sizes in quads per side (default 64,256,1024)\n"
+              << "  --rss-mb <n>           size of the synthetic OBJ for the peak RSS comparison (default 1024, 0 skips)\n"
+              << "  --skip-gl              skip the upload and frame benchmarks\n";
+}
+
+bool parseBenchOptions(int argc, char* argv[], BenchOptions& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--obj" && hasValue) {
+            options.objPath = argv[++i];
+        } else if (arg == "--out" && hasValue) {
+            options.outPath = argv[++i];
+        } else if (arg == "--iterations" && hasValue) {
+            options.iterations = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--max-seconds" && hasValue) {
+            options.maxSeconds = std::atof(argv[++i]);
+        } else if (arg == "--frames" && hasValue) {
+            options.frames = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--grid-sizes" && hasValue) {
+            options.gridSizes.clear();
+            std::istringstream list(argv[++i]);
+            std::string item;
+            while (std::getline(list, item, ','))
+                options.gridSizes.push_back(static_cast<unsigned>(std::max(1, std::atoi(item.c_str()))));
+        } else if (arg == "--rss-mb" && hasValue) {
+            options.rssMegabytes = static_cast<unsigned>(std::max(0, std::atoi(argv[++i])));
+        } else if (arg == "--skip-gl") {
+            options.skipGl = true;
+        } else {
+            printUsage(argv[0]);
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    BenchOptions options;
+    if (!parseBenchOptions(argc, argv, options))
+        return 1;
+
+    std::vector<BenchResult> results;
+    std::filesystem::path directory = std::filesystem::temp_directory_path();
+
+    // Peak memory first, while this process is still small: every fork starts from its footprint
+    addPeakRss("rss/baseline", [] { return true; }, results);
+    benchmarkPeakRss("contingo", options.objPath, results);
+    if (options.rssMegabytes > 0) {
+        std::string path = (directory / "a3_bench_rss.obj").string();
+        unsigned gridSize = syntheticGridSizeForBytes(uint64_t(options.rssMegabytes) << 20);
+        if (writeSyntheticObj(path, gridSize))
+            benchmarkPeakRss("synthetic" + std::to_string(options.rssMegabytes) + "mb", path, results);
+        else
+            results.push_back(skipped("rss/synthetic", "cannot write " + path));
+        std::remove(path.c_str());
+    }
+
+    // Number kernels: correctness first, then throughput on the records of contingo.obj
+    MappedFile objFile;
+    if (!objFile.open(options.objPath)) {
+        std::cerr << "Cannot open " << options.objPath << std::endl;
+        return 1;
+    }
+    ObjTokens tokens = collectTokens(objFile);
+    bool verified = verifyParser(options.objPath, tokens);
+    benchmarkKernels("contingo", tokens, options, results);
+
+    // Loading: tinyobj and the parallel parser on contingo.obj, then the warm-start cache
+    benchmarkLoading("contingo", options.objPath, options, results);
+    Mesh mesh;
+    MeshSourceStamp stamp;
+    std::string message;
+    if (!loadObjWithTinyobj(options.objPath, mesh, message) || !stampMeshSource(options.objPath, stamp)) {
+        std::cerr << options.objPath << ": " << message << std::endl;
+        return 1;
+    }
+    if (writeMeshCache(options.objPath, stamp, mesh, 0.0)) {
+        results.push_back(measure("load/cache/contingo", options, [&] {
+            Mesh cached;
+            double textParseMillis;
+            readMeshCache(options.objPath, stamp, cached, textParseMillis);
+        }));
+    } else {
+        results.push_back(skipped("load/cache/contingo", "cannot write the cache"));
+    }
+
+    // Extraction: the original de-indexed loop against the indexed build
+    results.push_back(measure("extract/deindexed/contingo", options, [&] {
+        std::vector<float> vertices;
+        for (const auto& index : mesh.indices) {
+            vertices.push_back(mesh.positions[3 * index.vertex + 0]);
+            vertices.push_back(mesh.positions[3 * index.vertex + 1]);
+            vertices.push_back(mesh.positions[3 * index.vertex + 2]);
+        }
+    }));
+    results.push_back(measure("extract/indexed/contingo", options, [&] {
+        IndexedGeometry geometry = buildIndexedGeometry(mesh);
+    }));
+
+    // Frustum culling against brute force, and its cost per frame
+    verified = verifyCulling(buildIndexedGeometry(mesh), options, results) && verified;
+
+    // Levels of detail and how far they stray from the full-detail surface
+    verified = verifyLods(mesh, options, results) && verified;
+
+    // Vertex cache and fetch order
+    verified = verifyOptimizer(mesh, options, results) && verified;
+
+    // Compact vertex formats against the OBJ data
+    verified = verifyVertexFormats(mesh, options, results) && verified;
+
+    // Meshlet limits and cluster culling against brute force
+    verified = verifyMeshlets(mesh, options, results) && verified;
+
+    // Ray queries for picking
+    verified = benchmarkBvh("contingo", mesh, options, results) && verified;
+
+    // Vertex transform kernels against the scalar one, and their throughput
+    verified = benchmarkTransform(mesh, options, results) && verified;
+
+    // Software rasteriser against known coverage, and its frame rate per thread count
+    verified = benchmarkSoftware(mesh, options, results) && verified;
+
+    // Rolling percentiles of the frame timing
+    verified = verifyFrameHistogram(options, results) && verified;
+
+    // Fixed-timestep simulation against the frame rate
+    verified = verifySimulationClock() && verified;
+
+    // Snapshots handed to the render thread
+    verified = verifyTripleBuffer(options, results) && verified;
+
+    // Recorded input replays exactly
+    verified = verifyInputRecording(directory) && verified;
+
+    // Frame files written by headless runs
+    verified = verifyImageFiles(directory, options, results) && verified;
+
+    // Loading synthetic grids of increasing size
+    for (unsigned gridSize : options.gridSizes) {
+        std::string label = "grid" + std::to_string(gridSize);
+        std::string path = (directory / ("a3_bench_" + label + ".obj")).string();
+        if (!writeSyntheticObj(path, gridSize)) {
+            results.push_back(skipped("load/tinyobj/" + label, "cannot write " + path));
+            continue;
+        }
+        benchmarkLoading(label, path, options, results);
+        ThreadPool pool;
+        Mesh grid;
+        std::string gridMessage;
+        if (parseObjParallel(path, pool, grid, gridMessage))
+            verified = benchmarkBvh(label, grid, options, results) && verified;
+        std::remove(path.c_str());
+    }
+
+    // Buffer upload, headless frames and page residency
+    verified = benchmarkGl(mesh, directory, options, results) && verified;
+
+    std::string json = toJson(results);
+    if (options.outPath.empty()) {
+        std::cout << json;
+    } else {
+        std::ofstream out(options.outPath);
+        out << json;
+        if (!out) {
+            std::cerr << "Cannot write " << options.outPath << std::endl;
+            return 1;
+        }
+    }
+    return verified ? 0 : 1;
+}
@@ -0,0 +1,471 @@
+#include "bvh.h"
+
+#include <algorithm>                       // For std::partition()/std::min()/std::max()
+#include <cfloat>                          // For FLT_MAX
+#include <cmath>                           // For std::fabs()/std::nextafter()
+#include <utility>                         // For std::swap()
+
+namespace {
+
+const unsigned binCount = 16;              // SAH candidates per node: binCount - 1 planes on the widest centroid axis
+const uint32_t maxLeafSize = 8;            // Larger nodes are always split
+const unsigned maxDepth = 64;              // Nodes this deep become leaves, so traversal stacks are bounded
+const float traversalCost = 1.0f;          // Cost of visiting a node relative to one triangle test
+const std::size_t parallelBinning = 1u << 16; // Nodes at least this large are binned on every thread
+
+struct Box {
+    glm::vec3 min = glm::vec3(FLT_MAX);
+    glm::vec3 max = glm::vec3(-FLT_MAX);
+
+    void grow(const glm::vec3& point) {
+        min = glm::min(min, point);
+        max = glm::max(max, point);
+    }
+    void grow(const Box& other) {
+        min = glm::min(min, other.min);
+        max = glm::max(max, other.max);
+    }
+    // Half the surface area, which is all the SAH ratios need; 0 for an empty box
+    float halfArea() const {
+        glm::vec3 d = max - min;
+        return d.x < 0.0f ? 0.0f : d.x * d.y + d.y * d.z + d.z * d.x;
+    }
+};
+
+struct Primitive {
+    Box box;
+    glm::vec3 centroid;
+};
+
+struct Bin {
+    Box box;
+    uint32_t count = 0;
+};
+
+// Which of the binCount bins along axis a centroid falls in
+unsigned binOf(const glm::vec3& centroid, int axis, float lowest, float scale) {
+    int bin = static_cast<int>((centroid[axis] - lowest) * scale);
+    return static_cast<unsigned>(std::min(std::max(bin, 0), int(binCount) - 1));
+}
+
+// Splits a range of triangle references into subtrees; shared by the parallel top of the tree and
+// the serial subtrees below it
+class Builder {
+public:
+    Builder(const std::vector<Primitive>& primitives, std::vector<uint32_t>& refs)
+        : primitives_(primitives), refs_(refs) {}
+
+    // Bounds of the triangles and of their centroids over refs[begin, end), on every thread of pool if given
+    void bounds(std::size_t begin, std::size_t end, Box& box, Box& centroids, ThreadPool* pool) const {
+        if (pool == nullptr || end - begin < parallelBinning) {
+            for (std::size_t i = begin; i < end; ++i) {
+                const Primitive& primitive = primitives_[refs_[i]];
+                box.grow(primitive.box);
+                centroids.grow(primitive.centroid);
+            }
+            return;
+        }
+        std::size_t blocks = pool->size() * 4;
+        std::vector<Box> boxes(blocks), centroidBoxes(blocks);
+        pool->parallelFor(blocks, [&](std::size_t b) {
+            bounds(begin + (end - begin) * b / blocks, begin + (end - begin) * (b + 1) / blocks, boxes[b], centroidBoxes[b], nullptr);
+        });
+        for (std::size_t b = 0; b < blocks; ++b) {
+            box.grow(boxes[b]);
+            centroids.grow(centroidBoxes[b]);
+        }
+    }
+
+    // Partition refs[begin, end) at the cheapest SAH plane and return the first index of the right
+    // half, or begin when the range should stay a leaf
+    std::size_t split(std::size_t begin, std::size_t end, const Box& box, const Box& centroids, unsigned depth, ThreadPool* pool) {
+        std::size_t count = end - begin;
+        if (count <= 1 || depth >= maxDepth)
+            return begin;
+
+        glm::vec3 extent = centroids.max - centroids.min;
+        int axis = extent.x >= extent.y && extent.x >= extent.z ? 0 : (extent.y >= extent.z ? 1 : 2);
+        if (extent[axis] <= 0.0f) {
+            // Every centroid coincides: no plane separates them, so halve by count if the leaf would be too big
+            return count <= maxLeafSize ? begin : begin + count / 2;
+        }
+        float lowest = centroids.min[axis];
+        float scale = binCount / extent[axis];
+
+        Bin bins[binCount];
+        binRange(begin, end, axis, lowest, scale, bins, pool);
+
+        // Sweep from both sides: the cost of a plane after bin i is the SAH of the two halves it makes
+        float rightArea[binCount];
+        uint32_t rightCount[binCount];
+        Box right;
+        uint32_t countRight = 0;
+        for (unsigned i = binCount - 1; i > 0; --i) {
+            right.grow(bins[i].box);
+            countRight += bins[i].count;
+            rightArea[i] = right.halfArea();
+            rightCount[i] = countRight;
+        }
+        Box left;
+        uint32_t countLeft = 0;
+        float bestCost = FLT_MAX;
+        unsigned bestPlane = 0;
+        for (unsigned i = 1; i < binCount; ++i) {
+            left.grow(bins[i - 1].box);
+            countLeft += bins[i - 1].count;
+            if (countLeft == 0 || rightCount[i] == 0)
+                continue;
+            float cost = left.halfArea() * countLeft + rightArea[i] * rightCount[i];
+            if (cost < bestCost) {
+                bestCost = cost;
+                bestPlane = i;
+            }
+        }
+        float parentArea = box.halfArea();
+        float splitCost = traversalCost + (parentArea > 0.0f ? bestCost / parentArea : 0.0f);
+        if (bestPlane == 0 || (count <= maxLeafSize && splitCost >= float(count)))
+            return begin; // Testing every triangle is cheaper than descending
+
+        auto middle = std::partition(refs_.begin() + begin, refs_.begin() + end, [&](uint32_t ref) {
+            return binOf(primitives_[ref].centroid, axis, lowest, scale) < bestPlane;
+        });
+        return static_cast<std::size_t>(middle - refs_.begin());
+    }
+
+    // Build the subtree over refs[begin, end) depth first into nodes; right-child offsets are relative to nodes[0]
+    void buildSubtree(std::size_t begin, std::size_t end, unsigned depth, std::vector<BvhNode>& nodes) {
+        Box box, centroids;
+        bounds(begin, end, box, centroids, nullptr);
+        std::size_t index = nodes.size();
+        nodes.push_back(makeNode(box));
+        std::size_t middle = split(begin, end, box, centroids, depth, nullptr);
+        if (middle == begin) {
+            nodes[index].offset = static_cast<uint32_t>(begin);
+            nodes[index].count = static_cast<uint32_t>(end - begin);
+            return;
+        }
+        buildSubtree(begin, middle, depth + 1, nodes);
+        nodes[index].offset = static_cast<uint32_t>(nodes.size());
+        buildSubtree(middle, end, depth + 1, nodes);
+    }
+
+    static BvhNode makeNode(const Box& box) {
+        BvhNode node = {};
+        for (int axis = 0; axis < 3; ++axis) {
+            node.boundsMin[axis] = box.min[axis];
+            node.boundsMax[axis] = box.max[axis];
+        }
+        return node;
+    }
+
+private:
+    void binRange(std::size_t begin, std::size_t end, int axis, float lowest, float scale, Bin bins[binCount], ThreadPool* pool) const {
+        if (pool == nullptr || end - begin < parallelBinning) {
+            for (std::size_t i = begin; i < end; ++i) {
+                const Primitive& primitive = primitives_[refs_[i]];
+                Bin& bin = bins[binOf(primitive.centroid, axis, lowest, scale)];
+                bin.box.grow(primitive.box);
+                ++bin.count;
+            }
+            return;
+        }
+        std::size_t blocks = pool->size() * 4;
+        std::vector<Bin> blockBins(blocks * binCount);
+        pool->parallelFor(blocks, [&](std::size_t b) {
+            binRange(begin + (end - begin) * b / blocks, begin + (end - begin) * (b + 1) / blocks, axis, lowest, scale,
+                     &blockBins[b * binCount], nullptr);
+        });
+        for (std::size_t b = 0; b < blocks; ++b) {
+            for (unsigned i = 0; i < binCount; ++i) {
+                bins[i].box.grow(blockBins[b * binCount + i].box);
+                bins[i].count += blockBins[b * binCount + i].count;
+            }
+        }
+    }
+
+    const std::vector<Primitive>& primitives_;
+    std::vector<uint32_t>& refs_;
+};
+
+// Entry distance of a ray into a node's box, FLT_MAX when it misses or enters beyond tMax
+float enterBox(const BvhNode& node, const glm::vec3& origin, const glm::vec3& inverse, float tMax) {
+    float tNear = 0.0f, tFar = tMax;
+    for (int axis = 0; axis < 3; ++axis) {
+        float t0 = (node.boundsMin[axis] - origin[axis]) * inverse[axis];
+        float t1 = (node.boundsMax[axis] - origin[axis]) * inverse[axis];
+        if (t0 > t1)
+            std::swap(t0, t1);
+        tNear = std::max(tNear, t0);
+        tFar = std::min(tFar, t1);
+    }
+    return tNear <= tFar ? tNear : FLT_MAX;
+}
+
+float boxDistanceSquared(const BvhNode& node, const glm::vec3& point) {
+    float sum = 0.0f;
+    for (int axis = 0; axis < 3; ++axis) {
+        float d = std::max(std::max(node.boundsMin[axis] - point[axis], 0.0f), point[axis] - node.boundsMax[axis]);
+        sum += d * d;
+    }
+    return sum;
+}
+
+// Closest point to p on triangle abc, by the Voronoi regions of its corners and edges (Ericson, RTCD 5.1.5)
+glm::vec3 closestOnTriangle(const glm::vec3& p, const glm::vec3& a, const glm::vec3& b, const glm::vec3& c) {
+    glm::vec3 ab = b - a, ac = c - a, ap = p - a;
+    float d1 = glm::dot(ab, ap), d2 = glm::dot(ac, ap);
+    if (d1 <= 0.0f && d2 <= 0.0f)
+        return a;
+    glm::vec3 bp = p - b;
+    float d3 = glm::dot(ab, bp), d4 = glm::dot(ac, bp);
+    if (d3 >= 0.0f && d4 <= d3)
+        return b;
+    float vc = d1 * d4 - d3 * d2;
+    if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f)
+        return a + ab * (d1 / (d1 - d3));
+    glm::vec3 cp = p - c;
+    float d5 = glm::dot(ab, cp), d6 = glm::dot(ac, cp);
+    if (d6 >= 0.0f && d5 <= d6)
+        return c;
+    float vb = d5 * d2 - d1 * d6;
+    if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f)
+        return a + ac * (d2 / (d2 - d6));
+    float va = d3 * d6 - d5 * d4;
+    if (va <= 0.0f && d4 - d3 >= 0.0f && d5 - d6 >= 0.0f)
+        return b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+    float denominator = 1.0f / (va + vb + vc);
+    return a + ab * (vb * denominator) + ac * (vc * denominator);
+}
+
+} // namespace
+
+void Bvh::build(const float* positions, const uint32_t* corners, std::size_t triangleCount, ThreadPool& pool) {
+    nodes_.clear();
+    triangles_.clear();
+    triangleIds_.clear();
+    if (triangleCount == 0)
+        return;
+
+    // Boxes and centroids of every triangle
+    std::vector<Primitive> primitives(triangleCount);
+    std::vector<uint32_t> refs(triangleCount);
+    auto corner = [&](std::size_t t, int k) {
+        const float* p = positions + 3 * std::size_t(corners[3 * t + k]);
+        return glm::vec3(p[0], p[1], p[2]);
+    };
+    std::size_t blocks = pool.size() * 4;
+    pool.parallelFor(blocks, [&](std::size_t b) {
+        for (std::size_t t = triangleCount * b / blocks; t < triangleCount * (b + 1) / blocks; ++t) {
+            Primitive& primitive = primitives[t];
+            for (int k = 0; k < 3; ++k)
+                primitive.box.grow(corner(t, k));
+            primitive.centroid = (primitive.box.min + primitive.box.max) * 0.5f;
+            refs[t] = static_cast<uint32_t>(t);
+        }
+    });
+
+    // Top of the tree: split serially with parallel binning until the ranges are small enough to hand
+    // one to each thread. Ranges left over become tasks, marked in top by count == UINT32_MAX.
+    Builder builder(primitives, refs);
+    std::size_t taskSize = std::max<std::size_t>(triangleCount / (pool.size() * 8), 4096);
+    struct Task {
+        std::size_t begin, end;
+        unsigned depth;
+        std::vector<BvhNode> nodes;
+    };
+    std::vector<Task> tasks;
+    std::vector<BvhNode> top;
+    auto buildTop = [&](auto& self, std::size_t begin, std::size_t end, unsigned depth) -> void {
+        std::size_t index = top.size();
+        if (end - begin <= taskSize) {
+            BvhNode placeholder = {};
+            placeholder.offset = static_cast<uint32_t>(tasks.size());
+            placeholder.count = UINT32_MAX;
+            top.push_back(placeholder);
+            tasks.push_back({begin, end, depth, {}});
+            return;
+        }
+        Box box, centroids;
+        builder.bounds(begin, end, box, centroids, &pool);
+        top.push_back(Builder::makeNode(box));
+        std::size_t middle = builder.split(begin, end, box, centroids, depth, &pool);
+        if (middle == begin) {
+            top[index].offset = static_cast<uint32_t>(begin);
+            top[index].count = static_cast<uint32_t>(end - begin);
+            return;
+        }
+        self(self, begin, middle, depth + 1);
+        top[index].offset = static_cast<uint32_t>(top.size());
+        self(self, middle, end, depth + 1);
+    };
+    buildTop(buildTop, 0, triangleCount, 0);
+
+    // Subtrees in parallel, each into its own node array
+    pool.parallelFor(tasks.size(), [&](std::size_t t) {
+        Task& task = tasks[t];
+        builder.buildSubtree(task.begin, task.end, task.depth, task.nodes);
+    });
+
+    // Flatten depth first, splicing each task's nodes in place of its placeholder
+    nodes_.reserve(top.size() + triangleCount / 2);
+    auto emit = [&](auto& self, std::size_t index) -> void {
+        const BvhNode& node = top[index];
+        if (node.count == UINT32_MAX) {
+            uint32_t base = static_cast<uint32_t>(nodes_.size());
+            for (BvhNode sub : tasks[node.offset].nodes) {
+                if (sub.count == 0)
+                    sub.offset += base;
+                nodes_.push_back(sub);
+            }
+            return;
+        }
+        std::size_t written = nodes_.size();
+        nodes_.push_back(node);
+        if (node.count > 0)
+            return;
+        self(self, index + 1);
+        nodes_[written].offset = static_cast<uint32_t>(nodes_.size());
+        self(self, node.offset);
+    };
+    emit(emit, 0);
+
+    // Triangles in leaf order so a leaf reads one contiguous run
+    triangles_.resize(triangleCount);
+    triangleIds_ = std::move(refs);
+    pool.parallelFor(blocks, [&](std::size_t b) {
+        for (std::size_t i = triangleCount * b / blocks; i < triangleCount * (b + 1) / blocks; ++i) {
+            std::size_t t = triangleIds_[i];
+            glm::vec3 v0 = corner(t, 0);
+            triangles_[i] = {v0, corner(t, 1) - v0, corner(t, 2) - v0};
+        }
+    });
+}
+
+bool Bvh::intersectRay(const glm::vec3& origin, const glm::vec3& direction, float tMax, RayHit& hit) const {
+    if (nodes_.empty())
+        return false;
+    glm::vec3 inverse;
+    for (int axis = 0; axis < 3; ++axis) // A zero component gets a huge finite slope, avoiding 0 * inf
+        inverse[axis] = 1.0f / (direction[axis] != 0.0f ? direction[axis] : 1e-30f);
+
+    uint32_t stack[maxDepth + 2];
+    unsigned stackSize = 0;
+    uint32_t current = 0;
+    float best = tMax;
+    bool found = false;
+    if (enterBox(nodes_[0], origin, inverse, best) == FLT_MAX)
+        return false;
+    for (;;) {
+        const BvhNode& node = nodes_[current];
+        if (node.count > 0) {
+            // Moller-Trumbore against every triangle of the leaf, accepting both windings
+            for (uint32_t i = node.offset; i < node.offset + node.count; ++i) {
+                const Triangle& triangle = triangles_[i];
+                glm::vec3 p = glm::cross(direction, triangle.edge2);
+                float determinant = glm::dot(triangle.edge1, p);
+                if (std::fabs(determinant) < 1e-20f)
+                    continue; // Ray parallel to the triangle
+                float inverseDeterminant = 1.0f / determinant;
+                glm::vec3 s = origin - triangle.v0;
+                float u = glm::dot(s, p) * inverseDeterminant;
+                if (u < 0.0f || u > 1.0f)
+                    continue;
+                glm::vec3 q = glm::cross(s, triangle.edge1);
+                float v = glm::dot(direction, q) * inverseDeterminant;
+                if (v < 0.0f || u + v > 1.0f)
+                    continue;
+                float t = glm::dot(triangle.edge2, q) * inverseDeterminant;
+                if (t >= 0.0f && t < best) {
+                    best = t;
+                    hit = {t, u, v, triangleIds_[i]};
+                    found = true;
+                }
+            }
+        } else {
+            // Visit the nearer child first and keep the other for later
+            uint32_t left = current + 1, right = node.offset;
+            float tLeft = enterBox(nodes_[left], origin, inverse, best);
+            float tRight = enterBox(nodes_[right], origin, inverse, best);
+            if (tLeft > tRight) {
+                std::swap(tLeft, tRight);
+                std::swap(left, right);
+            }
+            if (tLeft != FLT_MAX) {
+                if (tRight != FLT_MAX)
+                    stack[stackSize++] = right;
+                current = left;
+                continue;
+            }
+        }
+        if (stackSize == 0)
+            return found;
+        current = stack[--stackSize];
+    }
+}
+
+bool Bvh::intersectSegment(const glm::vec3& from, const glm::vec3& to, RayHit& hit) const {
+    return intersectRay(from, to - from, std::nextafter(1.0f, 2.0f), hit); // Include hits exactly at to
+}
+
+bool Bvh::nearestPoint(const glm::vec3& point, float maxDistance, NearestHit& hit) const {
+    if (nodes_.empty())
+        return false;
+    struct Entry {
+        uint32_t node;
+        float distanceSquared;             // From point to the node's box
+    };
+    Entry stack[maxDepth + 2];
+    unsigned stackSize = 0;
+    float best = maxDistance * maxDistance;
+    bool found = false;
+    stack[stackSize++] = {0, boxDistanceSquared(nodes_[0], point)};
+    while (stackSize > 0) {
+        Entry entry = stack[--stackSize];
+        if (entry.distanceSquared > best)
+            continue; // A closer point was found since this node was pushed
+        const BvhNode& node = nodes_[entry.node];
+        if (node.count > 0) {
+            for (uint32_t i = node.offset; i < node.offset + node.count; ++i) {
+                const Triangle& triangle = triangles_[i];
+                glm::vec3 closest = closestOnTriangle(point, triangle.v0, triangle.v0 + triangle.edge1, triangle.v0 + triangle.edge2);
+                glm::vec3 d = closest - point;
+                float distanceSquared = glm::dot(d, d);
+                if (distanceSquared <= best) {
+                    best = distanceSquared;
+                    hit = {closest, distanceSquared, triangleIds_[i]};
+                    found = true;
+                }
+            }
+            continue;
+        }
+        // Push the farther child first so the nearer one is searched first
+        Entry left = {entry.node + 1, boxDistanceSquared(nodes_[entry.node + 1], point)};
+        Entry right = {node.offset, boxDistanceSquared(nodes_[node.offset], point)};
+        if (left.distanceSquared < right.distanceSquared)
+            std::swap(left, right);
+        if (left.distanceSquared <= best)
+            stack[stackSize++] = left;
+        if (right.distanceSquared <= best)
+            stack[stackSize++] = right;
+    }
+    return found;
+}
+
+unsigned Bvh::depth() const {
+    if (nodes_.empty())
+        return 0;
+    unsigned deepest = 0;
+    std::vector<std::pair<uint32_t, unsigned>> stack = {{0, 1}};
+    while (!stack.empty()) {
+        std::pair<uint32_t, unsigned> entry = stack.back();
+        stack.pop_back();
+        const BvhNode& node = nodes_[entry.first];
+        if (node.count > 0) {
+            deepest = std::max(deepest, entry.second);
+            continue;
+        }
+        stack.push_back({entry.first + 1, entry.second + 1});
+        stack.push_back({node.offset, entry.second + 1});
+    }
+    return deepest;
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstddef>                         // For std::size_t
+#include <cstdint>                         // Fixed-width integer types
+#include <vector>                          // For using the std::vector container
+#include <glm/glm.hpp>                     // GLM library for handling matrices and vectors
+#include "thread_pool.h"                   // Threads for the build
+
+// Node of the flattened tree, two per 64-byte cache line. Nodes are stored depth first: an interior
+// node's left child directly follows it and offset is the index of its right child. A leaf has
+// count > 0 triangles starting at offset in the BVH's triangle order.
+struct BvhNode {
+    float boundsMin[3];
+    uint32_t offset;
+    float boundsMax[3];
+    uint32_t count;                        // 0 for interior nodes
+};
+
+// Closest intersection along a ray or segment
+struct RayHit {
+    float t;                               // Distance in units of the direction's length
+    float u, v;                            // Barycentrics of the hit on triangle (weights of its second and third corners)
+    uint32_t triangle;                     // As numbered in build()
+};
+
+// Closest point on the surface
+struct NearestHit {
+    glm::vec3 point;
+    float distanceSquared;
+    uint32_t triangle;
+};
+
+// Bounding volume hierarchy over a triangle list, built top-down with binned SAH
+class Bvh {
+public:
+    // Build over triangleCount triangles whose corners index xyz triples of positions.
+    // Large nodes are binned in parallel and the subtrees below them are built concurrently.
+    void build(const float* positions, const uint32_t* corners, std::size_t triangleCount, ThreadPool& pool);
+
+    // Closest hit of origin + t * direction with 0 <= t < tMax, false if there is none
+    bool intersectRay(const glm::vec3& origin, const glm::vec3& direction, float tMax, RayHit& hit) const;
+    // Closest hit between from and to; hit.t is the fraction of the way to to
+    bool intersectSegment(const glm::vec3& from, const glm::vec3& to, RayHit& hit) const;
+    // Closest point of any triangle within maxDistance of point, false if there is none
+    bool nearestPoint(const glm::vec3& point, float maxDistance, NearestHit& hit) const;
+
+    std::size_t nodeCount() const { return nodes_.size(); }
+    std::size_t triangleCount() const { return triangles_.size(); }
+    bool empty() const { return nodes_.empty(); }
+    // Depth of the deepest leaf, the root being 1
+    unsigned depth() const;
+
+private:
+    // Triangle in leaf order, stored as a corner and two edges for the intersection test
+    struct Triangle {
+        glm::vec3 v0;
+        glm::vec3 edge1;                   // v1 - v0
+        glm::vec3 edge2;                   // v2 - v0
+    };
+
+    std::vector<BvhNode> nodes_;
+    std::vector<Triangle> triangles_;
+    std::vector<uint32_t> triangleIds_;    // Build numbering of each triangle in leaf order
+};
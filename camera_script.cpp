@@ -0,0 +1,99 @@
+#include "camera_script.h"
+
+#include <cmath>                           // For std::pow()
+#include <fstream>                         // For reading script files
+#include <sstream>                         // For splitting script lines
+#include <glm/gtc/matrix_transform.hpp>    // GLM utilities for matrix transformations
+
+void applyKeys(const std::string& keys, double seconds, glm::mat4& transform) {
+    // Define movement parameters: the speeds are those of the original per-frame steps at 60 frames per second
+    const float steps = static_cast<float>(seconds * 60.0);
+    const float translationDistance = 0.01f * steps; // Distance for translation
+    const float rotationAngle = glm::radians(1.0f) * steps; // Angle for rotation in radians
+    const float scaleFactor = std::pow(1.01f, steps); // Scaling factor
+
+    // Applied in a fixed order whatever the order of the letters, as the window's key polling does
+    auto held = [&](char key) { return keys.find(key) != std::string::npos; };
+    if (held('W'))
+        transform = glm::translate(transform, glm::vec3(0.0f, translationDistance, 0.0f)); // Move up
+    if (held('S'))
+        transform = glm::translate(transform, glm::vec3(0.0f, -translationDistance, 0.0f)); // Move down
+    if (held('A'))
+        transform = glm::translate(transform, glm::vec3(-translationDistance, 0.0f, 0.0f)); // Move left
+    if (held('D'))
+        transform = glm::translate(transform, glm::vec3(translationDistance, 0.0f, 0.0f)); // Move right
+    if (held('Q'))
+        transform = glm::rotate(transform, rotationAngle, glm::vec3(0.0f, 1.0f, 0.0f)); // Rotate clockwise
+    if (held('E'))
+        transform = glm::rotate(transform, -rotationAngle, glm::vec3(0.0f, 1.0f, 0.0f)); // Rotate counterclockwise
+    if (held('R'))
+        transform = glm::scale(transform, glm::vec3(scaleFactor, scaleFactor, scaleFactor)); // Scale up
+    if (held('F'))
+        transform = glm::scale(transform, glm::vec3(1.0f / scaleFactor, 1.0f / scaleFactor, 1.0f / scaleFactor)); // Scale down
+}
+
+bool loadCameraScript(const std::string& path, std::vector<ScriptStep>& steps, std::string& message) {
+    std::ifstream file(path);
+    if (!file) {
+        message = "cannot open " + path;
+        return false;
+    }
+    steps.clear();
+    std::string line;
+    for (unsigned number = 1; std::getline(file, line); ++number) {
+        line = line.substr(0, line.find('#'));
+        std::istringstream fields(line);
+        std::string keys, extra;
+        long ticks = 0;
+        if (!(fields >> keys))
+            continue;                      // Blank or comment only
+        if (!(fields >> ticks) || ticks <= 0 || (fields >> extra) ||
+            keys.find_first_not_of(keys == "-" ? "-" : "WSADQERF") != std::string::npos) {
+            message = path + ":" + std::to_string(number) + ": expected \"<keys from WSADQERF, or -> <ticks>\"";
+            return false;
+        }
+        steps.push_back({keys == "-" ? std::string() : keys, static_cast<unsigned>(ticks)});
+    }
+    return true;
+}
+
+unsigned scriptLength(const std::vector<ScriptStep>& steps) {
+    unsigned ticks = 0;
+    for (const ScriptStep& step : steps)
+        ticks += step.ticks;
+    return ticks;
+}
+
+std::string scriptKeys(const std::vector<ScriptStep>& steps, uint64_t tick) {
+    for (const ScriptStep& step : steps) {
+        if (tick < step.ticks)
+            return step.keys;
+        tick -= step.ticks;
+    }
+    return std::string();
+}
+
+void recordKeys(std::vector<ScriptStep>& steps, const std::string& keys) {
+    std::string held;
+    for (char key : std::string("WSADQERF")) {
+        if (keys.find(key) != std::string::npos)
+            held += key;
+    }
+    if (!steps.empty() && steps.back().keys == held)
+        ++steps.back().ticks;
+    else
+        steps.push_back({held, 1});
+}
+
+bool saveCameraScript(const std::string& path, const std::vector<ScriptStep>& steps, std::string& message) {
+    std::ofstream file(path);
+    file << "# Keys held per simulation tick: <keys from WSADQERF, or - for none> <ticks>\n";
+    for (const ScriptStep& step : steps)
+        file << (step.keys.empty() ? "-" : step.keys) << ' ' << step.ticks << '\n';
+    file.close();
+    if (!file) {
+        message = "cannot write " + path;
+        return false;
+    }
+    return true;
+}
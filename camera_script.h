@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>                         // Fixed-width integer types
+#include <string>                          // For key strings and file paths
+#include <vector>                          // For using the std::vector container
+#include <glm/glm.hpp>                     // GLM library for handling matrices and vectors
+
+// Move transform by the viewer's keys held for seconds, given as the letters of the keys: W/S up and
+// down and A/D left and right at 0.6 units per second, Q/E rotation about y at 60 degrees per
+// second, R/F scale by 1.01 sixty times a second. Other characters are ignored.
+void applyKeys(const std::string& keys, double seconds, glm::mat4& transform);
+
+// Keys held for a number of simulation ticks
+struct ScriptStep {
+    std::string keys;                      // Letters as for applyKeys(), empty for none
+    unsigned ticks;
+};
+
+// Read a camera script: one step per line as "<keys> <ticks>", "-" standing for no key, with
+// blank lines and "#" comments skipped. Scripts replay the same at any frame rate, but a tick lasts
+// 1 / --sim-rate seconds. False, with message set, on a malformed line.
+bool loadCameraScript(const std::string& path, std::vector<ScriptStep>& steps, std::string& message);
+
+// Ticks the script lasts
+unsigned scriptLength(const std::vector<ScriptStep>& steps);
+
+// Keys held at tick, none past the end of the script
+std::string scriptKeys(const std::vector<ScriptStep>& steps, uint64_t tick);
+
+// Append a tick holding keys to steps, lengthening the last step when it holds the same ones.
+// Only the letters applyKeys() uses are kept, in its order, so any spelling of a set of keys merges.
+void recordKeys(std::vector<ScriptStep>& steps, const std::string& keys);
+
+// Write steps as a camera script that loadCameraScript() reads back unchanged. False, with message
+// set, if path cannot be written.
+bool saveCameraScript(const std::string& path, const std::vector<ScriptStep>& steps, std::string& message);
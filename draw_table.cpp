@@ -0,0 +1,326 @@
+#include "draw_table.h"
+
+#include <algorithm>                       // For std::max()/std::min()
+#include <cstdint>                         // For uintptr_t
+#include <cstring>                         // For std::memcpy()
+#include <glm/gtc/matrix_transform.hpp>    // GLM utilities for matrix transformations
+#include <glm/gtc/type_ptr.hpp>            // GLM utilities for converting matrices to pointer types
+
+namespace {
+
+bool sameCommand(const DrawElementsIndirectCommand& a, const DrawElementsIndirectCommand& b) {
+    return a.count == b.count && a.instanceCount == b.instanceCount && a.firstIndex == b.firstIndex &&
+           a.baseVertex == b.baseVertex && a.baseInstance == b.baseInstance;
+}
+
+} // namespace
+
+LodStats& LodStats::operator+=(const LodStats& other) {
+    for (unsigned level = 0; level <= maxLodLevels; ++level) {
+        records[level] += other.records[level];
+        triangles[level] += other.triangles[level];
+    }
+    return *this;
+}
+
+void setConstantModel(const glm::mat4& model) {
+    for (GLuint column = 0; column < 4; ++column)
+        glVertexAttrib4fv(modelAttribute + column, glm::value_ptr(model[column]));
+}
+
+void DrawTable::create(bool allowMultiDraw, VertexFormat format, bool persistentStreaming) {
+    multiDraw_ = allowMultiDraw && (GLEW_VERSION_4_3 || (GLEW_ARB_multi_draw_indirect && GLEW_ARB_base_instance));
+    format_ = format;
+    if (multiDraw_) // Ring holding the indirect commands, grown to three tables when it is too small
+        commandStream_.create(GL_DRAW_INDIRECT_BUFFER, 64 << 10, persistentStreaming);
+    glGenBuffers(1, &modelBuffer_);        // Generate the buffer holding the per-instance matrices
+}
+
+void DrawTable::destroy() {
+    if (multiDraw_)
+        commandStream_.destroy();
+    glDeleteBuffers(1, &modelBuffer_);
+    modelBuffer_ = 0;
+    commandOffset_ = 0;
+    records_.clear();
+    commands_[0].clear();
+    commands_[1].clear();
+    clusterCommands_[0].clear();
+    clusterCommands_[1].clear();
+    clustersCurrent_ = false;
+    models_.clear();
+    drawModels_.clear();
+}
+
+void DrawTable::bindModelAttribute() const {
+    if (!multiDraw_)
+        return; // The fallback loop sets the matrix as a constant attribute instead
+    glBindBuffer(GL_ARRAY_BUFFER, modelBuffer_);
+    for (GLuint column = 0; column < 4; ++column) {
+        glVertexAttribPointer(modelAttribute + column, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4),
+                              (void*)(uintptr_t)(column * sizeof(glm::vec4))); // One matrix column
+        glEnableVertexAttribArray(modelAttribute + column);
+        glVertexAttribDivisor(modelAttribute + column, 1); // Advance once per instance, selected by baseInstance per record
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void DrawTable::rebuild(const std::vector<std::vector<DrawShape>>& meshShapes, const std::vector<ModelInstance>& instances) {
+    records_.clear();
+    commands_[0].clear();
+    commands_[1].clear();
+    models_.clear();
+    drawModels_.clear();
+    clustersCurrent_ = false;
+    for (uint32_t i = 0; i < instances.size(); ++i) {
+        const ModelInstance& instance = instances[i];
+        models_.push_back(instance.model);
+        if (instance.meshId >= meshShapes.size())
+            continue; // Not loaded yet
+        const std::vector<DrawShape>& shapes = meshShapes[instance.meshId];
+        for (uint32_t s = 0; s < shapes.size(); ++s) {
+            const DrawShape& shape = shapes[s];
+            uint32_t list = shape.indexSize == 2 ? 0 : 1;
+            DrawElementsIndirectCommand command = {shape.indexCount, 1, shape.indexOffset / shape.indexSize,
+                                                   static_cast<int32_t>(shape.baseVertex), static_cast<uint32_t>(records_.size())};
+            records_.push_back({i, instance.meshId, s, true, list, static_cast<uint32_t>(commands_[list].size()), 0});
+            commands_[list].push_back(command);
+
+            // Take stored positions to object space, then place the instance
+            float scale[3], offset[3];
+            positionDecode(format_, shape.bounds, scale, offset);
+            glm::mat4 decode = glm::scale(glm::translate(glm::mat4(1.0f), glm::vec3(offset[0], offset[1], offset[2])),
+                                          glm::vec3(scale[0], scale[1], scale[2]));
+            drawModels_.push_back(instance.model * decode);
+        }
+    }
+    commandsDirty_ = true;
+
+    if (multiDraw_) {
+        glBindBuffer(GL_ARRAY_BUFFER, modelBuffer_);
+        glBufferData(GL_ARRAY_BUFFER, drawModels_.size() * sizeof(glm::mat4), drawModels_.data(), GL_STATIC_DRAW);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+}
+
+void DrawTable::setVisible(std::size_t record, bool visible) {
+    DrawRecord& entry = records_[record];
+    if (entry.visible == visible)
+        return;
+    entry.visible = visible;
+    commands_[entry.list][entry.command].instanceCount = visible ? 1 : 0;
+    commandsDirty_ = true;
+    clustersCurrent_ = false;
+}
+
+CullStats DrawTable::cull(const std::vector<std::vector<DrawShape>>& meshShapes, const glm::mat4& transform) {
+    CullStats stats;
+    Frustum frustum;
+    uint32_t frustumInstance = UINT32_MAX;
+    for (std::size_t r = 0; r < records_.size(); ++r) {
+        const DrawRecord& record = records_[r];
+        if (record.instance != frustumInstance) {
+            frustum = extractFrustum(transform * models_[record.instance]); // Planes in the instance's object space
+            frustumInstance = record.instance;
+        }
+        const DrawShape& shape = meshShapes[record.meshId][record.shape];
+        bool visible = boundsVisible(frustum, shape.bounds);
+        setVisible(r, visible);
+        ++stats.objects;
+        stats.triangles += shape.indexCount / 3;
+        if (!visible) {
+            ++stats.objectsCulled;
+            stats.trianglesCulled += shape.indexCount / 3;
+        }
+    }
+    return stats;
+}
+
+LodStats DrawTable::selectLods(const std::vector<std::vector<DrawShape>>& meshShapes, const glm::mat4& transform,
+                               float pixelsPerUnit, float thresholdPixels, int forcedLevel) {
+    LodStats stats;
+    float scale = 1.0f;
+    uint32_t scaleInstance = UINT32_MAX;
+    for (std::size_t r = 0; r < records_.size(); ++r) {
+        DrawRecord& record = records_[r];
+        if (record.instance != scaleInstance) {
+            // Largest stretch of the instance's axes, so the projected error is never underestimated
+            glm::mat4 clipFromObject = transform * models_[record.instance];
+            scale = 0.0f;
+            for (int column = 0; column < 3; ++column)
+                scale = std::max(scale, glm::length(glm::vec3(clipFromObject[column])));
+            scaleInstance = record.instance;
+        }
+        const DrawShape& shape = meshShapes[record.meshId][record.shape];
+        uint32_t level = 0;
+        if (forcedLevel >= 0) {
+            level = std::min(static_cast<uint32_t>(forcedLevel), shape.lodCount);
+        } else {
+            for (uint32_t candidate = shape.lodCount; candidate > 0; --candidate) {
+                if (shape.lods[candidate - 1].error * scale * pixelsPerUnit <= thresholdPixels) {
+                    level = candidate;
+                    break;
+                }
+            }
+        }
+
+        uint32_t firstIndex = shape.indexOffset / shape.indexSize + (level == 0 ? 0 : shape.lods[level - 1].firstIndex);
+        uint32_t count = level == 0 ? shape.indexCount : shape.lods[level - 1].indexCount;
+        DrawElementsIndirectCommand& command = commands_[record.list][record.command];
+        if (command.firstIndex != firstIndex || command.count != count) {
+            command.firstIndex = firstIndex;
+            command.count = count;
+            commandsDirty_ = true;
+            clustersCurrent_ = false;
+        }
+        record.lod = level;
+        if (record.visible) {
+            ++stats.records[level];
+            stats.triangles[level] += count / 3;
+        }
+    }
+    return stats;
+}
+
+void DrawTable::reorder(const std::vector<std::size_t>& order) {
+    std::vector<DrawElementsIndirectCommand> reordered[2];
+    for (std::size_t record : order) {
+        DrawRecord& entry = records_[record];
+        uint32_t position = static_cast<uint32_t>(reordered[entry.list].size());
+        reordered[entry.list].push_back(commands_[entry.list][entry.command]);
+        entry.command = position;
+    }
+    commands_[0] = std::move(reordered[0]);
+    commands_[1] = std::move(reordered[1]);
+    commandsDirty_ = true;
+    clustersCurrent_ = false;
+}
+
+ClusterStats DrawTable::cullClusters(const std::vector<std::vector<DrawShape>>& meshShapes, const glm::mat4& transform,
+                                     bool backfaces, ThreadPool& pool) {
+    // Blocks of records are culled in parallel, each extracting the frustum and viewer of an instance once
+    const std::size_t recordsPerBlock = 64;
+    std::size_t blocks = (records_.size() + recordsPerBlock - 1) / recordsPerBlock;
+    std::vector<std::vector<DrawElementsIndirectCommand>> runs(records_.size()); // Per record, empty to keep its command
+    std::vector<ClusterStats> blockStats(blocks);
+    pool.parallelFor(blocks, [&](std::size_t b) {
+        ClusterStats& stats = blockStats[b];
+        Frustum frustum;
+        Viewer viewer;
+        uint32_t viewInstance = UINT32_MAX;
+        std::size_t end = std::min(records_.size(), (b + 1) * recordsPerBlock);
+        for (std::size_t r = b * recordsPerBlock; r < end; ++r) {
+            const DrawRecord& record = records_[r];
+            const DrawShape& shape = meshShapes[record.meshId][record.shape];
+            if (!record.visible || record.lod != 0 || shape.meshlets.empty())
+                continue;
+            if (record.instance != viewInstance) {
+                glm::mat4 clipFromObject = transform * models_[record.instance];
+                frustum = extractFrustum(clipFromObject);
+                viewer = extractViewer(clipFromObject);
+                viewInstance = record.instance;
+            }
+
+            // Neighbouring meshlets are back to back in the index buffer, so surviving ones merge into runs
+            const DrawElementsIndirectCommand& command = commands_[record.list][record.command];
+            std::vector<DrawElementsIndirectCommand>& out = runs[r];
+            bool extend = false;
+            for (const Meshlet& meshlet : shape.meshlets) {
+                ++stats.clusters;
+                stats.triangles += meshlet.indexCount / 3;
+                bool culled = true;
+                if (!sphereVisible(frustum, meshlet.center, meshlet.radius))
+                    ++stats.frustumCulled;
+                else if (backfaces && meshletFacingAway(viewer, meshlet))
+                    ++stats.backfaceCulled;
+                else
+                    culled = false;
+                if (culled) {
+                    stats.trianglesCulled += meshlet.indexCount / 3;
+                    extend = false;
+                } else if (extend) {
+                    out.back().count += meshlet.indexCount;
+                } else {
+                    out.push_back({meshlet.indexCount, 1, command.firstIndex + meshlet.firstIndex, command.baseVertex, command.baseInstance});
+                    extend = true;
+                }
+            }
+            if (out.empty()) // Every meshlet culled: a skipped command stands in for the record
+                out.push_back({0, 0, command.firstIndex, command.baseVertex, command.baseInstance});
+        }
+    });
+
+    // Splice the runs into the lists in submission order
+    ClusterStats stats;
+    for (const ClusterStats& block : blockStats)
+        stats += block;
+    for (int list = 0; list < 2; ++list) {
+        std::vector<DrawElementsIndirectCommand> spliced;
+        spliced.reserve(commands_[list].size());
+        for (const DrawElementsIndirectCommand& command : commands_[list]) {
+            const std::vector<DrawElementsIndirectCommand>& recordRuns = runs[command.baseInstance];
+            if (recordRuns.empty())
+                spliced.push_back(command);
+            else
+                spliced.insert(spliced.end(), recordRuns.begin(), recordRuns.end());
+        }
+        if (!clustersCurrent_ || spliced.size() != clusterCommands_[list].size() ||
+            !std::equal(spliced.begin(), spliced.end(), clusterCommands_[list].begin(), sameCommand))
+            commandsDirty_ = true;
+        clusterCommands_[list] = std::move(spliced);
+    }
+    clustersCurrent_ = true;
+    return stats;
+}
+
+void DrawTable::submit() {
+    const std::size_t commandSize = sizeof(DrawElementsIndirectCommand);
+    const std::vector<DrawElementsIndirectCommand>* lists = clustersCurrent_ ? clusterCommands_ : commands_;
+    std::size_t shortCommands = lists[0].size();
+    std::size_t intCommands = lists[1].size();
+
+    if (!multiDraw_) {
+        // GL 3.3: walk the same commands, setting each record's matrix as a constant attribute
+        uint32_t currentRecord = UINT32_MAX;
+        for (int list = 0; list < 2; ++list) {
+            GLenum indexType = list == 0 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+            std::size_t indexSize = list == 0 ? 2 : 4;
+            for (const DrawElementsIndirectCommand& command : lists[list]) {
+                if (command.instanceCount == 0)
+                    continue;
+                if (command.baseInstance != currentRecord) {
+                    currentRecord = command.baseInstance;
+                    setConstantModel(drawModels_[currentRecord]); // Place this record
+                }
+                glDrawElementsBaseVertex(GL_TRIANGLES, command.count, indexType,
+                                         (void*)(uintptr_t)(command.firstIndex * indexSize), command.baseVertex); // Draw the shape's triangles
+            }
+        }
+        return;
+    }
+
+    if (commandsDirty_) {
+        // Both lists back to back in fresh ring space: every 16-bit command, then every 32-bit one.
+        // Unchanged commands stay where they are, since only a later allocation can reuse their space.
+        std::size_t bytes = (shortCommands + intCommands) * commandSize;
+        commandStream_.reserve(bytes);
+        StreamAllocation allocation = commandStream_.allocate(bytes);
+        if (shortCommands > 0)
+            std::memcpy(allocation.data, lists[0].data(), shortCommands * commandSize);
+        if (intCommands > 0)
+            std::memcpy(allocation.data + shortCommands * commandSize, lists[1].data(), intCommands * commandSize);
+        commandOffset_ = allocation.offset;
+        commandStream_.flush();
+        commandsDirty_ = false;
+    } else {
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandStream_.buffer());
+    }
+    if (shortCommands > 0)
+        glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_SHORT, (void*)(uintptr_t)commandOffset_,
+                                    static_cast<GLsizei>(shortCommands), 0);
+    if (intCommands > 0)
+        glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, (void*)(uintptr_t)(commandOffset_ + shortCommands * commandSize),
+                                    static_cast<GLsizei>(intCommands), 0);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    commandStream_.endFrame();             // Fence the commands the draws read
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <cstddef>                         // For std::size_t
+#include <cstdint>                         // Fixed-width integer types
+#include <vector>                          // For using the std::vector container
+#include <GL/glew.h>                       // GLEW library for managing OpenGL extensions
+#include <glm/glm.hpp>                     // GLM library for handling matrices and vectors
+#include "frustum.h"                       // For culling records against the view
+#include "geometry.h"                      // Draw ranges of the resident shapes
+#include "scene_manifest.h"                // Instances and their model matrices
+#include "stream_buffer.h"                 // Per-frame indirect commands
+#include "thread_pool.h"                   // Workers for culling meshlets
+#include "vertex_format.h"                 // Position decoding folded into the draw matrices
+
+// First of the four attribute locations holding the model matrix (one column each)
+const GLuint modelAttribute = 3;
+
+// Set the model matrix of the draws that follow while the model attribute array is disabled
+void setConstantModel(const glm::mat4& model);
+
+// Command layout read by glMultiDrawElementsIndirect
+struct DrawElementsIndirectCommand {
+    uint32_t count;                        // Indices to draw
+    uint32_t instanceCount;                // 1 to draw, 0 to skip
+    uint32_t firstIndex;                   // In indices, not bytes
+    int32_t baseVertex;
+    uint32_t baseInstance;                 // Record whose draw matrix the draw uses
+};
+
+// One shape of one instance
+struct DrawRecord {
+    uint32_t instance;                     // Index into the instances the table was built from
+    uint32_t meshId;
+    uint32_t shape;                        // Index into the resident shapes of meshId
+    bool visible;
+    uint32_t list;                         // 0 for 16-bit indices, 1 for 32-bit indices
+    uint32_t command;                      // Position of the record's command in its list
+    uint32_t lod;                          // Level drawn, 0 for full detail
+};
+
+// Records and triangles submitted at each level of detail in one frame, counting visible records only
+struct LodStats {
+    uint64_t records[maxLodLevels + 1] = {};
+    uint64_t triangles[maxLodLevels + 1] = {};
+
+    LodStats& operator+=(const LodStats& other);
+};
+
+// Draw table of every shape of every instance, kept as indirect commands in a GL buffer.
+// With GL 4.3 (or ARB_multi_draw_indirect and ARB_base_instance) the whole table is submitted
+// with one glMultiDrawElementsIndirect per index type and the matrices come from a per-record
+// attribute buffer selected by baseInstance. Changed commands are written to a stream buffer
+// rather than over the ones the GPU may still be reading. Otherwise the same commands are walked in a
+// glDrawElementsBaseVertex loop with the matrix set as a constant attribute. A record's draw
+// matrix is its instance's model matrix times the decoding of its shape's stored positions.
+// Hiding, showing or reordering records only rewrites commands, never geometry.
+class DrawTable {
+public:
+    // Create the indirect and matrix buffers; multi-draw is used only if allowed and supported.
+    // Positions are decoded for vertices stored in format. persistentStreaming allows the indirect
+    // commands to be streamed through a persistently mapped buffer (see StreamBuffer).
+    void create(bool allowMultiDraw, VertexFormat format = VertexFormat::Float, bool persistentStreaming = true);
+    // Delete every GL object
+    void destroy();
+
+    // Point the model attribute of the bound VAO at the per-record matrices (multi-draw only)
+    void bindModelAttribute() const;
+
+    // Rebuild the records from the resident shapes of every instance and upload the matrices
+    void rebuild(const std::vector<std::vector<DrawShape>>& meshShapes, const std::vector<ModelInstance>& instances);
+
+    // Show or hide one record; applied with the next submit()
+    void setVisible(std::size_t record, bool visible);
+    // Hide every record whose shape bounds lie outside the view of transform * instance model,
+    // show the others; meshShapes must be what the table was rebuilt from
+    CullStats cull(const std::vector<std::vector<DrawShape>>& meshShapes, const glm::mat4& transform);
+    // Draw every record at its coarsest level whose error, projected by transform * instance model
+    // with pixelsPerUnit pixels per clip-space unit, stays within thresholdPixels. forcedLevel >= 0
+    // draws every record at that level instead (or its coarsest, if it has fewer).
+    LodStats selectLods(const std::vector<std::vector<DrawShape>>& meshShapes, const glm::mat4& transform,
+                        float pixelsPerUnit, float thresholdPixels, int forcedLevel = -1);
+    // Submit records in this order from now on; order must list every record once
+    void reorder(const std::vector<std::size_t>& order);
+    // Split every visible full-detail record whose shape has meshlets into the runs of meshlets that
+    // are inside the view of transform * instance model and, with backfaces, not facing away. Records
+    // are spread over pool's threads. The runs are drawn instead of the records' commands until the
+    // next rebuild, reorder, or visibility or level change; call it after cull() and selectLods().
+    ClusterStats cullClusters(const std::vector<std::vector<DrawShape>>& meshShapes, const glm::mat4& transform,
+                              bool backfaces, ThreadPool& pool);
+
+    // Draw every visible record with the VAO that holds the shapes bound
+    void submit();
+
+    const std::vector<DrawRecord>& records() const { return records_; }
+    bool multiDrawIndirect() const { return multiDraw_; }
+    // Indirect command bytes streamed and fence waits of every submit (multi-draw only)
+    const StreamStats& streamStats() const { return commandStream_.totals(); }
+    bool persistentStreaming() const { return commandStream_.persistent(); }
+
+private:
+    StreamBuffer commandStream_;           // Indirect commands, rewritten whenever they change
+    std::size_t commandOffset_ = 0;        // Of the current commands in commandStream_
+    GLuint modelBuffer_ = 0;
+    bool multiDraw_ = false;
+    VertexFormat format_ = VertexFormat::Float;
+    std::vector<DrawRecord> records_;
+    std::vector<DrawElementsIndirectCommand> commands_[2]; // Per index type
+    std::vector<DrawElementsIndirectCommand> clusterCommands_[2]; // The same with records split into meshlet runs
+    bool clustersCurrent_ = false;         // clusterCommands_ match commands_ and are drawn instead
+    std::vector<glm::mat4> models_;        // Per instance, for culling and level selection
+    std::vector<glm::mat4> drawModels_;    // Per record, as the vertex shader receives them
+    bool commandsDirty_ = false;           // Commands changed since the last upload
+};
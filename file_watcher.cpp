@@ -0,0 +1,129 @@
+#include "file_watcher.h"
+
+#include <algorithm>                       // For std::find_if()
+#include <filesystem>                      // Parent directories and modification times
+#include <map>                             // Watch descriptor lookup
+
+#ifdef __linux__
+#include <poll.h>                          // For poll()
+#include <sys/inotify.h>                   // For inotify_*()
+#include <unistd.h>                        // For read()/close()
+#endif
+
+namespace {
+
+// Writes closer together than this are treated as one save
+const std::chrono::milliseconds settleTime(100);
+
+} // namespace
+
+FileWatcher::~FileWatcher() {
+    stopping_ = true;
+    if (thread_.joinable())
+        thread_.join();
+#ifdef __linux__
+    if (inotifyFd_ >= 0)
+        close(inotifyFd_);
+#endif
+}
+
+bool FileWatcher::start(const std::vector<std::string>& paths) {
+    paths_ = paths;
+#ifdef __linux__
+    inotifyFd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotifyFd_ < 0)
+        return false;
+#endif
+    thread_ = std::thread(&FileWatcher::run, this);
+    return true;
+}
+
+std::vector<FileChange> FileWatcher::takeChanges() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<FileChange> changes;
+    changes.swap(settled_);
+    return changes;
+}
+
+void FileWatcher::noteChange(uint32_t fileId) {
+    auto now = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto found = std::find_if(pending_.begin(), pending_.end(), [&](const FileChange& change) {
+        return change.fileId == fileId;
+    });
+    if (found == pending_.end()) {
+        pending_.push_back({fileId, now});
+        lastEvent_.push_back(now);
+    } else {
+        lastEvent_[found - pending_.begin()] = now; // Extend the settle window, keep the first timestamp
+    }
+}
+
+void FileWatcher::run() {
+#ifdef __linux__
+    // Watch each parent directory once and map file names back to file ids
+    std::map<int, std::map<std::string, std::vector<uint32_t>>> watched;
+    for (uint32_t id = 0; id < paths_.size(); ++id) {
+        std::filesystem::path path = std::filesystem::absolute(paths_[id]);
+        int wd = inotify_add_watch(inotifyFd_, path.parent_path().c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+        if (wd >= 0)
+            watched[wd][path.filename().string()].push_back(id);
+    }
+#else
+    // Without inotify, compare modification times a few times per second
+    std::vector<std::filesystem::file_time_type> modified(paths_.size());
+    for (std::size_t id = 0; id < paths_.size(); ++id) {
+        std::error_code error;
+        modified[id] = std::filesystem::last_write_time(paths_[id], error);
+    }
+#endif
+
+    while (!stopping_) {
+#ifdef __linux__
+        pollfd descriptor = {inotifyFd_, POLLIN, 0};
+        if (poll(&descriptor, 1, 50) > 0) {
+            alignas(inotify_event) char buffer[4096];
+            ssize_t length;
+            while ((length = read(inotifyFd_, buffer, sizeof(buffer))) > 0) {
+                for (char* p = buffer; p < buffer + length;) {
+                    const inotify_event* event = reinterpret_cast<const inotify_event*>(p);
+                    p += sizeof(inotify_event) + event->len;
+                    if (event->len == 0)
+                        continue;
+                    auto directory = watched.find(event->wd);
+                    if (directory == watched.end())
+                        continue;
+                    auto file = directory->second.find(event->name);
+                    if (file == directory->second.end())
+                        continue; // Something else in the same directory, e.g. the mesh cache
+                    for (uint32_t id : file->second)
+                        noteChange(id);
+                }
+            }
+        }
+#else
+        std::this_thread::sleep_for(std::chrono::milliseconds(250));
+        for (uint32_t id = 0; id < paths_.size(); ++id) {
+            std::error_code error;
+            auto time = std::filesystem::last_write_time(paths_[id], error);
+            if (!error && time != modified[id]) {
+                modified[id] = time;
+                noteChange(id);
+            }
+        }
+#endif
+
+        // Hand over the changes whose writes have settled
+        auto now = std::chrono::steady_clock::now();
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (std::size_t i = 0; i < pending_.size();) {
+            if (now - lastEvent_[i] >= settleTime) {
+                settled_.push_back(pending_[i]);
+                pending_.erase(pending_.begin() + static_cast<std::ptrdiff_t>(i));
+                lastEvent_.erase(lastEvent_.begin() + static_cast<std::ptrdiff_t>(i));
+            } else {
+                ++i;
+            }
+        }
+    }
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <atomic>                          // Stop flag for the watcher thread
+#include <chrono>                          // Change timestamps
+#include <cstdint>                         // Fixed-width integer types
+#include <mutex>                           // Guards the pending changes
+#include <string>                          // For file paths
+#include <thread>                          // Watcher thread
+#include <vector>                          // For using the std::vector container
+
+// A watched file that was rewritten
+struct FileChange {
+    uint32_t fileId;                       // Index of the file in the list given to start()
+    std::chrono::steady_clock::time_point detectedAt; // When the first write of the burst was seen
+};
+
+// Reports rewrites of a set of files. Uses inotify on the parent directories on Linux, so files
+// replaced by rename (as most exporters do) are still caught; polls modification times elsewhere.
+class FileWatcher {
+public:
+    FileWatcher() = default;
+    ~FileWatcher();
+    FileWatcher(const FileWatcher&) = delete;
+    FileWatcher& operator=(const FileWatcher&) = delete;
+
+    // Start watching paths on a background thread, returns false if watching is not possible
+    bool start(const std::vector<std::string>& paths);
+
+    // Take the files whose writes have settled since the last call
+    std::vector<FileChange> takeChanges();
+
+private:
+    void run();
+    void noteChange(uint32_t fileId);
+
+    std::vector<std::string> paths_;
+    std::thread thread_;
+    std::atomic<bool> stopping_{false};
+    std::mutex mutex_;
+    std::vector<FileChange> pending_;      // Changes still inside the settle window
+    std::vector<std::chrono::steady_clock::time_point> lastEvent_; // Latest event per pending change
+    std::vector<FileChange> settled_;      // Changes ready for takeChanges()
+    int inotifyFd_ = -1;
+};
@@ -0,0 +1,146 @@
+#include "frame_timing.h"
+
+#include <algorithm>                       // For std::min()/std::max()
+#include <cmath>                           // For std::log2()/std::exp2()
+#include <cstdio>                          // For std::snprintf()
+
+namespace {
+
+// Buckets of RollingHistogram: bucket 0 holds everything under 1 us, bucket b > 0 the durations
+// from 2^((b - 1) / 8) to 2^(b / 8) us, and the last one everything longer
+const int bucketsPerOctave = 8;
+const int bucketCount = 1 + 21 * bucketsPerOctave;
+
+int bucketOf(double millis) {
+    double micros = millis * 1000.0;
+    if (!(micros >= 1.0))
+        return 0;
+    return std::min(bucketCount - 1, 1 + static_cast<int>(std::log2(micros) * bucketsPerOctave));
+}
+
+// Geometric middle of a bucket, in milliseconds
+double bucketMillis(int bucket) {
+    if (bucket == 0)
+        return 0.0005;
+    return std::exp2((bucket - 0.5) / bucketsPerOctave) / 1000.0;
+}
+
+} // namespace
+
+const char* framePhaseName(FramePhase phase) {
+    switch (phase) {
+    case FramePhase::Input: return "input";
+    case FramePhase::Upload: return "upload";
+    case FramePhase::Update: return "update";
+    case FramePhase::Draw: return "draw";
+    case FramePhase::Capture: return "capture";
+    case FramePhase::Present: return "present";
+    case FramePhase::Count: break;
+    }
+    return "?";
+}
+
+RollingHistogram::RollingHistogram(std::size_t window) : counts_(bucketCount, 0), recent_(std::max<std::size_t>(window, 1), 0) {}
+
+void RollingHistogram::add(double millis) {
+    if (size_ == recent_.size())
+        --counts_[recent_[next_]];
+    else
+        ++size_;
+    int bucket = bucketOf(millis);
+    recent_[next_] = static_cast<uint16_t>(bucket);
+    ++counts_[bucket];
+    next_ = (next_ + 1) % recent_.size();
+}
+
+double RollingHistogram::percentile(double fraction) const {
+    if (size_ == 0)
+        return 0.0;
+    // Smallest bucket holding at least ceil(fraction * size_) samples at or below it
+    std::size_t rank = std::max<std::size_t>(1, static_cast<std::size_t>(std::ceil(fraction * size_)));
+    std::size_t seen = 0;
+    for (int bucket = 0; bucket < bucketCount; ++bucket) {
+        seen += counts_[bucket];
+        if (seen >= rank)
+            return bucketMillis(bucket);
+    }
+    return bucketMillis(bucketCount - 1);
+}
+
+#if defined(FRAME_TIMING)
+
+void FrameTiming::createQueries() {
+    glGenQueries(2 * framePhaseCount, &queries_[0][0]);
+    haveQueries_ = true;
+}
+
+void FrameTiming::destroyQueries() {
+    if (!haveQueries_)
+        return;
+    glDeleteQueries(2 * framePhaseCount, &queries_[0][0]);
+    haveQueries_ = false;
+}
+
+void FrameTiming::beginFrame() {
+    Clock::time_point now = Clock::now();
+    if (started_)
+        frame_.add(std::chrono::duration<double, std::milli>(now - frameStart_).count());
+    frameStart_ = now;
+    started_ = true;
+
+    // This frame reuses the queries of the frame before last, so read their results first
+    set_ ^= 1;
+    for (std::size_t phase = 0; phase < framePhaseCount; ++phase) {
+        if (!pending_[set_][phase])
+            continue;
+        pending_[set_][phase] = false;
+        GLint available = 0;
+        glGetQueryObjectiv(queries_[set_][phase], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available) {
+            ++gpuDropped_;
+            continue;
+        }
+        GLuint64 nanoseconds = 0;
+        glGetQueryObjectui64v(queries_[set_][phase], GL_QUERY_RESULT, &nanoseconds);
+        gpu_[phase].add(nanoseconds / 1e6);
+    }
+}
+
+void FrameTiming::endCpu(FramePhase phase) {
+    cpu_[index(phase)].add(std::chrono::duration<double, std::milli>(Clock::now() - cpuStart_[index(phase)]).count());
+}
+
+void FrameTiming::beginGpu(FramePhase phase) {
+    if (haveQueries_)
+        glBeginQuery(GL_TIME_ELAPSED, queries_[set_][index(phase)]);
+}
+
+void FrameTiming::endGpu(FramePhase phase) {
+    if (!haveQueries_)
+        return;
+    glEndQuery(GL_TIME_ELAPSED);
+    pending_[set_][index(phase)] = true;
+}
+
+void FrameTiming::report(std::ostream& out) const {
+    char line[96];
+    out << "Frame timing over the last " << frame_.count() << " frames (ms):" << std::endl;
+    std::snprintf(line, sizeof(line), "  %-12s %9s %9s %9s", "phase", "p50", "p95", "p99");
+    out << line << std::endl;
+    auto row = [&](const char* name, const char* unit, const RollingHistogram& histogram) {
+        if (histogram.count() == 0)
+            return;
+        std::snprintf(line, sizeof(line), "  %-8s %-3s %9.3f %9.3f %9.3f", name, unit, histogram.percentile(0.5),
+                      histogram.percentile(0.95), histogram.percentile(0.99));
+        out << line << std::endl;
+    };
+    row("frame", "cpu", frame_);
+    for (std::size_t phase = 0; phase < framePhaseCount; ++phase)
+        row(framePhaseName(static_cast<FramePhase>(phase)), "cpu", cpu_[phase]);
+    for (std::size_t phase = 0; phase < framePhaseCount; ++phase)
+        row(framePhaseName(static_cast<FramePhase>(phase)), "gpu", gpu_[phase]);
+    if (gpuDropped_ > 0)
+        out << "  " << gpuDropped_ << " GPU results were not ready two frames later and were dropped" << std::endl;
+}
+
+#endif
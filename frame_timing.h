@@ -0,0 +1,129 @@
+#pragma once
+
+#include <chrono>                          // For the CPU phase timers
+#include <cstddef>                         // For std::size_t
+#include <cstdint>                         // Fixed-width integer types
+#include <ostream>                         // For report()
+#include <vector>                          // For using the std::vector container
+#include <GL/glew.h>                       // GLEW library for managing OpenGL extensions
+
+// Parts of a frame of the GL render loop, timed separately
+enum class FramePhase {
+    Input,                                 // Events, keyboard or script, simulation ticks, picking
+    Upload,                                // Loaded, paged and reloaded geometry copied to the GPU
+    Update,                                // Transform uniform, culling and level of detail selection
+    Draw,                                  // Clear and draw calls
+    Capture,                               // Reading back, writing and comparing frame files
+    Present,                               // Swapping buffers (glFinish when headless)
+    Count
+};
+
+const std::size_t framePhaseCount = static_cast<std::size_t>(FramePhase::Count);
+const char* framePhaseName(FramePhase phase);
+
+// Frames kept by the rolling histograms of FrameTiming
+const std::size_t frameTimingWindow = 1024;
+
+// Durations of the last window samples, counted in buckets spaced 8 to an octave from 1 us to
+// about 2 s, so adding a sample and reading a percentile never sort or allocate
+class RollingHistogram {
+public:
+    explicit RollingHistogram(std::size_t window = frameTimingWindow);
+
+    void add(double millis);
+    // Duration in milliseconds that fraction of the window's samples do not exceed, to within the
+    // 9% width of a bucket; 0 when empty
+    double percentile(double fraction) const;
+    // Samples in the window
+    std::size_t count() const { return size_; }
+
+private:
+    std::vector<uint32_t> counts_;         // Per bucket
+    std::vector<uint16_t> recent_;         // Bucket of every sample in the window, as a ring
+    std::size_t next_ = 0;                 // Slot of recent_ the next sample replaces
+    std::size_t size_ = 0;
+};
+
+#if defined(FRAME_TIMING)
+
+// CPU time of every phase and of the whole frame, and GPU time of the phases that ask for it, kept in
+// rolling histograms. GPU phases are bracketed by GL_TIME_ELAPSED queries in two sets used on
+// alternate frames: a set's results are read two frames later, when the GPU has normally finished
+// them, and a result that is still not available is dropped rather than waited for. Timer queries
+// cannot nest, so GPU phases must not overlap. Build with -DFRAME_TIMING=ON to enable; otherwise
+// every member below is an empty inline function and the timers compile to nothing.
+class FrameTiming {
+public:
+    static constexpr bool enabled = true;
+
+    // Create the GPU queries; needs a current GL context. Without them only CPU time is measured.
+    void createQueries();
+    void destroyQueries();
+
+    // Start a frame, ending the previous one, and collect the GPU times of the frame before that
+    void beginFrame();
+    void beginCpu(FramePhase phase) { cpuStart_[index(phase)] = Clock::now(); }
+    void endCpu(FramePhase phase);
+    void beginGpu(FramePhase phase);
+    void endGpu(FramePhase phase);
+
+    // Print the 50th, 95th and 99th percentiles of every phase timed so far
+    void report(std::ostream& out) const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    static std::size_t index(FramePhase phase) { return static_cast<std::size_t>(phase); }
+
+    Clock::time_point frameStart_;
+    bool started_ = false;
+    Clock::time_point cpuStart_[framePhaseCount];
+    RollingHistogram frame_;
+    RollingHistogram cpu_[framePhaseCount];
+    RollingHistogram gpu_[framePhaseCount];
+    GLuint queries_[2][framePhaseCount] = {};
+    bool pending_[2][framePhaseCount] = {}; // Query issued and its result not yet read
+    bool haveQueries_ = false;
+    unsigned set_ = 0;                     // Query set of this frame
+    uint64_t gpuDropped_ = 0;              // Results not available two frames later
+};
+
+#else
+
+class FrameTiming {
+public:
+    static constexpr bool enabled = false;
+
+    void createQueries() {}
+    void destroyQueries() {}
+    void beginFrame() {}
+    void beginCpu(FramePhase) {}
+    void endCpu(FramePhase) {}
+    void beginGpu(FramePhase) {}
+    void endGpu(FramePhase) {}
+    void report(std::ostream&) const {}
+};
+
+#endif
+
+// Times the enclosing scope as phase on the CPU and, with gpu, on the GPU as well
+class PhaseTimer {
+public:
+    PhaseTimer(FrameTiming& timing, FramePhase phase, bool gpu = false) : timing_(timing), phase_(phase), gpu_(gpu) {
+        timing_.beginCpu(phase_);
+        if (gpu_)
+            timing_.beginGpu(phase_);
+    }
+    ~PhaseTimer() {
+        if (gpu_)
+            timing_.endGpu(phase_);
+        timing_.endCpu(phase_);
+    }
+    PhaseTimer(const PhaseTimer&) = delete;
+    PhaseTimer& operator=(const PhaseTimer&) = delete;
+
+private:
+    FrameTiming& timing_;
+    FramePhase phase_;
+    bool gpu_;
+};
@@ -0,0 +1,108 @@
+#include "frustum.h"
+
+#include <cmath>                           // For std::sqrt()/std::abs()
+
+CullStats& CullStats::operator+=(const CullStats& other) {
+    objects += other.objects;
+    objectsCulled += other.objectsCulled;
+    triangles += other.triangles;
+    trianglesCulled += other.trianglesCulled;
+    return *this;
+}
+
+ClusterStats& ClusterStats::operator+=(const ClusterStats& other) {
+    clusters += other.clusters;
+    frustumCulled += other.frustumCulled;
+    backfaceCulled += other.backfaceCulled;
+    triangles += other.triangles;
+    trianglesCulled += other.trianglesCulled;
+    return *this;
+}
+
+Frustum extractFrustum(const glm::mat4& clipFromObject) {
+    // glm is column-major, so row i is (m[0][i], m[1][i], m[2][i], m[3][i])
+    auto row = [&](int i) {
+        return glm::vec4(clipFromObject[0][i], clipFromObject[1][i], clipFromObject[2][i], clipFromObject[3][i]);
+    };
+    glm::vec4 x = row(0), y = row(1), z = row(2), w = row(3);
+
+    Frustum frustum;
+    frustum.planes[0] = w + x;             // Left:   -w <= x
+    frustum.planes[1] = w - x;             // Right:   x <= w
+    frustum.planes[2] = w + y;             // Bottom: -w <= y
+    frustum.planes[3] = w - y;             // Top:     y <= w
+    frustum.planes[4] = w + z;             // Near:   -w <= z
+    frustum.planes[5] = w - z;             // Far:     z <= w
+
+    // Unit normals make dot(xyz, p) + w a distance the sphere radius can be compared with
+    for (glm::vec4& plane : frustum.planes) {
+        float length = std::sqrt(plane.x * plane.x + plane.y * plane.y + plane.z * plane.z);
+        if (length > 0.0f)
+            plane /= length;
+    }
+    return frustum;
+}
+
+bool boundsVisible(const Frustum& frustum, const Bounds& bounds) {
+    bool straddles = false;
+    for (const glm::vec4& plane : frustum.planes) {
+        float distance = plane.x * bounds.center[0] + plane.y * bounds.center[1] + plane.z * bounds.center[2] + plane.w;
+        if (distance < -bounds.radius)
+            return false;                  // Sphere entirely outside this plane
+        if (distance < bounds.radius)
+            straddles = true;
+    }
+    if (!straddles)
+        return true;                       // Sphere entirely inside every plane
+
+    // The sphere straddles a plane: test the box corner furthest along each plane's normal
+    for (const glm::vec4& plane : frustum.planes) {
+        float px = plane.x >= 0.0f ? bounds.max[0] : bounds.min[0];
+        float py = plane.y >= 0.0f ? bounds.max[1] : bounds.min[1];
+        float pz = plane.z >= 0.0f ? bounds.max[2] : bounds.min[2];
+        if (plane.x * px + plane.y * py + plane.z * pz + plane.w < 0.0f)
+            return false;
+    }
+    return true;
+}
+
+bool sphereVisible(const Frustum& frustum, const float center[3], float radius) {
+    for (const glm::vec4& plane : frustum.planes) {
+        if (plane.x * center[0] + plane.y * center[1] + plane.z * center[2] + plane.w < -radius)
+            return false;
+    }
+    return true;
+}
+
+Viewer extractViewer(const glm::mat4& clipFromObject) {
+    // The eye projects to (0, 0, z, 0); scaled so that the winding rule below holds for either sign
+    glm::vec4 eye = glm::inverse(clipFromObject) * glm::vec4(0.0f, 0.0f, -1.0f, 0.0f);
+    float determinant = glm::determinant(clipFromObject);
+    glm::vec3 direction(eye);
+    Viewer viewer;
+    if (std::abs(eye.w) <= 1e-6f * glm::length(direction)) {
+        viewer.facing = determinant < 0.0f ? 1.0f : -1.0f;
+        viewer.position = glm::normalize(direction) * viewer.facing;
+        viewer.atInfinity = true;
+        viewer.facing = 1.0f;              // Folded into the direction
+    } else {
+        viewer.position = direction / eye.w;
+        viewer.atInfinity = false;
+        viewer.facing = determinant * eye.w < 0.0f ? 1.0f : -1.0f;
+    }
+    return viewer;
+}
+
+bool meshletFacingAway(const Viewer& viewer, const Meshlet& meshlet) {
+    glm::vec3 axis(meshlet.coneAxis[0], meshlet.coneAxis[1], meshlet.coneAxis[2]);
+    if (meshlet.coneSin >= 1.0f || axis == glm::vec3(0.0f))
+        return false;                      // Normals spread over a half space or more
+    if (viewer.atInfinity)
+        return glm::dot(axis, viewer.position) <= -meshlet.coneSin;
+
+    // Every point q of the sphere and normal n of the cone must see the viewer behind the surface:
+    // the angle between n and q - viewer stays below 90 degrees minus the cone's spread
+    glm::vec3 center(meshlet.center[0], meshlet.center[1], meshlet.center[2]);
+    glm::vec3 offset = viewer.position - center;
+    return viewer.facing * glm::dot(offset, axis) + meshlet.coneSin * (glm::length(offset) + meshlet.radius) + meshlet.radius <= 0.0f;
+}
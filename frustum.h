@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>                         // Fixed-width integer types
+#include <glm/glm.hpp>                     // GLM library for handling matrices and vectors
+#include "geometry.h"                      // Bounding volumes to test
+
+// Six planes (x, y, z, w) with the inside where dot(xyz, p) + w >= 0: left, right, bottom, top, near, far
+struct Frustum {
+    glm::vec4 planes[6];
+};
+
+// Objects and triangles submitted and skipped in one frame
+struct CullStats {
+    uint64_t objects = 0;                  // Shapes (or pages) considered
+    uint64_t objectsCulled = 0;
+    uint64_t triangles = 0;                // Triangles of the objects considered
+    uint64_t trianglesCulled = 0;
+
+    CullStats& operator+=(const CullStats& other);
+};
+
+// Meshlets of the full-detail records submitted and skipped in one frame
+struct ClusterStats {
+    uint64_t clusters = 0;                 // Meshlets considered
+    uint64_t frustumCulled = 0;            // Outside the view
+    uint64_t backfaceCulled = 0;           // Inside the view but facing away
+    uint64_t triangles = 0;                // Triangles of the meshlets considered
+    uint64_t trianglesCulled = 0;
+
+    ClusterStats& operator+=(const ClusterStats& other);
+};
+
+// Camera of a clip transform in the space that matrix maps from: a position, or a direction towards the
+// camera for parallel projections. A triangle with normal n is front facing when facing * dot(n, position - p)
+// > 0 for any corner p, or when facing * dot(n, position) > 0 at infinity; facing folds in mirroring
+// transforms and the sign of the homogeneous eye.
+struct Viewer {
+    glm::vec3 position;
+    bool atInfinity;
+    float facing;                          // 1 or -1
+};
+
+// Planes of the clip volume of clipFromObject, in the space that matrix maps from (Gribb and Hartmann).
+// Passing transform * model gives object-space planes, so bounds are tested without being transformed.
+Frustum extractFrustum(const glm::mat4& clipFromObject);
+
+// False only when bounds lie entirely outside one plane: the sphere first, then the box
+bool boundsVisible(const Frustum& frustum, const Bounds& bounds);
+
+// False when the sphere lies entirely outside one plane
+bool sphereVisible(const Frustum& frustum, const float center[3], float radius);
+
+// Viewer of clipFromObject, the point (or direction) the matrix projects to the centre of projection
+Viewer extractViewer(const glm::mat4& clipFromObject);
+
+// True when every triangle of meshlet faces away from viewer wherever it lies within the meshlet's
+// sphere, so the whole cluster would be back-face culled
+bool meshletFacingAway(const Viewer& viewer, const Meshlet& meshlet);
@@ -0,0 +1,265 @@
+#include "geometry.h"
+
+#include <algorithm>                       // For std::min()/std::max()
+#include <cmath>                           // For std::sqrt()
+#include <cstring>                         // For std::memcpy()
+#include <iostream>                        // Standard input/output stream library
+#include <unordered_map>                   // Index triple -> vertex lookup
+#include "mesh_optimizer.h"                // Vertex cache and fetch order
+#include "meshlets.h"                      // Clusters for culling
+#include "simplify.h"                      // LOD levels
+
+namespace {
+
+Vertex makeVertex(const Mesh& mesh, const MeshIndex& index) {
+    Vertex vertex = {};
+    std::memcpy(vertex.position, &mesh.positions[3 * std::size_t(index.vertex)], sizeof(vertex.position));
+    if (index.normal >= 0)
+        std::memcpy(vertex.normal, &mesh.normals[3 * std::size_t(index.normal)], sizeof(vertex.normal));
+    if (index.texcoord >= 0)
+        std::memcpy(vertex.texcoord, &mesh.texcoords[2 * std::size_t(index.texcoord)], sizeof(vertex.texcoord));
+    return vertex;
+}
+
+// Hash a byte range eight bytes at a time; only used to tell whether a shape changed
+uint64_t hashBytes(const void* data, std::size_t size, uint64_t seed) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    uint64_t hash = seed ^ (size * 0x9E3779B97F4A7C15ull);
+    std::size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        uint64_t word;
+        std::memcpy(&word, bytes + i, 8);
+        hash = (hash ^ word) * 0xFF51AFD7ED558CCDull;
+        hash ^= hash >> 32;
+    }
+    for (; i < size; ++i)
+        hash = (hash ^ bytes[i]) * 0x100000001B3ull;
+    return hash ^ (hash >> 29);
+}
+
+} // namespace
+
+GeometryStats& GeometryStats::operator+=(const GeometryStats& other) {
+    corners += other.corners;
+    vertices += other.vertices;
+    vertexBytes += other.vertexBytes;
+    indexBytes += other.indexBytes;
+    vertexShaderInvocations += other.vertexShaderInvocations;
+    unoptimizedInvocations += other.unoptimizedInvocations;
+    meshlets += other.meshlets;
+    meshletTriangles += other.meshletTriangles;
+    shapeCache.insert(shapeCache.end(), other.shapeCache.begin(), other.shapeCache.end());
+    for (unsigned level = 0; level <= maxLodLevels; ++level) {
+        lodTriangles[level] += other.lodTriangles[level];
+        lodError[level] = std::max(lodError[level], other.lodError[level]);
+    }
+    return *this;
+}
+
+Bounds computeBounds(const Vertex* vertices, std::size_t count) {
+    Bounds bounds = {};
+    if (count == 0)
+        return bounds;
+    for (int axis = 0; axis < 3; ++axis)
+        bounds.min[axis] = bounds.max[axis] = vertices[0].position[axis];
+    for (std::size_t i = 1; i < count; ++i) {
+        for (int axis = 0; axis < 3; ++axis) {
+            bounds.min[axis] = std::min(bounds.min[axis], vertices[i].position[axis]);
+            bounds.max[axis] = std::max(bounds.max[axis], vertices[i].position[axis]);
+        }
+    }
+
+    // Centre the sphere on the box but size it from the vertices, which is tighter than the box's corners
+    float radiusSquared = 0.0f;
+    for (int axis = 0; axis < 3; ++axis)
+        bounds.center[axis] = 0.5f * (bounds.min[axis] + bounds.max[axis]);
+    for (std::size_t i = 0; i < count; ++i) {
+        float dx = vertices[i].position[0] - bounds.center[0];
+        float dy = vertices[i].position[1] - bounds.center[1];
+        float dz = vertices[i].position[2] - bounds.center[2];
+        radiusSquared = std::max(radiusSquared, dx * dx + dy * dy + dz * dz);
+    }
+    bounds.radius = std::sqrt(radiusSquared);
+    return bounds;
+}
+
+Bounds boxBounds(const float min[3], const float max[3]) {
+    Bounds bounds;
+    float radiusSquared = 0.0f;
+    for (int axis = 0; axis < 3; ++axis) {
+        bounds.min[axis] = min[axis];
+        bounds.max[axis] = max[axis];
+        bounds.center[axis] = 0.5f * (min[axis] + max[axis]);
+        float half = 0.5f * (max[axis] - min[axis]);
+        radiusSquared += half * half;
+    }
+    bounds.radius = std::sqrt(radiusSquared);
+    return bounds;
+}
+
+std::size_t DrawShape::indexBytes() const {
+    std::size_t count = indexCount;
+    for (uint32_t level = 0; level < lodCount; ++level)
+        count += lods[level].indexCount;
+    return count * indexSize;
+}
+
+void appendIndexedShape(IndexedGeometry& geometry, const Mesh& mesh, const MeshShape& source, unsigned lodLevels,
+                        bool optimize, bool meshlets) {
+    std::unordered_map<MeshIndex, uint32_t, MeshIndexHash, MeshIndexEqual> lookup;
+    std::vector<uint32_t> local;
+    local.reserve(source.indexCount);
+    DrawShape shape = {source.name, 0, static_cast<uint32_t>(geometry.vertices.size()), 0, 0, source.indexCount, 4, 0, 0, 0, {}, 0, {}, 0, {}};
+
+    // Vertices are numbered in first-use order, which keeps the fetch order close to the draw order
+    for (uint32_t i = 0; i < source.indexCount; ++i) {
+        const MeshIndex& index = mesh.indices[source.firstIndex + i];
+        auto inserted = lookup.emplace(index, static_cast<uint32_t>(lookup.size()));
+        if (inserted.second)
+            geometry.vertices.push_back(makeVertex(mesh, index));
+        local.push_back(inserted.first->second);
+    }
+    shape.vertexCount = static_cast<uint32_t>(lookup.size());
+    shape.indexSize = shape.vertexCount <= 65536 ? 2 : 4;
+
+    // Reorder the triangles for the post-transform cache and group them into meshlets, which starts each
+    // meshlet where the cache order stands, then renumber the vertices in the final first-use order
+    if (optimize) {
+        shape.unoptimizedMisses = static_cast<uint32_t>(countCacheMisses(local.data(), local.size(), shape.vertexCount, vertexCacheSize));
+        optimizeVertexCache(local.data(), local.size(), shape.vertexCount);
+    }
+    if (meshlets)
+        shape.meshlets = buildMeshlets(local.data(), local.size(), &geometry.vertices[shape.baseVertex], shape.vertexCount);
+    if (optimize) {
+        std::vector<uint32_t> remap(shape.vertexCount);
+        optimizeVertexFetch(local.data(), local.size(), shape.vertexCount, remap.data());
+        std::vector<Vertex> reordered(shape.vertexCount);
+        for (uint32_t v = 0; v < shape.vertexCount; ++v)
+            reordered[remap[v]] = geometry.vertices[shape.baseVertex + v];
+        std::copy(reordered.begin(), reordered.end(), geometry.vertices.begin() + shape.baseVertex);
+    }
+
+    // Simplified levels go after the full-detail indices; stop once a level barely shrinks
+    const uint32_t minLodIndices = 3 * 32; // Smaller shapes are not worth a level
+    if (lodLevels > 0 && shape.indexCount >= minLodIndices) {
+        Simplifier simplifier(&geometry.vertices[shape.baseVertex], shape.vertexCount, local.data(), local.size());
+        std::size_t previous = local.size();
+        for (unsigned level = 0; level < std::min(lodLevels, maxLodLevels); ++level) {
+            std::size_t target = previous / 6 * 3; // Half the triangles
+            const std::vector<uint32_t>& simplified = simplifier.simplify(target, 3.4e38f);
+            if (simplified.empty() || simplified.size() * 5 > previous * 4)
+                break;
+            shape.lods[level] = {static_cast<uint32_t>(local.size()), static_cast<uint32_t>(simplified.size()), simplifier.error()};
+            ++shape.lodCount;
+            local.insert(local.end(), simplified.begin(), simplified.end());
+            if (optimize) // Levels share the full-detail vertices, so only their triangle order can change
+                optimizeVertexCache(&local[shape.lods[level].firstIndex], simplified.size(), shape.vertexCount);
+            previous = simplified.size();
+        }
+    }
+
+    // Keep every shape 4-byte aligned so 32-bit shapes can follow 16-bit ones
+    geometry.indexData.resize((geometry.indexData.size() + 3) & ~std::size_t(3));
+    shape.indexOffset = static_cast<uint32_t>(geometry.indexData.size());
+    geometry.indexData.resize(geometry.indexData.size() + local.size() * shape.indexSize);
+    uint8_t* out = geometry.indexData.data() + shape.indexOffset;
+    for (std::size_t i = 0; i < local.size(); ++i) {
+        if (shape.indexSize == 2) {
+            uint16_t value = static_cast<uint16_t>(local[i]);
+            std::memcpy(out + 2 * std::size_t(i), &value, 2);
+        } else {
+            std::memcpy(out + 4 * std::size_t(i), &local[i], 4);
+        }
+    }
+    uint64_t hash = hashBytes(&geometry.vertices[shape.baseVertex], std::size_t(shape.vertexCount) * sizeof(Vertex), shape.indexSize);
+    shape.contentHash = hashBytes(out, shape.indexBytes(), hash);
+    shape.vertexCapacity = shape.vertexCount;
+    shape.indexCapacity = static_cast<uint32_t>(shape.indexBytes());
+    shape.bounds = computeBounds(&geometry.vertices[shape.baseVertex], shape.vertexCount);
+    geometry.shapes.push_back(std::move(shape));
+}
+
+IndexedGeometry buildIndexedGeometry(const Mesh& mesh, unsigned lodLevels, bool optimize, bool meshlets) {
+    IndexedGeometry geometry;
+    for (const MeshShape& source : mesh.shapes)
+        appendIndexedShape(geometry, mesh, source, lodLevels, optimize, meshlets);
+    return geometry;
+}
+
+uint32_t shapeIndex(const IndexedGeometry& geometry, const DrawShape& shape, std::size_t i) {
+    const uint8_t* data = geometry.indexData.data() + shape.indexOffset;
+    if (shape.indexSize == 2) {
+        uint16_t value;
+        std::memcpy(&value, data + 2 * i, 2);
+        return value;
+    }
+    uint32_t value;
+    std::memcpy(&value, data + 4 * i, 4);
+    return value;
+}
+
+uint64_t simulateVertexCache(const IndexedGeometry& geometry, const DrawShape& shape, unsigned cacheSize) {
+    std::vector<uint32_t> indices(shape.indexCount);
+    for (std::size_t i = 0; i < shape.indexCount; ++i)
+        indices[i] = shapeIndex(geometry, shape, i);
+    return countCacheMisses(indices.data(), indices.size(), shape.vertexCount, cacheSize);
+}
+
+GeometryStats measureGeometry(const IndexedGeometry& geometry) {
+    GeometryStats stats;
+    for (const DrawShape& shape : geometry.shapes) {
+        stats.corners += shape.indexCount;
+        uint64_t misses = simulateVertexCache(geometry, shape, vertexCacheSize);
+        uint64_t unoptimized = shape.unoptimizedMisses != 0 ? shape.unoptimizedMisses : misses;
+        stats.vertexShaderInvocations += misses;
+        stats.unoptimizedInvocations += unoptimized;
+        if (shape.unoptimizedMisses != 0)
+            stats.shapeCache.push_back({shape.name, shape.indexCount / 3, shape.vertexCount, unoptimized, misses});
+        if (!shape.meshlets.empty()) {
+            stats.meshlets += shape.meshlets.size();
+            stats.meshletTriangles += shape.indexCount / 3;
+        }
+
+        // A shape without a level counts its full detail there, as the renderer would draw it
+        for (unsigned level = 0; level <= maxLodLevels; ++level) {
+            uint32_t available = std::min<uint32_t>(level, shape.lodCount);
+            stats.lodTriangles[level] += (available == 0 ? shape.indexCount : shape.lods[available - 1].indexCount) / 3;
+            if (available > 0)
+                stats.lodError[level] = std::max(stats.lodError[level], shape.lods[available - 1].error);
+        }
+    }
+    stats.vertices = geometry.vertices.size();
+    stats.vertexBytes = geometry.vertices.size() * sizeof(Vertex);
+    stats.indexBytes = geometry.indexData.size();
+    return stats;
+}
+
+void printGeometryStats(const GeometryStats& stats) {
+    std::cout << "Indexed geometry: " << stats.vertices << " vertices for " << stats.corners << " corners\n"
+              << "  VBO " << stats.vertexBytes << " bytes + EBO " << stats.indexBytes
+              << " bytes (de-indexed VBO: " << stats.corners * sizeof(Vertex) << " bytes with the same layout, "
+              << stats.corners * 3 * sizeof(float) << " bytes positions only)\n"
+              << "  vertex shader invocations: ~" << stats.vertexShaderInvocations
+              << " with glDrawElements (32-entry FIFO estimate) vs " << stats.corners << " with glDrawArrays\n";
+    if (!stats.shapeCache.empty()) {
+        std::cout << "  vertex cache optimisation: ~" << stats.unoptimizedInvocations << " -> ~"
+                  << stats.vertexShaderInvocations << " invocations\n";
+        for (const ShapeCacheStats& shape : stats.shapeCache) {
+            std::cout << "    " << shape.name << ": ACMR " << shape.acmr(shape.missesBefore) << " -> "
+                      << shape.acmr(shape.missesAfter) << ", ATVR " << shape.atvr(shape.missesBefore) << " -> "
+                      << shape.atvr(shape.missesAfter) << " (" << shape.triangles << " triangles)\n";
+        }
+    }
+    if (stats.meshlets > 0) {
+        std::cout << "  meshlets: " << stats.meshlets << " (" << double(stats.meshletTriangles) / stats.meshlets
+                  << " triangles on average, at most " << maxMeshletVertices << " vertices / " << maxMeshletTriangles
+                  << " triangles)\n";
+    }
+    if (stats.lodTriangles[1] < stats.lodTriangles[0]) {
+        std::cout << "  LOD triangles:";
+        for (unsigned level = 0; level <= maxLodLevels; ++level)
+            std::cout << (level == 0 ? " " : ", ") << stats.lodTriangles[level] << " (error " << stats.lodError[level] << ")";
+        std::cout << '\n';
+    }
+    std::cout << std::flush;
+}
@@ -0,0 +1,153 @@
+#pragma once
+
+#include <cstddef>                         // For std::size_t
+#include <cstdint>                         // Fixed-width integer types
+#include <string>                          // For shape names
+#include <vector>                          // For using the std::vector container
+#include "mesh.h"                          // Source triangles
+
+// Interleaved vertex as stored in the VBO
+struct Vertex {
+    float position[3];                     // Attribute location 0
+    float normal[3];                       // Attribute location 1, zero when the OBJ has no normal
+    float texcoord[2];                     // Attribute location 2, zero when the OBJ has no texcoord
+};
+
+// Hash of an OBJ index triple for the deduplication maps
+struct MeshIndexHash {
+    std::size_t operator()(const MeshIndex& index) const {
+        uint64_t key = uint64_t(uint32_t(index.vertex)) * 0x9E3779B97F4A7C15ull;
+        key ^= (uint64_t(uint32_t(index.normal)) + 0x632BE59BD9B4E019ull) * 0xC2B2AE3D27D4EB4Full;
+        key ^= (uint64_t(uint32_t(index.texcoord)) + 0x94D049BB133111EBull) * 0x165667B19E3779F9ull;
+        return static_cast<std::size_t>(key ^ (key >> 29));
+    }
+};
+
+struct MeshIndexEqual {
+    bool operator()(const MeshIndex& a, const MeshIndex& b) const {
+        return a.vertex == b.vertex && a.normal == b.normal && a.texcoord == b.texcoord;
+    }
+};
+
+// Object-space bounding volumes of a set of vertices
+struct Bounds {
+    float min[3];                          // Axis-aligned box
+    float max[3];
+    float center[3];                       // Sphere around the box centre enclosing every vertex
+    float radius;
+};
+
+// Most simplified levels a shape can carry besides its full-detail triangles
+const unsigned maxLodLevels = 4;
+
+// Simplified version of a shape, drawn with the shape's vertices and index size
+struct LodLevel {
+    uint32_t firstIndex;                   // In indices from the shape's indexOffset
+    uint32_t indexCount;
+    float error;                           // Simplifier error of the level (see Simplifier::error()), object units
+};
+
+// Limits of a meshlet, sized so a cluster's vertices and triangles fit in one mesh shader workgroup
+const uint32_t maxMeshletVertices = 64;
+const uint32_t maxMeshletTriangles = 124;
+
+// Cluster of neighbouring full-detail triangles of a shape, drawn as one index range
+struct Meshlet {
+    uint32_t firstIndex;                   // In indices from the shape's indexOffset; meshlets follow each other
+    uint32_t indexCount;
+    float center[3];                       // Bounding sphere of the meshlet's vertices
+    float radius;
+    float coneAxis[3];                     // Unit mean of the triangle normals, zero when the cone cannot cull
+    float coneSin;                         // Sine of the largest angle between a triangle normal and the axis
+};
+
+// One shape's slice of the shared vertex and element buffers, drawn with glDrawElementsBaseVertex
+struct DrawShape {
+    std::string name;                      // Object name from the OBJ
+    uint32_t meshId;                       // Model file the shape belongs to (Scene::modelFiles)
+    uint32_t baseVertex;                   // First vertex of the shape in the VBO; indices are relative to it
+    uint32_t vertexCount;                  // Unique vertices of the shape
+    uint32_t indexOffset;                  // Byte offset of the first index in the EBO
+    uint32_t indexCount;                   // Number of indices (three per triangle)
+    uint32_t indexSize;                    // 2 for GL_UNSIGNED_SHORT, 4 for GL_UNSIGNED_INT
+    uint64_t contentHash;                  // Hash of the shape's vertices and indices, to spot edits on reload
+    uint32_t vertexCapacity;               // Vertices reserved in the VBO (at least vertexCount)
+    uint32_t indexCapacity;                // Index bytes reserved in the EBO (at least indexCount * indexSize)
+    Bounds bounds;                         // Of the shape's vertices, for frustum culling
+    uint32_t lodCount;                     // Simplified levels stored after the full-detail indices
+    LodLevel lods[maxLodLevels];           // Coarser with every level
+    uint32_t unoptimizedMisses;            // Vertex shader invocations in the OBJ's triangle order, 0 if not optimised
+    std::vector<Meshlet> meshlets;         // Clusters covering the full-detail triangles in order, empty if not built
+
+    // Bytes of every level's indices, which lie back to back from indexOffset
+    std::size_t indexBytes() const;
+};
+
+// Deduplicated vertex buffer plus element buffer for a whole mesh
+struct IndexedGeometry {
+    std::vector<Vertex> vertices;          // All shapes back to back
+    std::vector<uint8_t> indexData;        // 16- or 32-bit indices per shape, every shape 4-byte aligned
+    std::vector<DrawShape> shapes;
+};
+
+// Post-transform cache behaviour of one shape's full-detail triangles
+struct ShapeCacheStats {
+    std::string name;
+    uint32_t triangles;
+    uint32_t vertices;
+    uint64_t missesBefore;                 // In the OBJ's triangle order
+    uint64_t missesAfter;                  // As drawn
+
+    // Average cache miss ratio (invocations per triangle) and average transformed vertex ratio
+    // (invocations per vertex, 1 being ideal)
+    double acmr(uint64_t misses) const { return triangles == 0 ? 0.0 : double(misses) / triangles; }
+    double atvr(uint64_t misses) const { return vertices == 0 ? 0.0 : double(misses) / vertices; }
+};
+
+// Sizes and vertex cache estimate of a set of indexed shapes, summed over chunks as they are built
+struct GeometryStats {
+    uint64_t corners = 0;                  // Triangle corners, i.e. vertices glDrawArrays would process
+    uint64_t vertices = 0;                 // Unique vertices in the VBO
+    uint64_t vertexBytes = 0;              // VBO size
+    uint64_t indexBytes = 0;               // EBO size
+    uint64_t vertexShaderInvocations = 0;  // Estimated with a FIFO post-transform cache
+    uint64_t unoptimizedInvocations = 0;   // The same estimate in the OBJ's triangle order
+    uint64_t meshlets = 0;                 // Clusters of every shape
+    uint64_t meshletTriangles = 0;         // Full-detail triangles of the shapes with clusters
+    std::vector<ShapeCacheStats> shapeCache; // Per shape, in the order the chunks were summed
+    uint64_t lodTriangles[maxLodLevels + 1] = {}; // Per level, level 0 being full detail
+    float lodError[maxLodLevels + 1] = {};        // Largest error of any shape's level
+
+    GeometryStats& operator+=(const GeometryStats& other);
+};
+
+// Box and sphere around count vertices; an empty set gets a zero-sized volume at the origin
+Bounds computeBounds(const Vertex* vertices, std::size_t count);
+
+// Bounds of a known box, with the sphere through its corners
+Bounds boxBounds(const float min[3], const float max[3]);
+
+// Append one vertex per distinct (position, normal, texcoord) index triple of source to geometry,
+// plus the shape's indices. Shapes with at most 65536 vertices get 16-bit indices. Up to lodLevels
+// simplified levels, each about half the triangles of the one before, follow the indices. With
+// optimize the triangles of every level are reordered for the post-transform cache and the vertices
+// renumbered for fetch locality (mesh_optimizer.h). With meshlets the full-detail triangles are
+// grouped into clusters for culling (meshlets.h).
+void appendIndexedShape(IndexedGeometry& geometry, const Mesh& mesh, const MeshShape& source, unsigned lodLevels = 0,
+                        bool optimize = false, bool meshlets = false);
+
+// Indexed geometry for every shape of mesh
+IndexedGeometry buildIndexedGeometry(const Mesh& mesh, unsigned lodLevels = 0, bool optimize = false, bool meshlets = false);
+
+// Read index i of a shape regardless of its index size
+uint32_t shapeIndex(const IndexedGeometry& geometry, const DrawShape& shape, std::size_t i);
+
+// Number of vertex shader invocations for an index stream through a FIFO post-transform cache
+uint64_t simulateVertexCache(const IndexedGeometry& geometry, const DrawShape& shape, unsigned cacheSize);
+
+// Measure the buffers and vertex cache behaviour of geometry
+GeometryStats measureGeometry(const IndexedGeometry& geometry);
+
+// Print VBO/EBO sizes and vertex shader invocation estimates against the de-indexed glDrawArrays path,
+// the ACMR/ATVR of every optimised shape before and after, and the meshlet count
+void printGeometryStats(const GeometryStats& stats);
@@ -0,0 +1,88 @@
+#include "gl_context.h"
+
+#include <algorithm>                       // For std::swap_ranges()
+
+GLFWwindow* createGlWindow(int width, int height, const char* title, WindowMode mode) {
+    // The platform is chosen by glfwInit(), so the hint has to come first
+    if (mode == WindowMode::Headless)
+        glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL);
+    if (!glfwInit())
+        return nullptr;
+
+    // Set the OpenGL version to 3.3 and use the core profile
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_VISIBLE, mode == WindowMode::Visible ? GLFW_TRUE : GLFW_FALSE);
+
+    GLFWwindow* window = nullptr;
+    if (mode == WindowMode::Headless) {
+        // EGL first: GLEW's entry points resolve through the same dispatch; OSMesa is the fallback
+        for (int api : {GLFW_EGL_CONTEXT_API, GLFW_OSMESA_CONTEXT_API}) {
+            glfwWindowHint(GLFW_CONTEXT_CREATION_API, api);
+            window = glfwCreateWindow(width, height, title, NULL, NULL);
+            if (window != NULL)
+                break;
+        }
+    } else {
+        window = glfwCreateWindow(width, height, title, NULL, NULL);
+    }
+    if (window == NULL) {
+        glfwTerminate();
+        return nullptr;
+    }
+    // Make the window's context current
+    glfwMakeContextCurrent(window);
+
+    // Initialize GLEW to manage OpenGL extensions; core profiles need glewExperimental to see them.
+    // Without an X display a GLX build reports an error after loading the GL entry points, so the result is not checked.
+    glewExperimental = GL_TRUE;
+    glewInit();
+    return window;
+}
+
+void readFramebuffer(int width, int height, std::vector<uint8_t>& rgb) {
+    std::size_t rowBytes = std::size_t(width) * 3;
+    rgb.resize(rowBytes * height);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);   // Rows of 3-byte pixels are not padded
+    glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, rgb.data());
+    for (int y = 0; y < height / 2; ++y) // GL's first row is the bottom one
+        std::swap_ranges(rgb.begin() + y * rowBytes, rgb.begin() + (y + 1) * rowBytes, rgb.end() - (y + 1) * rowBytes);
+}
+
+bool OffscreenTarget::create(int width, int height) {
+    width_ = width;
+    height_ = height;
+    glGenTextures(1, &colour_);
+    glBindTexture(GL_TEXTURE_2D, colour_);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glGenFramebuffers(1, &framebuffer_);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer_);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, colour_, 0);
+    return glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+}
+
+void OffscreenTarget::destroy() {
+    if (framebuffer_ == 0)
+        return;
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glDeleteFramebuffers(1, &framebuffer_);
+    glDeleteTextures(1, &colour_);
+    framebuffer_ = colour_ = 0;
+}
+
+void OffscreenTarget::present(const uint8_t* rgb) {
+    glBindTexture(GL_TEXTURE_2D, colour_);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width_, height_, GL_RGB, GL_UNSIGNED_BYTE, rgb);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    // The image's first row lands at the bottom of the texture, so the blit flips it back
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer_);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+    glBlitFramebuffer(0, 0, width_, height_, 0, height_, width_, 0, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>                         // Fixed-width integer types
+#include <vector>                          // For using the std::vector container
+#include <GL/glew.h>                       // GLEW library for managing OpenGL extensions
+#include <GLFW/glfw3.h>                    // GLFW library for creating windows and contexts
+
+// Where the GL 3.3 core context comes from
+enum class WindowMode {
+    Visible,                               // A window on the display
+    Hidden,                                // An invisible window, still needing a display
+    Headless                               // GLFW's null platform: no display or GPU needed, see createGlWindow()
+};
+
+// Initialise GLFW, create a width x height window in mode with its GL 3.3 core context current and
+// initialise GLEW. Headless windows use GLFW's null platform with a surfaceless EGL context, or an
+// OSMesa one, which Mesa's llvmpipe renders on the CPU; they have no default framebuffer to draw
+// to, so draw into an OffscreenTarget. Returns null, with GLFW terminated, if no context is available.
+GLFWwindow* createGlWindow(int width, int height, const char* title, WindowMode mode);
+
+// Read the colour buffer of the bound framebuffer as 8-bit RGB, top row first
+void readFramebuffer(int width, int height, std::vector<uint8_t>& rgb);
+
+// Framebuffer object with a colour texture, drawn into in place of the window
+class OffscreenTarget {
+public:
+    // Create and bind the framebuffer; false if the driver cannot render to it
+    bool create(int width, int height);
+    // Delete every GL object and bind the default framebuffer
+    void destroy();
+
+    // Copy an image of the target's size, 8-bit RGB with the top row first, into the colour texture
+    // and blit it to the window's framebuffer, which stays bound
+    void present(const uint8_t* rgb);
+
+    int width() const { return width_; }
+    int height() const { return height_; }
+
+private:
+    GLuint framebuffer_ = 0;
+    GLuint colour_ = 0;
+    int width_ = 0;
+    int height_ = 0;
+};
@@ -0,0 +1,108 @@
+#include "image_file.h"
+
+#include <algorithm>                       // For std::min()
+#include <cstdio>                          // For std::FILE
+#include <fstream>                         // For reading PPM files
+
+namespace {
+
+uint32_t crc32(const uint8_t* data, std::size_t size, uint32_t crc = 0) {
+    static uint32_t table[256];
+    static bool tableReady = false;
+    if (!tableReady) {
+        for (uint32_t n = 0; n < 256; ++n) {
+            uint32_t c = n;
+            for (int k = 0; k < 8; ++k)
+                c = c & 1 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            table[n] = c;
+        }
+        tableReady = true;
+    }
+    crc = ~crc;
+    for (std::size_t i = 0; i < size; ++i)
+        crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+void appendBigEndian(std::vector<uint8_t>& out, uint32_t value) {
+    for (int shift = 24; shift >= 0; shift -= 8)
+        out.push_back(static_cast<uint8_t>(value >> shift));
+}
+
+// Length, type, data and CRC of one PNG chunk
+void appendChunk(std::vector<uint8_t>& out, const char type[5], const std::vector<uint8_t>& data) {
+    appendBigEndian(out, static_cast<uint32_t>(data.size()));
+    std::size_t start = out.size();
+    out.insert(out.end(), type, type + 4);
+    out.insert(out.end(), data.begin(), data.end());
+    appendBigEndian(out, crc32(&out[start], out.size() - start));
+}
+
+bool writeFile(const std::string& path, const uint8_t* data, std::size_t size) {
+    std::FILE* file = std::fopen(path.c_str(), "wb");
+    if (file == nullptr)
+        return false;
+    bool written = std::fwrite(data, 1, size, file) == size;
+    return std::fclose(file) == 0 && written;
+}
+
+bool writePng(const std::string& path, int width, int height, const uint8_t* rgb) {
+    std::vector<uint8_t> png = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    std::vector<uint8_t> header;
+    appendBigEndian(header, static_cast<uint32_t>(width));
+    appendBigEndian(header, static_cast<uint32_t>(height));
+    header.insert(header.end(), {8, 2, 0, 0, 0}); // 8-bit RGB, deflate, adaptive filtering, no interlace
+    appendChunk(png, "IHDR", header);
+
+    // Scanlines with filter type 0, in a zlib stream of stored blocks of at most 65535 bytes
+    std::size_t rowBytes = std::size_t(width) * 3;
+    std::vector<uint8_t> raw;
+    raw.reserve((rowBytes + 1) * height);
+    for (int y = 0; y < height; ++y) {
+        raw.push_back(0);
+        raw.insert(raw.end(), rgb + y * rowBytes, rgb + (y + 1) * rowBytes);
+    }
+    std::vector<uint8_t> zlib = {0x78, 0x01};
+    std::size_t offset = 0;
+    do {
+        std::size_t length = std::min<std::size_t>(65535, raw.size() - offset);
+        zlib.push_back(offset + length == raw.size() ? 1 : 0); // BFINAL on the last block, BTYPE 00
+        zlib.push_back(static_cast<uint8_t>(length));
+        zlib.push_back(static_cast<uint8_t>(length >> 8));
+        zlib.push_back(static_cast<uint8_t>(~length));
+        zlib.push_back(static_cast<uint8_t>(~length >> 8));
+        zlib.insert(zlib.end(), raw.begin() + offset, raw.begin() + offset + length);
+        offset += length;
+    } while (offset < raw.size());
+    uint32_t a = 1, b = 0;                 // Adler-32 of the uncompressed data
+    for (uint8_t byte : raw) {
+        a = (a + byte) % 65521;
+        b = (b + a) % 65521;
+    }
+    appendBigEndian(zlib, (b << 16) | a);
+    appendChunk(png, "IDAT", zlib);
+    appendChunk(png, "IEND", {});
+    return writeFile(path, png.data(), png.size());
+}
+
+} // namespace
+
+bool writeImage(const std::string& path, int width, int height, const uint8_t* rgb) {
+    if (path.size() >= 4 && path.compare(path.size() - 4, 4, ".png") == 0)
+        return writePng(path, width, height, rgb);
+    std::string header = "P6\n" + std::to_string(width) + " " + std::to_string(height) + "\n255\n";
+    std::vector<uint8_t> ppm(header.begin(), header.end());
+    ppm.insert(ppm.end(), rgb, rgb + std::size_t(width) * height * 3);
+    return writeFile(path, ppm.data(), ppm.size());
+}
+
+bool readPpm(const std::string& path, int& width, int& height, std::vector<uint8_t>& rgb) {
+    std::ifstream file(path, std::ios::binary);
+    std::string magic;
+    int maxValue = 0;
+    if (!(file >> magic >> width >> height >> maxValue) || magic != "P6" || maxValue != 255 || width <= 0 || height <= 0)
+        return false;
+    file.get();                            // The single whitespace byte before the samples
+    rgb.resize(std::size_t(width) * height * 3);
+    return static_cast<bool>(file.read(reinterpret_cast<char*>(rgb.data()), rgb.size()));
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <cstdint>                         // Fixed-width integer types
+#include <string>                          // For file paths
+#include <vector>                          // For using the std::vector container
+
+// Write width x height 8-bit RGB pixels, top row first, as a binary PPM (P6) or, when path ends in
+// ".png", as a PNG with uncompressed deflate blocks, so no zlib is needed. Returns false if the file
+// cannot be written.
+bool writeImage(const std::string& path, int width, int height, const uint8_t* rgb);
+
+// Read a binary PPM written by writeImage() into rgb; false if the file is missing or not a P6 with 8-bit samples
+bool readPpm(const std::string& path, int& width, int& height, std::vector<uint8_t>& rgb);
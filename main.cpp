@@ -1,191 +1,804 @@
+#include <algorithm>                       // For std::max()
+#include <atomic>                          // For the flags shared with the render thread
 #include <iostream>                        // Standard input/output stream library
+#include <chrono>                          // For the startup metrics
+#include <cstdio>                          // For std::snprintf()
+#include <mutex>                           // For the window title set by the render thread
+#include <string>                          // For the window title
+#include <thread>                          // For the render thread and waiting on the loader in offline runs
 #include <vector>                          // For using the std::vector container
 #include <GL/glew.h>                       // GLEW library for managing OpenGL extensions
 #include <GLFW/glfw3.h>                    // GLFW library for creating windows and handling input
 #include <glm/glm.hpp>                     // GLM library for handling matrices and vectors
 #include <glm/gtc/matrix_transform.hpp>    // GLM utilities for matrix transformations
 #include <glm/gtc/type_ptr.hpp>            // GLM utilities for converting matrices to pointer types
-#include "tiny_obj_loader.h"               // For loading OBJ files
-
-// Vertex Shader source code
-const char* vertexShaderSource = R"glsl(
-#version 330 core                           // Specify OpenGL version 3.3 core
-layout (location = 0) in vec3 aPos;         // Input vertex attribute position at location 0
-uniform mat4 transform;                     // Uniform matrix for transformations
-void main() {
-    gl_Position = transform * vec4(aPos, 1.0); // Apply transformation to vertex position
-}
-)glsl";
-
-// Fragment Shader source code
-const char* fragmentShaderSource = R"glsl(
-#version 330 core                           // Specify OpenGL version 3.3 core
-out vec4 FragColor;                         // Output fragment color
-void main() {
-    FragColor = vec4(1.0f, 1.0f, 1.0f, 1.0f); // Set output color to white
-}
-)glsl";
-
-// Function declaration for processing user input
-void processInput(GLFWwindow* window, glm::mat4 &transform);
-
-int main()
+#include "asset_loader.h"                  // For loading the OBJ on a background thread
+#include "camera_script.h"                 // For scripted camera moves
+#include "file_watcher.h"                  // For hot reloading edited OBJ files
+#include "frame_timing.h"                  // For the per-phase frame time breakdown
+#include "gl_context.h"                    // For the window, or offscreen target, and its GL context
+#include "image_file.h"                    // For writing and comparing frames
+#include "page_pool.h"                     // For streaming models larger than memory
+#include "picking.h"                       // For picking points on the models with the mouse
+#include "scene_buffers.h"                 // For uploading loaded shapes under a per-frame budget
+#include "options.h"                       // Command-line options
+#include "shader_program.h"                // For compiling the scene shaders
+#include "simulation_clock.h"              // For moving the camera at a fixed timestep
+#include "software_renderer.h"             // For drawing without OpenGL
+#include "thread_pool.h"                   // For culling meshlets in parallel
+#include "triple_buffer.h"                 // For handing scene snapshots to the render thread
+
+// Function declaration for processing user input, returns the letters of the movement keys held
+std::string processInput(GLFWwindow* window);
+
+// Cursor state shared with the GLFW callbacks through the window user pointer
+struct PickRequest {
+    double cursorX = 0.0, cursorY = 0.0;   // Last cursor position in window coordinates
+    bool requested = false;                // Left button pressed since the last pick
+};
+
+// GLFW callbacks that track the cursor and request a pick on left clicks
+void cursorPositionCallback(GLFWwindow* window, double x, double y);
+void mouseButtonCallback(GLFWwindow* window, int button, int action, int mods);
+
+// Frames written to or compared against image files
+struct FrameFiles {
+    std::vector<uint8_t> expected;         // Last image read from the compare directory
+    unsigned written = 0;
+    unsigned compared = 0;
+    unsigned differing = 0;
+    uint64_t pixelsDiffering = 0;
+};
+
+// Write the width x height RGB image of frame to the output directory and compare it with the
+// compare directory's, as the options ask
+void checkFrame(const Options& options, const std::vector<uint8_t>& rgb, int width, int height, unsigned frame, FrameFiles& files);
+// Print what checkFrame() wrote and compared over frames frames; false if a frame was not written or differed
+bool reportFrameFiles(const Options& options, const FrameFiles& files, unsigned frames);
+// Write the keys recorded every tick to the record file, if the options ask for one; false if it cannot be written
+bool saveRecording(const Options& options, const std::vector<ScriptStep>& recording);
+
+// Fixed-timestep simulation of the transform, see simulation_clock.h
+struct Simulation {
+    SimulationClock clock;
+    glm::mat4 previous = glm::mat4(1.0f);  // Before the last tick
+    glm::mat4 current = glm::mat4(1.0f);   // After the last tick
+    std::vector<ScriptStep> recording;     // Keys of every tick, for --record
+
+    explicit Simulation(const SimulationClock& clock) : clock(clock) {}
+};
+
+// State the update thread hands to the render thread after every tick
+struct SceneSnapshot {
+    glm::mat4 previous = glm::mat4(1.0f);  // Before the last tick
+    glm::mat4 current = glm::mat4(1.0f);   // After the last tick
+    std::chrono::steady_clock::time_point tickTime; // When current is reached, see SimulationClock::tickTime()
+    double tickSeconds = 0.0;
+    int framebufferWidth = 800;            // In pixels, see framebufferSize in main()
+    int framebufferHeight = 800;
+};
+
+// Transform of snapshot at time, which normally lies within the tick before its tickTime; later
+// times draw current rather than extrapolate
+glm::mat4 snapshotTransform(const SceneSnapshot& snapshot, std::chrono::steady_clock::time_point time);
+
+// Clock of the simulation: live when the keyboard drives it in real time, virtual for scripted and offline runs
+SimulationClock simulationClock(const Options& options, bool offline);
+// Run the ticks due before the next frame with the keys of the script, or else those held in window
+// (none when null), recording them when the options ask; returns the transform to draw
+glm::mat4 simulate(const Options& options, GLFWwindow* window, const std::vector<ScriptStep>& script, Simulation& simulation);
+
+// Draw the scene with the software renderer; frames are shown through GL in a window, or, headless,
+// GL is never used. Returns the exit code.
+int runSoftware(const Options& options, const Scene& scene, const std::vector<ScriptStep>& script, bool offline, AssetLoader& loader);
+
+int main(int argc, char* argv[])
 {
-    // Initialize the GLFW library
-    glfwInit();
+    // Startup metrics are measured from here
+    auto programStart = std::chrono::steady_clock::now();
+
+    // Read the command-line options
+    Options options;
+    if (!parseOptions(argc, argv, options))
+        return 1; // Exit the program with an error code
 
-    // Set the OpenGL version to 3.3 and use the core profile
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    // Collect the models to draw from the manifest and the command line
+    Scene scene;
+    if (!buildScene(options, scene))
+        return 1; // Exit the program with an error code
 
-    // Create a windowed mode window and its OpenGL context
-    GLFWwindow* window = glfwCreateWindow(800, 800, "A3", NULL, NULL);
-    // Make the window's context current
-    glfwMakeContextCurrent(window);
+    // A camera script replaces the keyboard; headless runs last until its end is drawn unless --frames says otherwise
+    std::vector<ScriptStep> script;
+    if (!options.scriptFile.empty()) {
+        std::string message;
+        if (!loadCameraScript(options.scriptFile, script, message)) {
+            std::cerr << message << std::endl;
+            return 1; // Exit the program with an error code
+        }
+    }
+    // Frames that are written or compared show the whole scene, so the output does not depend on load timing
+    bool offline = options.headless || !options.outputDir.empty() || !options.compareDir.empty();
+    if (options.headless && options.frameLimit == 0)
+        options.frameLimit = simulationClock(options, offline).framesFor(scriptLength(script));
 
-    // Initialize GLEW to manage OpenGL extensions
-    glewInit();
+    if (options.renderer == Renderer::Software && options.stream) {
+        std::cerr << "Streaming mode draws with OpenGL only" << std::endl;
+        return 1; // Exit the program with an error code
+    }
+    // Offline frames are drawn at fixed simulated times, so the update and the frames stay in step on one thread
+    bool renderThread = options.renderThread && !offline && options.renderer == Renderer::OpenGL;
+    if (options.renderThread && !renderThread)
+        std::cerr << "Offline and software runs draw on the main thread, ignoring --render-thread" << std::endl;
+
+    // Load the OBJ files on background threads (from their binary caches when still valid),
+    // overlapping the parse with window and context creation. In streaming mode the models are
+    // paged to disk instead and never held in memory as a whole.
+    AssetLoader loader;
+    ModelPager pager;
+    if (options.stream)
+        pager.start(scene.modelFiles, options.streamBudgetBytes);
+    else
+        loader.start(scene.modelFiles, options.load, options.pick);
+    if (options.renderer == Renderer::Software)
+        return runSoftware(options, scene, script, offline, loader);
+
+    // Create a windowed mode window, or a headless one, and its OpenGL context
+    GLFWwindow* window = createGlWindow(800, 800, "A3", options.headless ? WindowMode::Headless : WindowMode::Visible);
+    if (window == nullptr) {
+        std::cerr << "Cannot create an OpenGL 3.3 context" << (options.headless ? " without a display" : "") << std::endl;
+        return 1; // Exit the program with an error code
+    }
+    if (!options.headless)
+        glfwSwapInterval(options.vsync ? 1 : 0);
+
+    // Headless windows have no framebuffer of their own; draw into an offscreen one of the same size
+    OffscreenTarget offscreen;
+    if (options.headless && !offscreen.create(800, 800)) {
+        std::cerr << "Cannot render to an offscreen framebuffer" << std::endl;
+        offscreen.destroy();
+        glfwDestroyWindow(window);
+        glfwTerminate();
+        return 1; // Exit the program with an error code
+    }
+    if (options.headless)
+        std::cout << "Headless rendering on " << glGetString(GL_RENDERER) << std::endl;
 
     // Set the viewport to cover the entire window
     glViewport(0, 0, 800, 800);
 
-    // Compile the vertex shader
-    GLuint vertexShader = glCreateShader(GL_VERTEX_SHADER);    // Create a vertex shader object
-    glShaderSource(vertexShader, 1, &vertexShaderSource, NULL); // Attach the shader source code
-    glCompileShader(vertexShader);                              // Compile the vertex shader
-
-    // Compile the fragment shader
-    GLuint fragmentShader = glCreateShader(GL_FRAGMENT_SHADER); // Create a fragment shader object
-    glShaderSource(fragmentShader, 1, &fragmentShaderSource, NULL); // Attach the shader source code
-    glCompileShader(fragmentShader);                            // Compile the fragment shader
-
-    // Link shaders to create a shader program
-    GLuint shaderProgram = glCreateProgram();        // Create a shader program object
-    glAttachShader(shaderProgram, vertexShader);     // Attach the vertex shader
-    glAttachShader(shaderProgram, fragmentShader);   // Attach the fragment shader
-    glLinkProgram(shaderProgram);                    // Link the shaders into a program
-
-    // Delete the shader objects after linking them into the program
-    glDeleteShader(vertexShader);                    // Delete the vertex shader object
-    glDeleteShader(fragmentShader);                  // Delete the fragment shader object
-
-    // Load OBJ file using tinyobjloader
-    std::string inputfile = "../contingo.obj"; // Path to the .obj file
-    tinyobj::attrib_t attrib; // Object to store vertex attributes
-    std::vector<tinyobj::shape_t> shapes; // Vector to store shapes
-    std::vector<tinyobj::material_t> materials; // Vector to store materials
-    std::string warn, err; // Strings to store warnings and errors
-
-    // Load the OBJ file
-    if (!tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, inputfile.c_str())) {
-        std::cerr << warn << err << std::endl; // Print warnings and errors if loading fails
-        return 1; // Exit the program with an error code
+    // Pages are always stored as float vertices
+    VertexFormat vertexFormat = options.stream ? VertexFormat::Float : options.vertexFormat;
+    if (vertexFormat != options.vertexFormat)
+        std::cerr << "Streaming mode stores float vertices, ignoring --vertex-format" << std::endl;
+
+    // Compile and link the vertex and fragment shaders
+    GLuint shaderProgram = createShaderProgram(vertexFormat);
+
+    // Create the VAO, VBO and EBO; loaded shapes are appended to them as they arrive
+    SceneBuffers buffers;
+    buffers.create(options.multiDraw, vertexFormat, options.persistentMapping);
+    const DrawTable& table = buffers.drawTable();
+    if (!options.stream && table.multiDrawIndirect())
+        std::cout << "Draw submission: multi-draw indirect, commands streamed through "
+                  << (table.persistentStreaming() ? "a persistently mapped ring" : "orphaned buffers") << std::endl;
+    else if (!options.stream)
+        std::cout << "Draw submission: per-shape loop" << std::endl;
+    PagePool pagePool;
+    if (options.stream)
+        pagePool.create(options.pagePoolBytes);
+
+    // The transformation matrix starts as the identity matrix; the simulation moves it at a fixed rate
+    // and every frame draws it interpolated to the frame's time. The update thread of a threaded run
+    // ticks in real time even when scripted, since frames are drawn independently of its ticks.
+    Simulation simulation(renderThread ? SimulationClock(options.simulationRate, options.frameRate, true)
+                                       : simulationClock(options, offline));
+
+    // Set the polygon mode to wireframe
+    glPolygonMode(GL_FRONT_AND_BACK, GL_LINE); // Render polygons as wireframes
+    if (options.cullBackfaces)
+        glEnable(GL_CULL_FACE);            // Back faces go too, matching the meshlets culled for facing away
+
+    // Workers for meshlet culling; the render thread takes part
+    ThreadPool cullPool;
+    bool cullClusters = options.cull && options.load.meshlets && !options.stream;
+
+    // Picking: clicks are queued by the callbacks and resolved in the render loop
+    PickRequest pickRequest;
+    bool havePreviousPick = false;
+    glm::vec3 previousPick(0.0f);
+    if (options.pick && options.stream) {
+        std::cerr << "Picking is not available in streaming mode" << std::endl;
+    } else if (options.pick) {
+        glfwSetWindowUserPointer(window, &pickRequest);
+        glfwSetCursorPosCallback(window, cursorPositionCallback);
+        glfwSetMouseButtonCallback(window, mouseButtonCallback);
     }
 
-    // Extract vertices from the loaded OBJ file
-    std::vector<GLfloat> vertices; // Vector to store vertex data
-    for (const auto& shape : shapes) { // Loop through each shape in the OBJ file
-        for (const auto& index : shape.mesh.indices) { // Loop through each index in the shape's mesh
-            // Add vertex positions to the vertices vector
-            vertices.push_back(attrib.vertices[3 * index.vertex_index + 0]); // x-coordinate
-            vertices.push_back(attrib.vertices[3 * index.vertex_index + 1]); // y-coordinate
-            vertices.push_back(attrib.vertices[3 * index.vertex_index + 2]); // z-coordinate
+    // Watch the model files so re-exported models are picked up without a restart
+    FileWatcher watcher;
+    if (options.watchFiles && !options.stream && !offline && !watcher.start(scene.modelFiles))
+        std::cerr << "Hot reload disabled: cannot watch the model files" << std::endl;
+
+    // Startup metrics, reported once each
+    bool firstFrameReported = false;
+    bool fullSceneReported = false;
+    auto secondsSinceStart = [&]() {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - programStart).count();
+    };
+
+    // Frame time statistics
+    unsigned frameCount = 0;
+    unsigned framesThisSecond = 0;
+    CullStats culled;                      // Summed over every frame
+    CullStats culledThisSecond;
+    LodStats lodsDrawn;                    // Summed over every frame
+    ClusterStats clustersCulled;           // Summed over every frame
+    ClusterStats clustersThisSecond;
+
+    // Frames written to or compared against image files
+    std::vector<uint8_t> pixels;
+    FrameFiles frameFiles;
+
+    // CPU and GPU time of every phase of the frame, when built with FRAME_TIMING; T prints it
+    FrameTiming timing;
+    timing.createQueries();
+    bool timingKeyHeld = false;
+    std::atomic<bool> timingReportRequested(false);
+
+    // Offline runs upload the whole scene, without a budget, before the first frame
+    if (offline && !options.stream) {
+        while (!loader.failed() && !(loader.drained() && buffers.idle())) {
+            if (buffers.upload(loader, SIZE_MAX) == 0)
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
         }
     }
+    double loopStartTime = glfwGetTime();
+    double titleUpdateTime = loopStartTime;
+    RollingHistogram frameTimes;           // Time between the starts of consecutive frames
+    std::chrono::steady_clock::time_point lastFrameStart;
+
+    // Requests from the thread that draws to the one that owns the window
+    std::mutex titleMutex;
+    std::string pendingTitle;              // Guarded by titleMutex; empty once shown
+    std::atomic<bool> closeRequested(false);
+
+    // Draw a frame of the scene seen through transform: upload what has loaded, cull, draw, capture
+    // and present. Runs on whichever thread holds the GL context.
+    auto renderFrame = [&](const glm::mat4& transform, int framebufferWidth, int framebufferHeight) {
+        auto frameStart = std::chrono::steady_clock::now();
+        if (frameCount > 0)
+            frameTimes.add(std::chrono::duration<double, std::milli>(frameStart - lastFrameStart).count());
+        lastFrameStart = frameStart;
+        timing.beginFrame();
+        if (timingReportRequested.exchange(false))
+            timing.report(std::cout);
+
+        {
+            PhaseTimer timer(timing, FramePhase::Upload, true);
+
+            // Upload whatever the loader has finished, without exceeding this frame's budget
+            if (options.stream) {
+                pagePool.update(pager.files(), scene.instances, transform, options.uploadBudgetBytes);
+                if (pager.failed()) {
+                    closeRequested = true; // Nothing to show if an OBJ cannot be paged
+                } else if (!fullSceneReported && pager.finished()) {
+                    std::cout << "Time to paged scene: " << secondsSinceStart() << " s (" << pagePool.residentPages()
+                              << " pages resident in a pool of " << pagePool.slotCount() << ")" << std::endl;
+                    fullSceneReported = true;
+                }
+            } else {
+                buffers.upload(loader, options.uploadBudgetBytes);
+                if (loader.failed()) {
+                    closeRequested = true; // Nothing to show if the OBJ cannot be loaded
+                } else if (!fullSceneReported && buffers.idle() && loader.drained()) {
+                    std::cout << "Time to full scene: " << secondsSinceStart() << " s (" << scene.instances.size()
+                              << " instances of " << scene.modelFiles.size() << " model files)" << std::endl;
+                    std::cout << "GPU geometry: VBO " << buffers.vertexBytes() << " bytes (" << vertexFormatName(vertexFormat)
+                              << ", " << vertexStride(vertexFormat) << " bytes per vertex) + EBO " << buffers.indexBytes()
+                              << " bytes" << std::endl;
+                    fullSceneReported = true;
+                }
+            }
+
+            // Hot reload: once the initial load is resident, re-parse edited files and swap in changed shapes
+            if (fullSceneReported && !options.stream) {
+                for (const FileChange& change : watcher.takeChanges())
+                    loader.requestReload(change.fileId, scene.modelFiles[change.fileId], change.detectedAt);
+                ReloadBatch batch;
+                while (loader.tryPopReload(batch)) {
+                    ReloadStats reload = buffers.applyReload(batch);
+                    double latency = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - batch.detectedAt).count();
+                    std::cout << "Reloaded " << scene.modelFiles[batch.meshId] << ": " << reload.changed << " of "
+                              << reload.shapes << " shapes changed (" << reload.inPlace << " in place), " << reload.removed
+                              << " removed, " << reload.bytesUploaded << " bytes uploaded, latency " << latency
+                              << " ms (parse " << batch.parseMillis << " ms)" << std::endl;
+                }
+            }
+        }
 
-    // Generate and bind Vertex Array Object (VAO) and Vertex Buffer Object (VBO)
-    GLuint VAO, VBO;
-    glGenVertexArrays(1, &VAO);            // Generate VAO to store vertex attribute configuration
-    glGenBuffers(1, &VBO);                 // Generate VBO to store vertex data in GPU memory
-
-    // Bind the VAO (recording the configuration of vertex attributes)
-    glBindVertexArray(VAO);
-
-    // Bind and set the VBO's data
-    glBindBuffer(GL_ARRAY_BUFFER, VBO); // Bind the VBO to the GL_ARRAY_BUFFER target
-    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(GLfloat), vertices.data(), GL_STATIC_DRAW); // Copy vertex data to the VBO
-
-    // Define vertex attributes
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0); // Describe vertex attribute layout
-    glEnableVertexAttribArray(0);          // Enable the vertex attribute at location 0
+        // Set the transformation matrix in the shader and pick the shapes of every instance to draw
+        CullStats frameCull;
+        {
+            PhaseTimer timer(timing, FramePhase::Update);
+
+            // Use the shader program
+            glUseProgram(shaderProgram);
+
+            // Set the transformation matrix in the shader
+            GLuint transformLoc = glGetUniformLocation(shaderProgram, "transform"); // Get the location of the transform uniform
+            glUniformMatrix4fv(transformLoc, 1, GL_FALSE, glm::value_ptr(transform)); // Set the transform uniform in the shader
+
+            // Skip shapes outside the view, choose levels of detail and cull meshlets (paged models cull as they draw)
+            if (!options.stream && options.cull)
+                frameCull = buffers.cull(scene.instances, transform);
+            if (!options.stream && options.load.lodLevels > 0) {
+                // Clip space spans two units over the height of the framebuffer
+                lodsDrawn += buffers.selectLods(scene.instances, transform, 0.5f * framebufferHeight, options.lodThresholdPixels);
+            }
+            if (cullClusters) {
+                ClusterStats frameClusters = buffers.cullClusters(scene.instances, transform, options.cullBackfaces, cullPool);
+                clustersCulled += frameClusters;
+                clustersThisSecond += frameClusters;
+            }
+        }
 
-    // Unbind the VBO (the VAO remains bound)
-    glBindBuffer(GL_ARRAY_BUFFER, 0);     // Unbind the VBO to avoid unintended modifications
+        {
+            PhaseTimer timer(timing, FramePhase::Draw, true);
 
-    // Initialize the transformation matrix to the identity matrix
-    glm::mat4 transform = glm::mat4(1.0f); // Start with the identity matrix
+            // Cover the whole framebuffer, which has more pixels than the window on high-DPI displays
+            glViewport(0, 0, framebufferWidth, framebufferHeight);
 
-    // Set the polygon mode to wireframe
-    glPolygonMode(GL_FRONT_AND_BACK, GL_LINE); // Render polygons as wireframes
+            // Clear the color buffer with a dark grey background
+            glClearColor(0.2f, 0.2f, 0.2f, 1.0f); // Set clear color
+            glClear(GL_COLOR_BUFFER_BIT); // Clear the color buffer
 
-    // Main rendering loop
-    while (!glfwWindowShouldClose(window)) // Continue until the window should close
-    {
-        // Process user input and update the transformation matrix
-        processInput(window, transform);
+            // Draw every instance whose model has finished uploading
+            if (options.stream)
+                frameCull = pagePool.draw(scene.instances, transform, options.cull);
+            else
+                buffers.draw(scene.instances);
+        }
+        culled += frameCull;
+        culledThisSecond += frameCull;
+
+        // Write the frame, or compare it with the expected one
+        if (!options.outputDir.empty() || !options.compareDir.empty()) {
+            PhaseTimer timer(timing, FramePhase::Capture);
+            readFramebuffer(framebufferWidth, framebufferHeight, pixels);
+            checkFrame(options, pixels, framebufferWidth, framebufferHeight, frameCount, frameFiles);
+        }
 
-        // Clear the color buffer with a dark grey background
-        glClearColor(0.2f, 0.2f, 0.2f, 1.0f); // Set clear color
-        glClear(GL_COLOR_BUFFER_BIT); // Clear the color buffer
+        // Swap buffers, or wait for the offscreen frame to finish
+        {
+            PhaseTimer timer(timing, FramePhase::Present);
+            if (options.headless)
+                glFinish(); // Frame times then include the whole frame's rendering
+            else
+                glfwSwapBuffers(window); // Swap the front and back buffers
+        }
 
-        // Use the shader program
-        glUseProgram(shaderProgram);
+        if (!firstFrameReported) {
+            std::cout << "Time to first frame: " << secondsSinceStart() << " s" << std::endl;
+            firstFrameReported = true;
+        }
 
-        // Set the transformation matrix in the shader
-        GLuint transformLoc = glGetUniformLocation(shaderProgram, "transform"); // Get the location of the transform uniform
-        glUniformMatrix4fv(transformLoc, 1, GL_FALSE, glm::value_ptr(transform)); // Set the transform uniform in the shader
+        // Show the mean frame time of the last second in the title bar
+        ++frameCount;
+        ++framesThisSecond;
+        double now = glfwGetTime();
+        if (now - titleUpdateTime >= 1.0) {
+            std::string title = "A3 - " + std::to_string(scene.instances.size()) + " instances - " +
+                                std::to_string(1000.0 * (now - titleUpdateTime) / framesThisSecond) + " ms/frame";
+            if (options.cull && culledThisSecond.objects > 0) {
+                uint64_t objects = culledThisSecond.objects - culledThisSecond.objectsCulled;
+                uint64_t triangles = culledThisSecond.triangles - culledThisSecond.trianglesCulled;
+                title += " - drawn " + std::to_string(objects / framesThisSecond) + "/" +
+                         std::to_string(culledThisSecond.objects / framesThisSecond) + " objects, " +
+                         std::to_string(triangles / framesThisSecond) + "/" +
+                         std::to_string(culledThisSecond.triangles / framesThisSecond) + " triangles";
+            }
+            if (cullClusters && clustersThisSecond.clusters > 0) {
+                uint64_t clusters = clustersThisSecond.clusters - clustersThisSecond.frustumCulled - clustersThisSecond.backfaceCulled;
+                title += " - " + std::to_string(clusters / framesThisSecond) + "/" +
+                         std::to_string(clustersThisSecond.clusters / framesThisSecond) + " clusters";
+            }
+            {
+                std::lock_guard<std::mutex> lock(titleMutex);
+                pendingTitle = title;
+            }
+            titleUpdateTime = now;
+            framesThisSecond = 0;
+            culledThisSecond = CullStats();
+            clustersThisSecond = ClusterStats();
+        }
+        if (options.frameLimit != 0 && frameCount >= options.frameLimit)
+            closeRequested = true; // Scripted runs stop after a fixed number of frames
+    };
+
+    // Run the simulation ticks due, then handle the frame timing key and clicks; returns the transform to
+    // draw. Stays on this thread, which owns the window and its events.
+    auto updateScene = [&]() {
+        // Process user input, or the script's keys, and update the transformation matrix
+        glm::mat4 transform = simulate(options, window, script, simulation);
+
+        // Print the frame timing when T is pressed
+        if (FrameTiming::enabled) {
+            bool held = glfwGetKey(window, GLFW_KEY_T) == GLFW_PRESS;
+            if (held && !timingKeyHeld)
+                timingReportRequested = true;
+            timingKeyHeld = held;
+        }
 
-        // Bind VAO and draw the object
-        glBindVertexArray(VAO); // Bind the VAO
-        glDrawArrays(GL_TRIANGLES, 0, vertices.size() / 3); // Draw the vertices as triangles
-        glBindVertexArray(0); // Unbind the VAO
+        // Resolve a click into the nearest surface point under the cursor
+        if (pickRequest.requested) {
+            pickRequest.requested = false;
+            int width = 0, height = 0;
+            glfwGetWindowSize(window, &width, &height);
+            float ndcX = static_cast<float>(2.0 * pickRequest.cursorX / std::max(width, 1) - 1.0);
+            float ndcY = static_cast<float>(1.0 - 2.0 * pickRequest.cursorY / std::max(height, 1));
+            std::vector<std::shared_ptr<const PickableMesh>> meshes = loader.pickableMeshes();
+            PickResult pick;
+            if (pickScene(scene.instances, meshes, transform, ndcX, ndcY, pick)) {
+                const glm::vec3& p = pick.scenePoint;
+                std::cout << "Picked " << scene.modelFiles[pick.meshId] << " shape \"" << meshes[pick.meshId]->shapeNames[pick.shape]
+                          << "\" (instance " << pick.instance << ", triangle " << pick.triangle << ") at (" << p.x << ", "
+                          << p.y << ", " << p.z << ")";
+                if (havePreviousPick)
+                    std::cout << ", " << glm::length(p - previousPick) << " from the previous point";
+                std::cout << std::endl;
+                previousPick = p;
+                havePreviousPick = true;
+            } else {
+                std::cout << "Picked nothing" << std::endl;
+            }
+        }
+        return transform;
+    };
+
+    // Show the title and close the window as the thread that draws asked
+    auto applyRenderRequests = [&]() {
+        std::lock_guard<std::mutex> lock(titleMutex);
+        if (!pendingTitle.empty()) {
+            glfwSetWindowTitle(window, pendingTitle.c_str());
+            pendingTitle.clear();
+        }
+        if (closeRequested)
+            glfwSetWindowShouldClose(window, true);
+    };
+    // Pixels drawn into: the offscreen target when headless, else the window's framebuffer
+    auto framebufferSize = [&](int& width, int& height) {
+        if (options.headless) {
+            width = offscreen.width();
+            height = offscreen.height();
+        } else {
+            glfwGetFramebufferSize(window, &width, &height);
+        }
+    };
+
+    if (renderThread) {
+        // This thread only polls events and runs the simulation, publishing a snapshot after every tick;
+        // the render thread draws the newest one interpolated to the time of its frame, so a slow update
+        // never holds up a frame and a slow frame never holds up the update
+        TripleBuffer<SceneSnapshot> snapshots;
+        FrameTiming updateTiming;          // Input phase of this thread; the render thread times the rest
+        std::atomic<bool> stopRendering(false);
+        glfwMakeContextCurrent(nullptr);   // Hand the context over
+        std::thread renderer([&]() {
+            glfwMakeContextCurrent(window);
+            while (!stopRendering) {
+                auto frameStart = std::chrono::steady_clock::now();
+                snapshots.acquire();
+                const SceneSnapshot& snapshot = snapshots.front();
+                renderFrame(snapshotTransform(snapshot, frameStart), snapshot.framebufferWidth, snapshot.framebufferHeight);
+                if (options.frameRate != 0) // Hold the --fps cap
+                    std::this_thread::sleep_until(frameStart + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                                                   std::chrono::duration<double>(1.0 / options.frameRate)));
+            }
+            glfwMakeContextCurrent(nullptr);
+        });
+
+        while (!glfwWindowShouldClose(window)) {
+            updateTiming.beginFrame();
+            {
+                PhaseTimer timer(updateTiming, FramePhase::Input);
+                updateScene();
+                SceneSnapshot& snapshot = snapshots.back();
+                snapshot.previous = simulation.previous;
+                snapshot.current = simulation.current;
+                snapshot.tickTime = simulation.clock.tickTime();
+                snapshot.tickSeconds = simulation.clock.tickSeconds();
+                framebufferSize(snapshot.framebufferWidth, snapshot.framebufferHeight);
+                snapshots.publish();
+            }
+            applyRenderRequests();
+
+            // Sleep until the next tick is due, waking early for input
+            double wait = std::chrono::duration<double>(simulation.clock.tickTime() - std::chrono::steady_clock::now()).count();
+            if (wait > 0.0)
+                glfwWaitEventsTimeout(wait);
+            else
+                glfwPollEvents();
+        }
+        stopRendering = true;
+        renderer.join();
+        glfwMakeContextCurrent(window);
+        if (FrameTiming::enabled) {
+            std::cout << "Update thread: ";
+            updateTiming.report(std::cout);
+        }
+    } else {
+        // Main rendering loop
+        while (!glfwWindowShouldClose(window)) // Continue until the window should close
+        {
+            glm::mat4 transform;
+            {
+                PhaseTimer timer(timing, FramePhase::Input);
+                glfwPollEvents(); // Poll for and process events
+                transform = updateScene();
+            }
+            int framebufferWidth = 0, framebufferHeight = 0;
+            framebufferSize(framebufferWidth, framebufferHeight);
+            renderFrame(transform, framebufferWidth, framebufferHeight);
+            applyRenderRequests();
+            if (!closeRequested && !options.headless)
+                simulation.clock.waitForNextFrame(); // Hold the --fps cap
+        }
+    }
 
-        // Swap buffers and poll for events
-        glfwSwapBuffers(window); // Swap the front and back buffers
-        glfwPollEvents(); // Poll for and process events
+    // Report the mean frame time over the whole run
+    if (frameCount > 0)
+        std::cout << "Mean frame time: " << 1000.0 * (glfwGetTime() - loopStartTime) / frameCount << " ms over "
+                  << frameCount << " frames (" << scene.instances.size() << " instances)" << std::endl;
+    if (frameTimes.count() > 0)
+        std::cout << "Frame time over the last " << frameTimes.count() << " frames: p50 " << frameTimes.percentile(0.5)
+                  << " ms, p99 " << frameTimes.percentile(0.99) << " ms" << std::endl;
+    if (frameCount > 0 && options.cull)
+        std::cout << "Culling per frame: drawn " << (culled.objects - culled.objectsCulled) / frameCount << " objects, culled "
+                  << culled.objectsCulled / frameCount << "; drawn " << (culled.triangles - culled.trianglesCulled) / frameCount
+                  << " triangles, culled " << culled.trianglesCulled / frameCount << std::endl;
+    if (frameCount > 0 && cullClusters)
+        std::cout << "Cluster culling per frame: " << clustersCulled.clusters / frameCount << " meshlets of full-detail shapes, "
+                  << clustersCulled.frustumCulled / frameCount << " outside the view, " << clustersCulled.backfaceCulled / frameCount
+                  << " facing away; culled " << clustersCulled.trianglesCulled / frameCount << " of "
+                  << clustersCulled.triangles / frameCount << " triangles" << std::endl;
+    if (frameCount > 0 && options.load.lodLevels > 0 && !options.stream) {
+        std::cout << "Levels of detail per frame:";
+        for (unsigned level = 0; level <= maxLodLevels; ++level) {
+            if (lodsDrawn.records[level] > 0)
+                std::cout << " LOD" << level << " " << lodsDrawn.records[level] / frameCount << " shapes/"
+                          << lodsDrawn.triangles[level] / frameCount << " triangles";
+        }
+        std::cout << std::endl;
     }
+    const StreamStats& streamed = buffers.drawTable().streamStats();
+    if (streamed.frames > 0)
+        std::cout << "Command streaming per frame: " << streamed.bytes / streamed.frames << " bytes, "
+                  << streamed.fenceWaitMillis / streamed.frames << " ms waiting on fences (" << streamed.fenceWaits
+                  << " waits in " << streamed.frames << " frames)" << std::endl;
+    if (options.stream)
+        std::cout << "Page pool: " << pagePool.pagesLoaded() << " pages loaded, " << pagePool.pagesEvicted()
+                  << " evicted, " << pagePool.slotCount() << " slots" << std::endl;
+    bool framesMatch = reportFrameFiles(options, frameFiles, frameCount);
+    bool recorded = saveRecording(options, simulation.recording);
+    timing.report(std::cout);
 
     // Clean up and delete all the objects we've created
-    glDeleteVertexArrays(1, &VAO);        // Delete the VAO
-    glDeleteBuffers(1, &VBO);             // Delete the VBO
+    timing.destroyQueries();                // Delete the timer queries, if any
+    buffers.destroy();                      // Delete the VAO, VBO and EBO
+    offscreen.destroy();                    // Delete the offscreen framebuffer, if any
+    pagePool.destroy();                     // Delete the page pool's VAO, VBO and EBO
     glDeleteProgram(shaderProgram);         // Delete the shader program
     glfwDestroyWindow(window);              // Destroy the window
     glfwTerminate();                        // Terminate GLFW
 
-    return 0;
+    // Report a failed load, or frames that do not match the expected images, with an error code
+    return loader.failed() || pager.failed() || !framesMatch || !recorded ? 1 : 0;
 }
 
-// Function to process user input and update the transformation matrix
-void processInput(GLFWwindow* window, glm::mat4 &transform) {
-    // Define movement parameters
-    const float translationDistance = 0.01f; // Distance for translation
-    const float rotationAngle = glm::radians(1.0f); // Angle for rotation in radians
-    const float scaleFactor = 1.01f; // Scaling factor
+void cursorPositionCallback(GLFWwindow* window, double x, double y) {
+    PickRequest* request = static_cast<PickRequest*>(glfwGetWindowUserPointer(window));
+    request->cursorX = x;
+    request->cursorY = y;
+}
+
+void mouseButtonCallback(GLFWwindow* window, int button, int action, int /*mods*/) {
+    if (button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_PRESS)
+        static_cast<PickRequest*>(glfwGetWindowUserPointer(window))->requested = true;
+}
+
+void checkFrame(const Options& options, const std::vector<uint8_t>& rgb, int width, int height, unsigned frame, FrameFiles& files) {
+    char name[32];
+    if (!options.outputDir.empty()) {
+        std::snprintf(name, sizeof(name), "/frame_%05u.", frame);
+        std::string path = options.outputDir + name + options.imageFormat;
+        if (writeImage(path, width, height, rgb.data()))
+            ++files.written;
+        else
+            std::cerr << "Cannot write " << path << std::endl;
+    }
+    if (!options.compareDir.empty()) {
+        std::snprintf(name, sizeof(name), "/frame_%05u.ppm", frame);
+        int expectedWidth = 0, expectedHeight = 0;
+        uint64_t differing = 0;
+        if (!readPpm(options.compareDir + name, expectedWidth, expectedHeight, files.expected) ||
+            expectedWidth != width || expectedHeight != height) {
+            differing = uint64_t(width) * height; // A missing or mis-sized frame differs everywhere
+        } else {
+            for (std::size_t i = 0; i < rgb.size(); i += 3)
+                differing += rgb[i] != files.expected[i] || rgb[i + 1] != files.expected[i + 1] || rgb[i + 2] != files.expected[i + 2];
+        }
+        ++files.compared;
+        if (differing > 0) {
+            std::cout << "Frame " << frame << " differs from " << options.compareDir << name << " in " << differing
+                      << " pixels" << std::endl;
+            ++files.differing;
+            files.pixelsDiffering += differing;
+        }
+    }
+}
+
+bool reportFrameFiles(const Options& options, const FrameFiles& files, unsigned frames) {
+    if (!options.outputDir.empty())
+        std::cout << "Frames written: " << files.written << " of " << frames << " to " << options.outputDir << std::endl;
+    if (!options.compareDir.empty())
+        std::cout << "Frames compared: " << files.compared << ", " << files.differing << " differing in "
+                  << files.pixelsDiffering << " pixels" << std::endl;
+    return files.differing == 0 && (options.outputDir.empty() || files.written == frames);
+}
+
+bool saveRecording(const Options& options, const std::vector<ScriptStep>& recording) {
+    if (options.recordFile.empty())
+        return true;
+    std::string message;
+    if (!saveCameraScript(options.recordFile, recording, message)) {
+        std::cerr << message << std::endl;
+        return false;
+    }
+    std::cout << "Recorded " << scriptLength(recording) << " ticks of input at " << options.simulationRate << " Hz in "
+              << recording.size() << " steps to " << options.recordFile << std::endl;
+    return true;
+}
+
+SimulationClock simulationClock(const Options& options, bool offline) {
+    return SimulationClock(options.simulationRate, options.frameRate, options.scriptFile.empty() && !offline);
+}
+
+glm::mat4 simulate(const Options& options, GLFWwindow* window, const std::vector<ScriptStep>& script, Simulation& simulation) {
+    // The keyboard is read once a frame and held for all of the frame's ticks
+    std::string held;
+    if (options.scriptFile.empty() && window != nullptr)
+        held = processInput(window);
+    unsigned ticks = simulation.clock.advance();
+    for (uint64_t tick = simulation.clock.ticks() - ticks; tick < simulation.clock.ticks(); ++tick) {
+        std::string keys = options.scriptFile.empty() ? held : scriptKeys(script, tick);
+        simulation.previous = simulation.current;
+        applyKeys(keys, simulation.clock.tickSeconds(), simulation.current);
+        if (options.updateLoadMillis > 0.0f) {
+            // Stand-in for an expensive scene update: keep the CPU busy for the requested time
+            auto until = std::chrono::steady_clock::now() + std::chrono::duration<double, std::milli>(options.updateLoadMillis);
+            while (std::chrono::steady_clock::now() < until) {
+            }
+        }
+        if (!options.recordFile.empty())
+            recordKeys(simulation.recording, keys);
+    }
+    return interpolateTransform(simulation.previous, simulation.current, simulation.clock.alpha());
+}
 
+glm::mat4 snapshotTransform(const SceneSnapshot& snapshot, std::chrono::steady_clock::time_point time) {
+    if (snapshot.tickSeconds <= 0.0)
+        return snapshot.current;
+    double ahead = std::chrono::duration<double>(snapshot.tickTime - time).count() / snapshot.tickSeconds;
+    float alpha = static_cast<float>(std::min(std::max(1.0 - ahead, 0.0), 1.0));
+    return interpolateTransform(snapshot.previous, snapshot.current, alpha);
+}
+
+int runSoftware(const Options& options, const Scene& scene, const std::vector<ScriptStep>& script, bool offline, AssetLoader& loader) {
+    // A window needs GL only to show the finished images
+    GLFWwindow* window = nullptr;
+    OffscreenTarget presenter;
+    if (!options.headless) {
+        window = createGlWindow(800, 800, "A3", WindowMode::Visible);
+        if (window == nullptr) {
+            std::cerr << "Cannot create a window to show the software frames; use --headless" << std::endl;
+            return 1; // Exit the program with an error code
+        }
+        if (!presenter.create(800, 800)) {
+            std::cerr << "Cannot show the software frames in the window; use --headless" << std::endl;
+            presenter.destroy();
+            glfwDestroyWindow(window);
+            glfwTerminate();
+            return 1; // Exit the program with an error code
+        }
+        glfwSwapInterval(options.vsync ? 1 : 0);
+    }
+
+    SoftwareRenderer renderer;
+    renderer.resize(800, 800);
+    ThreadPool pool(options.renderThreads);
+    std::cout << "Software rendering on " << pool.size() << " threads" << std::endl;
+
+    // Shapes are added as the loader finishes them; offline runs wait for all of them
+    IndexedGeometry chunk;
+    while (offline && !loader.failed() && !loader.drained()) {
+        if (loader.tryPop(chunk))
+            renderer.addShapes(chunk);
+        else
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    Simulation simulation(simulationClock(options, offline));
+    FrameFiles frameFiles;
+    SoftwareStats drawn;                   // Summed over every frame
+    unsigned frameCount = 0;
+    unsigned framesThisSecond = 0;
+    auto loopStart = std::chrono::steady_clock::now();
+    auto titleUpdate = loopStart;
+    while (window != nullptr ? !glfwWindowShouldClose(window) : frameCount < options.frameLimit) {
+        glm::mat4 transform = simulate(options, window, script, simulation);
+
+        while (loader.tryPop(chunk))
+            renderer.addShapes(chunk);
+        if (loader.failed())
+            break; // Nothing to show if the OBJ cannot be loaded
+
+        drawn += renderer.render(scene.instances, transform, !options.fill, options.cull, options.cullBackfaces, pool);
+        checkFrame(options, renderer.pixels(), renderer.width(), renderer.height(), frameCount, frameFiles);
+        if (window != nullptr) {
+            presenter.present(renderer.pixels().data());
+            glfwSwapBuffers(window);
+            glfwPollEvents();
+        }
+
+        // Show the mean frame time of the last second in the title bar
+        ++frameCount;
+        ++framesThisSecond;
+        auto now = std::chrono::steady_clock::now();
+        double sinceTitle = std::chrono::duration<double>(now - titleUpdate).count();
+        if (window != nullptr && sinceTitle >= 1.0) {
+            std::string title = "A3 (software) - " + std::to_string(scene.instances.size()) + " instances - " +
+                                std::to_string(1000.0 * sinceTitle / framesThisSecond) + " ms/frame";
+            glfwSetWindowTitle(window, title.c_str());
+            titleUpdate = now;
+            framesThisSecond = 0;
+        }
+        if (options.frameLimit != 0 && frameCount >= options.frameLimit)
+            break; // Scripted runs stop after a fixed number of frames
+        if (window != nullptr)
+            simulation.clock.waitForNextFrame(); // Hold the --fps cap
+    }
+
+    if (frameCount > 0) {
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - loopStart).count();
+        std::cout << "Mean frame time: " << 1000.0 * seconds / frameCount << " ms over " << frameCount << " frames ("
+                  << scene.instances.size() << " instances, " << frameCount / seconds << " frames/s)" << std::endl;
+        std::cout << "Software stages per frame: vertex " << drawn.vertexMillis / frameCount << " ms, binning "
+                  << drawn.binMillis / frameCount << " ms, raster " << drawn.rasterMillis / frameCount << " ms; "
+                  << drawn.trianglesDrawn / frameCount << " of " << drawn.triangles / frameCount << " triangles drawn, "
+                  << drawn.tileEntries / frameCount << " tile entries" << std::endl;
+    }
+    bool framesMatch = reportFrameFiles(options, frameFiles, frameCount);
+    bool recorded = saveRecording(options, simulation.recording);
+
+    if (window != nullptr) {
+        presenter.destroy();
+        glfwDestroyWindow(window);
+        glfwTerminate();
+    }
+    return loader.failed() || !framesMatch || !recorded ? 1 : 0;
+}
+
+// Function to process user input and return the movement keys held
+std::string processInput(GLFWwindow* window) {
     // Close the window when the Escape key is pressed
     if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
         glfwSetWindowShouldClose(window, true); // Set the window to close
 
-    // Translate the object based on key inputs
-    if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
-        transform = glm::translate(transform, glm::vec3(0.0f, translationDistance, 0.0f)); // Move up
-    if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
-        transform = glm::translate(transform, glm::vec3(0.0f, -translationDistance, 0.0f)); // Move down
-    if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS)
-        transform = glm::translate(transform, glm::vec3(-translationDistance, 0.0f, 0.0f)); // Move left
-    if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
-        transform = glm::translate(transform, glm::vec3(translationDistance, 0.0f, 0.0f)); // Move right
-
-    // Rotate the object based on key inputs
-    if (glfwGetKey(window, GLFW_KEY_Q) == GLFW_PRESS)
-        transform = glm::rotate(transform, rotationAngle, glm::vec3(0.0f, 1.0f, 0.0f)); // Rotate clockwise
-    if (glfwGetKey(window, GLFW_KEY_E) == GLFW_PRESS)
-        transform = glm::rotate(transform, -rotationAngle, glm::vec3(0.0f, 1.0f, 0.0f)); // Rotate counterclockwise
-
-    // Scale the object based on key inputs
-    if (glfwGetKey(window, GLFW_KEY_R) == GLFW_PRESS)
-        transform = glm::scale(transform, glm::vec3(scaleFactor, scaleFactor, scaleFactor)); // Scale up
-    if (glfwGetKey(window, GLFW_KEY_F) == GLFW_PRESS)
-        transform = glm::scale(transform, glm::vec3(1.0f / scaleFactor, 1.0f / scaleFactor, 1.0f / scaleFactor)); // Scale down
+    // The simulation moves the object by the keys held, as a camera script would
+    std::string keys;
+    for (char key : std::string("WSADQERF")) {
+        if (glfwGetKey(window, key) == GLFW_PRESS) // GLFW key codes of letters are their upper-case ASCII
+            keys += key;
+    }
+    return keys;
 }
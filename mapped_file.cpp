@@ -0,0 +1,52 @@
+#include "mapped_file.h"
+
+#include <fcntl.h>                         // For open()
+#include <sys/mman.h>                      // For mmap()/munmap()/madvise()
+#include <sys/stat.h>                      // For fstat()
+#include <unistd.h>                        // For close()/sysconf()
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+bool MappedFile::open(const std::string& path) {
+    close();
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size <= 0) { // Empty files cannot be mapped
+        ::close(fd);
+        return false;
+    }
+
+    void* mapping = mmap(nullptr, static_cast<std::size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd); // The mapping keeps its own reference to the file
+    if (mapping == MAP_FAILED)
+        return false;
+
+    madvise(mapping, static_cast<std::size_t>(info.st_size), MADV_SEQUENTIAL); // Every reader walks the file front to back
+    data_ = static_cast<const char*>(mapping);
+    size_ = static_cast<std::size_t>(info.st_size);
+    return true;
+}
+
+void MappedFile::release(std::size_t offset, std::size_t length) const {
+    static const std::size_t pageSize = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+    if (data_ == nullptr || offset >= size_)
+        return;
+    std::size_t end = offset + length < size_ ? offset + length : size_;
+    std::size_t first = (offset + pageSize - 1) / pageSize * pageSize; // The mapping itself is page aligned
+    std::size_t last = end == size_ ? end : end / pageSize * pageSize; // The tail page belongs to nobody else
+    if (last > first)
+        madvise(const_cast<char*>(data_) + first, last - first, MADV_DONTNEED);
+}
+
+void MappedFile::close() {
+    if (data_ != nullptr)
+        munmap(const_cast<char*>(data_), size_);
+    data_ = nullptr;
+    size_ = 0;
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstddef>                         // For std::size_t
+#include <string>                          // For file paths
+
+// Read-only memory mapping of a whole file, unmapped when the object goes out of scope
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Map the file at path, returns false (and leaves the object empty) if it cannot be opened
+    bool open(const std::string& path);
+    // Unmap the file if one is mapped
+    void close();
+    // Drop the resident pages of [offset, offset + length) once they have been read. Only whole
+    // pages inside the range are released; reading them again faults them back in from the file.
+    void release(std::size_t offset, std::size_t length) const;
+
+    const char* data() const { return data_; }
+    std::size_t size() const { return size_; }
+    bool isOpen() const { return data_ != nullptr; }
+
+private:
+    const char* data_ = nullptr;           // Start of the mapping
+    std::size_t size_ = 0;                 // Length of the mapping in bytes
+};
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstdint>                         // Fixed-width integer types
+#include <string>                          // For shape names
+#include <vector>                          // For using the std::vector container
+
+// Index triple into the position, normal and texcoord arrays (-1 when the attribute is absent)
+struct MeshIndex {
+    int32_t vertex;                        // Index of the xyz triple in Mesh::positions
+    int32_t normal;                        // Index of the xyz triple in Mesh::normals
+    int32_t texcoord;                      // Index of the uv pair in Mesh::texcoords
+};
+
+// Range of triangle corners that belongs to one "o" object of the OBJ file
+struct MeshShape {
+    std::string name;                      // Object name as written after "o"
+    uint32_t firstIndex;                   // First corner in Mesh::indices
+    uint32_t indexCount;                   // Number of corners (three per triangle)
+};
+
+// Triangulated mesh holding the same data as tinyobj's attrib_t + shape_t, flattened into one range table
+struct Mesh {
+    std::vector<float> positions;          // xyz per OBJ "v" record
+    std::vector<float> normals;            // xyz per OBJ "vn" record
+    std::vector<float> texcoords;          // uv per OBJ "vt" record
+    std::vector<MeshIndex> indices;        // Three corners per triangle, all shapes back to back
+    std::vector<int32_t> materialIds;      // Material per triangle (-1 when none is assigned)
+    std::vector<MeshShape> shapes;         // Per-object ranges into indices
+};
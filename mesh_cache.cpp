@@ -0,0 +1,201 @@
+#include "mesh_cache.h"
+
+#include <algorithm>                       // For std::min()
+#include <cstdio>                          // For std::rename()/std::remove()
+#include <cstring>                         // For std::memcpy()
+#include <filesystem>                      // For file size and modification time
+#include <fstream>                         // For writing the cache file
+#include "mapped_file.h"                   // Cache and OBJ files are read through mmap
+
+namespace {
+
+const char cacheMagic[8] = {'A', '3', 'M', 'E', 'S', 'H', '\0', '\0'};
+const uint32_t cacheVersion = 2;           // Bump whenever the layout below, or how its contents are derived, changes
+
+// Fixed header at the start of every cache file, followed by the sections in declaration order
+struct CacheHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t shapeCount;
+    uint64_t sourceSize;
+    int64_t sourceModifiedTime;
+    uint64_t sourceHash;
+    uint64_t textParseMicros;              // How long the text path took, for the startup comparison
+    uint64_t positionCount;                // Floats, not vertices
+    uint64_t normalCount;
+    uint64_t texcoordCount;
+    uint64_t indexCount;
+    uint64_t materialIdCount;
+    uint64_t nameBytes;
+};
+
+// One entry of the shape table; names live in a separate blob
+struct CacheShape {
+    uint32_t firstIndex;
+    uint32_t indexCount;
+    uint32_t nameOffset;
+    uint32_t nameLength;
+};
+
+// Sections are padded so every array starts on an 8-byte boundary inside the mapping
+std::size_t padded(std::size_t bytes) {
+    return (bytes + 7) & ~std::size_t(7);
+}
+
+// Copy count elements of T from the mapping and advance the cursor, false if the file is truncated.
+// A corrupt count is rejected before anything is multiplied or allocated, so it cannot overflow.
+template <typename T>
+bool readSection(const MappedFile& file, std::size_t& cursor, uint64_t count, std::vector<T>& out) {
+    if (cursor > file.size() || count > (file.size() - cursor) / sizeof(T))
+        return false;
+    std::size_t bytes = static_cast<std::size_t>(count) * sizeof(T);
+    out.resize(static_cast<std::size_t>(count));
+    if (bytes > 0)
+        std::memcpy(out.data(), file.data() + cursor, bytes);
+    cursor += padded(bytes);
+    return true;
+}
+
+template <typename T>
+void writeSection(std::ofstream& out, const T* data, std::size_t count) {
+    static const char zeros[8] = {};
+    std::size_t bytes = count * sizeof(T);
+    out.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(bytes));
+    out.write(zeros, static_cast<std::streamsize>(padded(bytes) - bytes));
+}
+
+} // namespace
+
+std::string meshCachePath(const std::string& objPath) {
+    return objPath + ".a3cache";
+}
+
+bool stampMeshSource(const std::string& objPath, MeshSourceStamp& stamp) {
+    std::error_code error;
+    auto modified = std::filesystem::last_write_time(objPath, error);
+    if (error)
+        return false;
+
+    MappedFile file;
+    if (!file.open(objPath))
+        return false;
+
+    // Hashed in windows whose pages are dropped behind the loop, so a large OBJ never becomes fully resident
+    const std::size_t window = std::size_t(8) << 20;
+    uint64_t hash = 14695981039346656037ull; // FNV-1a offset basis
+    for (std::size_t offset = 0; offset < file.size(); offset += window) {
+        std::size_t end = std::min(offset + window, file.size());
+        for (std::size_t i = offset; i < end; ++i) {
+            hash ^= static_cast<unsigned char>(file.data()[i]);
+            hash *= 1099511628211ull;       // FNV-1a prime
+        }
+        file.release(offset, end - offset);
+    }
+
+    stamp.size = file.size();
+    stamp.modifiedTime = static_cast<int64_t>(modified.time_since_epoch().count());
+    stamp.contentHash = hash;
+    return true;
+}
+
+bool readMeshCache(const std::string& objPath, const MeshSourceStamp& stamp, Mesh& mesh, double& textParseMillis) {
+    MappedFile file;
+    if (!file.open(meshCachePath(objPath)) || file.size() < sizeof(CacheHeader))
+        return false;
+
+    CacheHeader header;
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (std::memcmp(header.magic, cacheMagic, sizeof(cacheMagic)) != 0 || header.version != cacheVersion)
+        return false;
+    if (header.sourceSize != stamp.size || header.sourceModifiedTime != stamp.modifiedTime ||
+        header.sourceHash != stamp.contentHash)
+        return false; // The OBJ changed since the cache was written
+
+    std::size_t cursor = padded(sizeof(CacheHeader));
+    std::vector<CacheShape> shapeTable;
+    std::vector<char> names;
+    Mesh loaded;
+    if (!readSection(file, cursor, header.positionCount, loaded.positions) ||
+        !readSection(file, cursor, header.normalCount, loaded.normals) ||
+        !readSection(file, cursor, header.texcoordCount, loaded.texcoords) ||
+        !readSection(file, cursor, header.indexCount, loaded.indices) ||
+        !readSection(file, cursor, header.materialIdCount, loaded.materialIds) ||
+        !readSection(file, cursor, header.shapeCount, shapeTable) ||
+        !readSection(file, cursor, header.nameBytes, names))
+        return false;
+
+    // Every corner must point into the arrays just read; -1 marks a missing normal or texcoord
+    uint64_t positionCount = loaded.positions.size() / 3, normalCount = loaded.normals.size() / 3;
+    uint64_t texcoordCount = loaded.texcoords.size() / 2;
+    for (const MeshIndex& index : loaded.indices) {
+        if (index.vertex < 0 || uint64_t(index.vertex) >= positionCount ||
+            index.normal < -1 || (index.normal >= 0 && uint64_t(index.normal) >= normalCount) ||
+            index.texcoord < -1 || (index.texcoord >= 0 && uint64_t(index.texcoord) >= texcoordCount))
+            return false;
+    }
+
+    loaded.shapes.reserve(shapeTable.size());
+    for (const CacheShape& entry : shapeTable) {
+        if (uint64_t(entry.nameOffset) + entry.nameLength > names.size() ||
+            uint64_t(entry.firstIndex) + entry.indexCount > loaded.indices.size())
+            return false;
+        loaded.shapes.push_back({std::string(names.data() + entry.nameOffset, entry.nameLength),
+                                 entry.firstIndex, entry.indexCount});
+    }
+
+    mesh = std::move(loaded);
+    textParseMillis = header.textParseMicros / 1000.0;
+    return true;
+}
+
+bool writeMeshCache(const std::string& objPath, const MeshSourceStamp& stamp, const Mesh& mesh, double textParseMillis) {
+    std::vector<CacheShape> shapeTable;
+    std::string names;
+    for (const MeshShape& shape : mesh.shapes) {
+        shapeTable.push_back({shape.firstIndex, shape.indexCount,
+                              static_cast<uint32_t>(names.size()), static_cast<uint32_t>(shape.name.size())});
+        names += shape.name;
+    }
+
+    CacheHeader header = {};
+    std::memcpy(header.magic, cacheMagic, sizeof(cacheMagic));
+    header.version = cacheVersion;
+    header.shapeCount = static_cast<uint32_t>(shapeTable.size());
+    header.sourceSize = stamp.size;
+    header.sourceModifiedTime = stamp.modifiedTime;
+    header.sourceHash = stamp.contentHash;
+    header.textParseMicros = static_cast<uint64_t>(textParseMillis * 1000.0);
+    header.positionCount = mesh.positions.size();
+    header.normalCount = mesh.normals.size();
+    header.texcoordCount = mesh.texcoords.size();
+    header.indexCount = mesh.indices.size();
+    header.materialIdCount = mesh.materialIds.size();
+    header.nameBytes = names.size();
+
+    // Write to a temporary file first so a crash never leaves a half-written cache behind
+    std::string finalPath = meshCachePath(objPath);
+    std::string tempPath = finalPath + ".tmp";
+    {
+        std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+        if (!out)
+            return false;
+        writeSection(out, &header, 1);
+        writeSection(out, mesh.positions.data(), mesh.positions.size());
+        writeSection(out, mesh.normals.data(), mesh.normals.size());
+        writeSection(out, mesh.texcoords.data(), mesh.texcoords.size());
+        writeSection(out, mesh.indices.data(), mesh.indices.size());
+        writeSection(out, mesh.materialIds.data(), mesh.materialIds.size());
+        writeSection(out, shapeTable.data(), shapeTable.size());
+        writeSection(out, names.data(), names.size());
+        if (!out) {
+            out.close();
+            std::remove(tempPath.c_str());
+            return false;
+        }
+    }
+    if (std::rename(tempPath.c_str(), finalPath.c_str()) != 0) {
+        std::remove(tempPath.c_str());
+        return false;
+    }
+    return true;
+}
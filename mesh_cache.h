@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstdint>                         // Fixed-width integer types
+#include <string>                          // For file paths
+#include "mesh.h"                          // Mesh layout stored in the cache
+
+// Identity of the OBJ a cache was built from; any difference invalidates the cache
+struct MeshSourceStamp {
+    uint64_t size = 0;                     // File size in bytes
+    int64_t modifiedTime = 0;              // Last write time in file-clock ticks
+    uint64_t contentHash = 0;              // FNV-1a hash of the file contents
+};
+
+// Path of the binary cache written next to an OBJ file
+std::string meshCachePath(const std::string& objPath);
+
+// Compute the stamp of an OBJ file, returns false if the file cannot be read
+bool stampMeshSource(const std::string& objPath, MeshSourceStamp& stamp);
+
+// Load a mesh from the cache of objPath if it exists and matches the stamp.
+// textParseMillis receives the time the original text parse took when the cache was written.
+bool readMeshCache(const std::string& objPath, const MeshSourceStamp& stamp, Mesh& mesh, double& textParseMillis);
+
+// Write the cache for objPath, returns false if the file cannot be written
+bool writeMeshCache(const std::string& objPath, const MeshSourceStamp& stamp, const Mesh& mesh, double textParseMillis);
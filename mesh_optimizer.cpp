@@ -0,0 +1,169 @@
+#include "mesh_optimizer.h"
+
+#include <cmath>                           // For std::pow()
+#include <vector>                          // For using the std::vector container
+
+namespace {
+
+// Forsyth's scoring: the last triangle's corners score the same so the order within it does not
+// matter, older entries fall off with a power curve, and vertices with few triangles left get a
+// boost so they are finished off instead of leaving lone triangles behind
+const float lastTriangleScore = 0.75f;
+const float cacheDecayPower = 1.5f;
+const float valenceBoostScale = 2.0f;
+const float valenceBoostPower = 0.5f;
+const unsigned maxValenceScored = 32;      // Boosts above this are too small to matter
+
+struct ScoreTables {
+    float cache[vertexCacheSize];
+    float valence[maxValenceScored + 1];
+
+    ScoreTables() {
+        for (unsigned position = 0; position < vertexCacheSize; ++position) {
+            cache[position] = position < 3 ? lastTriangleScore
+                                           : std::pow(1.0f - float(position - 3) / float(vertexCacheSize - 3), cacheDecayPower);
+        }
+        valence[0] = 0.0f;
+        for (unsigned count = 1; count <= maxValenceScored; ++count)
+            valence[count] = valenceBoostScale * std::pow(float(count), -valenceBoostPower);
+    }
+};
+
+const ScoreTables scoreTables;
+
+float vertexScore(int cachePosition, uint32_t liveTriangles) {
+    if (liveTriangles == 0)
+        return -1.0f; // Nothing left to draw with it
+    float score = cachePosition >= 0 ? scoreTables.cache[cachePosition] : 0.0f;
+    return score + scoreTables.valence[liveTriangles < maxValenceScored ? liveTriangles : maxValenceScored];
+}
+
+} // namespace
+
+void optimizeVertexCache(uint32_t* indices, std::size_t indexCount, std::size_t vertexCount) {
+    std::size_t triangleCount = indexCount / 3;
+    if (triangleCount < 2)
+        return;
+
+    // Triangles of every vertex; each vertex's live triangles are kept at the front of its range
+    std::vector<uint32_t> liveTriangles(vertexCount, 0);
+    for (std::size_t i = 0; i < 3 * triangleCount; ++i)
+        ++liveTriangles[indices[i]];
+    std::vector<uint32_t> adjacencyStart(vertexCount + 1, 0);
+    for (std::size_t v = 0; v < vertexCount; ++v)
+        adjacencyStart[v + 1] = adjacencyStart[v] + liveTriangles[v];
+    std::vector<uint32_t> adjacency(3 * triangleCount);
+    std::vector<uint32_t> fill(adjacencyStart.begin(), adjacencyStart.end() - 1);
+    for (std::size_t i = 0; i < 3 * triangleCount; ++i)
+        adjacency[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+
+    std::vector<int> cachePosition(vertexCount, -1);
+    std::vector<float> score(vertexCount);
+    for (std::size_t v = 0; v < vertexCount; ++v)
+        score[v] = vertexScore(-1, liveTriangles[v]);
+    std::vector<float> triangleScore(triangleCount);
+    std::vector<uint8_t> emitted(triangleCount, 0);
+    std::size_t best = 0;
+    for (std::size_t t = 0; t < triangleCount; ++t) {
+        triangleScore[t] = score[indices[3 * t]] + score[indices[3 * t + 1]] + score[indices[3 * t + 2]];
+        if (triangleScore[t] > triangleScore[best])
+            best = t;
+    }
+
+    std::vector<uint32_t> order;
+    order.reserve(3 * triangleCount);
+    uint32_t cache[vertexCacheSize + 3];   // Room for the three corners pushed in front
+    uint32_t newCache[vertexCacheSize + 3];
+    unsigned cacheCount = 0;
+    std::size_t cursor = 0;                // Fallback scan position when no cached vertex has triangles left
+    while (order.size() < 3 * triangleCount) {
+        if (best == SIZE_MAX) {
+            while (emitted[cursor])
+                ++cursor;
+            best = cursor;
+        }
+        const uint32_t* corners = &indices[3 * best];
+        emitted[best] = 1;
+        order.insert(order.end(), corners, corners + 3);
+
+        // Retire the triangle from its corners' live lists
+        for (int k = 0; k < 3; ++k) {
+            uint32_t vertex = corners[k];
+            uint32_t* live = &adjacency[adjacencyStart[vertex]];
+            for (uint32_t i = 0; i < liveTriangles[vertex]; ++i) {
+                if (live[i] == best) {
+                    live[i] = live[liveTriangles[vertex] - 1];
+                    live[liveTriangles[vertex] - 1] = static_cast<uint32_t>(best);
+                    break;
+                }
+            }
+            --liveTriangles[vertex];
+        }
+
+        // Move the corners to the front of the LRU cache
+        unsigned newCount = 0;
+        for (int k = 0; k < 3; ++k)
+            newCache[newCount++] = corners[k];
+        for (unsigned i = 0; i < cacheCount; ++i) {
+            uint32_t vertex = cache[i];
+            if (vertex != corners[0] && vertex != corners[1] && vertex != corners[2])
+                newCache[newCount++] = vertex;
+        }
+
+        // Rescore the vertices that moved, including the ones that just fell out, then their triangles
+        for (unsigned i = 0; i < newCount; ++i) {
+            uint32_t vertex = newCache[i];
+            cachePosition[vertex] = i < vertexCacheSize ? static_cast<int>(i) : -1;
+            score[vertex] = vertexScore(cachePosition[vertex], liveTriangles[vertex]);
+        }
+        best = SIZE_MAX;
+        float bestScore = -1.0f;
+        for (unsigned i = 0; i < newCount; ++i) {
+            uint32_t vertex = newCache[i];
+            for (uint32_t j = 0; j < liveTriangles[vertex]; ++j) {
+                uint32_t triangle = adjacency[adjacencyStart[vertex] + j];
+                const uint32_t* c = &indices[3 * std::size_t(triangle)];
+                triangleScore[triangle] = score[c[0]] + score[c[1]] + score[c[2]];
+                if (i < vertexCacheSize && triangleScore[triangle] > bestScore) {
+                    bestScore = triangleScore[triangle];
+                    best = triangle;
+                }
+            }
+        }
+        cacheCount = newCount < vertexCacheSize ? newCount : vertexCacheSize;
+        for (unsigned i = 0; i < cacheCount; ++i)
+            cache[i] = newCache[i];
+    }
+    for (std::size_t i = 0; i < order.size(); ++i)
+        indices[i] = order[i];
+}
+
+void optimizeVertexFetch(uint32_t* indices, std::size_t indexCount, std::size_t vertexCount, uint32_t* remap) {
+    const uint32_t unused = UINT32_MAX;
+    for (std::size_t v = 0; v < vertexCount; ++v)
+        remap[v] = unused;
+    uint32_t next = 0;
+    for (std::size_t i = 0; i < indexCount; ++i) {
+        if (remap[indices[i]] == unused)
+            remap[indices[i]] = next++;
+        indices[i] = remap[indices[i]];
+    }
+    for (std::size_t v = 0; v < vertexCount; ++v) {
+        if (remap[v] == unused)
+            remap[v] = next++;
+    }
+}
+
+uint64_t countCacheMisses(const uint32_t* indices, std::size_t indexCount, std::size_t vertexCount, unsigned cacheSize) {
+    // A vertex is cached while fewer than cacheSize misses happened since its own
+    std::vector<uint64_t> missedAt(vertexCount, 0);
+    uint64_t misses = 0;
+    for (std::size_t i = 0; i < indexCount; ++i) {
+        uint32_t vertex = indices[i];
+        if (missedAt[vertex] != 0 && misses + 1 - missedAt[vertex] <= cacheSize)
+            continue;
+        ++misses;
+        missedAt[vertex] = misses;
+    }
+    return misses;
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstddef>                         // For std::size_t
+#include <cstdint>                         // Fixed-width integer types
+
+// Entries of the post-transform cache the optimizer and the statistics assume
+const unsigned vertexCacheSize = 32;
+
+// Reorder the triangles of an indexed list so consecutive triangles reuse recently transformed
+// vertices, with Forsyth's linear-speed greedy scoring over a simulated LRU cache. Indices must be
+// below vertexCount; the triangles themselves and their winding are unchanged.
+void optimizeVertexCache(uint32_t* indices, std::size_t indexCount, std::size_t vertexCount);
+
+// Renumber vertices in the order the indices first use them, so the vertex fetch walks memory
+// forwards. Writes the new number of every old vertex into remap (vertexCount entries) and
+// rewrites indices; vertices the indices never use are numbered last, in their old order.
+void optimizeVertexFetch(uint32_t* indices, std::size_t indexCount, std::size_t vertexCount, uint32_t* remap);
+
+// Vertex shader invocations for an index list through a FIFO post-transform cache of cacheSize entries
+uint64_t countCacheMisses(const uint32_t* indices, std::size_t indexCount, std::size_t vertexCount, unsigned cacheSize);
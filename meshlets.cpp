@@ -0,0 +1,215 @@
+#include "meshlets.h"
+
+#include <algorithm>                       // For std::min()/std::max()
+#include <cmath>                           // For std::sqrt()
+#include <cstring>                         // For std::memcpy()
+#include <unordered_map>                   // Position -> position class lookup
+#include "mesh_optimizer.h"                // Vertex cache order within each meshlet
+
+namespace {
+
+// Bit pattern of a vertex position, so only exactly equal positions are welded
+struct PositionKey {
+    uint32_t bits[3];
+
+    bool operator==(const PositionKey& other) const {
+        return bits[0] == other.bits[0] && bits[1] == other.bits[1] && bits[2] == other.bits[2];
+    }
+};
+
+struct PositionKeyHash {
+    std::size_t operator()(const PositionKey& key) const {
+        return (key.bits[0] * 73856093u) ^ (key.bits[1] * 19349663u) ^ (key.bits[2] * 83492791u);
+    }
+};
+
+// Bounding sphere and normal cone of a meshlet made of triangles, whose unit normals (zero for
+// degenerate triangles) sum to normalSum
+Meshlet describeMeshlet(const std::vector<uint32_t>& triangles, const uint32_t* indices, const Vertex* vertices,
+                        const std::vector<float>& normals, const float normalSum[3]) {
+    Meshlet meshlet = {0, static_cast<uint32_t>(3 * triangles.size()), {}, 0.0f, {}, 1.0f};
+
+    // Sphere centred on the box of the corners, sized from the corners themselves as computeBounds() does
+    float min[3], max[3];
+    for (int axis = 0; axis < 3; ++axis)
+        min[axis] = max[axis] = vertices[indices[3 * std::size_t(triangles[0])]].position[axis];
+    for (uint32_t triangle : triangles) {
+        for (int k = 0; k < 3; ++k) {
+            const float* p = vertices[indices[3 * std::size_t(triangle) + k]].position;
+            for (int axis = 0; axis < 3; ++axis) {
+                min[axis] = std::min(min[axis], p[axis]);
+                max[axis] = std::max(max[axis], p[axis]);
+            }
+        }
+    }
+    for (int axis = 0; axis < 3; ++axis)
+        meshlet.center[axis] = 0.5f * (min[axis] + max[axis]);
+    float radiusSquared = 0.0f;
+    for (uint32_t triangle : triangles) {
+        for (int k = 0; k < 3; ++k) {
+            const float* p = vertices[indices[3 * std::size_t(triangle) + k]].position;
+            float dx = p[0] - meshlet.center[0], dy = p[1] - meshlet.center[1], dz = p[2] - meshlet.center[2];
+            radiusSquared = std::max(radiusSquared, dx * dx + dy * dy + dz * dz);
+        }
+    }
+    meshlet.radius = std::sqrt(radiusSquared);
+
+    // Cone around the mean normal; a spread of 90 degrees or more leaves nothing to cull
+    float length = std::sqrt(normalSum[0] * normalSum[0] + normalSum[1] * normalSum[1] + normalSum[2] * normalSum[2]);
+    if (length == 0.0f)
+        return meshlet;
+    float axis[3] = {normalSum[0] / length, normalSum[1] / length, normalSum[2] / length};
+    float minCos = 1.0f;
+    for (uint32_t triangle : triangles) {
+        const float* n = &normals[3 * std::size_t(triangle)];
+        if (n[0] != 0.0f || n[1] != 0.0f || n[2] != 0.0f)
+            minCos = std::min(minCos, n[0] * axis[0] + n[1] * axis[1] + n[2] * axis[2]);
+    }
+    if (minCos <= 0.0f)
+        return meshlet;
+    for (int k = 0; k < 3; ++k)
+        meshlet.coneAxis[k] = axis[k];
+    meshlet.coneSin = std::sqrt(std::max(0.0f, 1.0f - minCos * minCos));
+    return meshlet;
+}
+
+} // namespace
+
+std::vector<Meshlet> buildMeshlets(uint32_t* indices, std::size_t indexCount, const Vertex* vertices, std::size_t vertexCount) {
+    std::size_t triangleCount = indexCount / 3;
+    std::vector<Meshlet> meshlets;
+    if (triangleCount == 0)
+        return meshlets;
+
+    // Unit normal of every triangle, as wound (counter-clockwise front faces)
+    std::vector<float> normals(3 * triangleCount);
+    for (std::size_t t = 0; t < triangleCount; ++t) {
+        const float* a = vertices[indices[3 * t]].position;
+        const float* b = vertices[indices[3 * t + 1]].position;
+        const float* c = vertices[indices[3 * t + 2]].position;
+        float e1[3] = {b[0] - a[0], b[1] - a[1], b[2] - a[2]};
+        float e2[3] = {c[0] - a[0], c[1] - a[1], c[2] - a[2]};
+        float n[3] = {e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0]};
+        float length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+        for (int k = 0; k < 3; ++k)
+            normals[3 * t + k] = length > 0.0f ? n[k] / length : 0.0f;
+    }
+
+    // Vertices split at normal or texture seams share their position; growing through positions rather
+    // than indices lets a meshlet cross the seams of flat-shaded surfaces
+    std::vector<uint32_t> corner(vertexCount); // Position class of every vertex
+    std::unordered_map<PositionKey, uint32_t, PositionKeyHash> positions;
+    for (std::size_t v = 0; v < vertexCount; ++v) {
+        PositionKey key;
+        std::memcpy(key.bits, vertices[v].position, sizeof(key.bits));
+        corner[v] = positions.emplace(key, static_cast<uint32_t>(positions.size())).first->second;
+    }
+    std::size_t positionCount = positions.size();
+
+    // Triangles at every position; each position's unassigned triangles are kept at the front of its range
+    std::vector<uint32_t> liveTriangles(positionCount, 0);
+    for (std::size_t i = 0; i < 3 * triangleCount; ++i)
+        ++liveTriangles[corner[indices[i]]];
+    std::vector<uint32_t> adjacencyStart(positionCount + 1, 0);
+    for (std::size_t c = 0; c < positionCount; ++c)
+        adjacencyStart[c + 1] = adjacencyStart[c] + liveTriangles[c];
+    std::vector<uint32_t> adjacency(3 * triangleCount);
+    std::vector<uint32_t> fill(adjacencyStart.begin(), adjacencyStart.end() - 1);
+    for (std::size_t i = 0; i < 3 * triangleCount; ++i)
+        adjacency[fill[corner[indices[i]]]++] = static_cast<uint32_t>(i / 3);
+
+    std::vector<uint8_t> assigned(triangleCount, 0);
+    std::vector<uint32_t> owner(vertexCount, UINT32_MAX);        // Meshlet currently holding each vertex
+    std::vector<uint32_t> positionOwner(positionCount, UINT32_MAX); // And each position
+    std::vector<uint32_t> local(vertexCount);                    // Number of a vertex within its meshlet
+    std::vector<uint32_t> order;
+    order.reserve(3 * triangleCount);
+    std::vector<uint32_t> triangles;       // Of the meshlet being grown
+    std::vector<uint32_t> meshletPositions;
+    uint32_t meshletVertices[maxMeshletVertices];
+    std::size_t seed = 0;
+    while (order.size() < 3 * triangleCount) {
+        while (assigned[seed])
+            ++seed;
+        uint32_t id = static_cast<uint32_t>(meshlets.size());
+        unsigned vertexUsed = 0;
+        float normalSum[3] = {0.0f, 0.0f, 0.0f};
+        triangles.clear();
+        meshletPositions.clear();
+
+        std::size_t next = seed;
+        for (;;) {
+            const uint32_t* corners = &indices[3 * next];
+            assigned[next] = 1;
+            triangles.push_back(static_cast<uint32_t>(next));
+            for (int k = 0; k < 3; ++k) {
+                normalSum[k] += normals[3 * next + k];
+                uint32_t vertex = corners[k];
+                if (owner[vertex] != id) {
+                    owner[vertex] = id;
+                    local[vertex] = vertexUsed;
+                    meshletVertices[vertexUsed++] = vertex;
+                }
+
+                // Retire the triangle from the position's live list
+                uint32_t position = corner[vertex];
+                if (positionOwner[position] != id) {
+                    positionOwner[position] = id;
+                    meshletPositions.push_back(position);
+                }
+                uint32_t* live = &adjacency[adjacencyStart[position]];
+                for (uint32_t i = 0; i < liveTriangles[position]; ++i) {
+                    if (live[i] == next) {
+                        live[i] = live[liveTriangles[position] - 1];
+                        live[liveTriangles[position] - 1] = static_cast<uint32_t>(next);
+                        --liveTriangles[position];
+                        break;
+                    }
+                }
+            }
+            if (triangles.size() == maxMeshletTriangles)
+                break;
+
+            // Grow by the neighbour adding the fewest vertices, then the one facing most like the meshlet
+            float length = std::sqrt(normalSum[0] * normalSum[0] + normalSum[1] * normalSum[1] + normalSum[2] * normalSum[2]);
+            float scale = length > 0.0f ? 1.0f / length : 0.0f;
+            std::size_t best = SIZE_MAX;
+            float bestScore = 0.0f;
+            for (uint32_t position : meshletPositions) {
+                for (uint32_t j = 0; j < liveTriangles[position]; ++j) {
+                    uint32_t candidate = adjacency[adjacencyStart[position] + j];
+                    const uint32_t* c = &indices[3 * std::size_t(candidate)];
+                    unsigned added = (owner[c[0]] != id) + (owner[c[1]] != id && c[1] != c[0]) +
+                                     (owner[c[2]] != id && c[2] != c[0] && c[2] != c[1]);
+                    if (vertexUsed + added > maxMeshletVertices)
+                        continue;
+                    const float* n = &normals[3 * std::size_t(candidate)];
+                    float alignment = (n[0] * normalSum[0] + n[1] * normalSum[1] + n[2] * normalSum[2]) * scale;
+                    float score = float(added) + 0.5f * (1.0f - alignment);
+                    if (best == SIZE_MAX || score < bestScore) {
+                        best = candidate;
+                        bestScore = score;
+                    }
+                }
+            }
+            if (best == SIZE_MAX)
+                break;                     // Full, or no neighbour left: start the next meshlet
+            next = best;
+        }
+
+        Meshlet meshlet = describeMeshlet(triangles, indices, vertices, normals, normalSum);
+        meshlet.firstIndex = static_cast<uint32_t>(order.size());
+        for (uint32_t triangle : triangles) {
+            for (int k = 0; k < 3; ++k)
+                order.push_back(local[indices[3 * std::size_t(triangle) + k]]);
+        }
+
+        // Growth order is poor for the post-transform cache; reorder within the meshlet on its own numbering
+        optimizeVertexCache(&order[meshlet.firstIndex], meshlet.indexCount, vertexUsed);
+        for (std::size_t i = meshlet.firstIndex; i < order.size(); ++i)
+            order[i] = meshletVertices[order[i]];
+        meshlets.push_back(meshlet);
+    }
+    std::copy(order.begin(), order.end(), indices);
+    return meshlets;
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <cstddef>                         // For std::size_t
+#include <cstdint>                         // Fixed-width integer types
+#include <vector>                          // For using the std::vector container
+#include "geometry.h"                      // Vertex layout and the Meshlet record
+
+// Partition an indexed triangle list into meshlets of at most maxMeshletVertices vertices and
+// maxMeshletTriangles triangles. A meshlet starts at the first unassigned triangle in index order and
+// grows by the triangle sharing a position with it that adds the fewest vertices, ties going to the
+// one whose normal is closest to the meshlet's, which keeps the normal cones narrow. Positions rather
+// than indices connect the triangles so meshlets cross normal and texture seams. The triangles are
+// rewritten meshlet by meshlet, so each meshlet is one index range, reordered within for the
+// post-transform cache.
+std::vector<Meshlet> buildMeshlets(uint32_t* indices, std::size_t indexCount, const Vertex* vertices, std::size_t vertexCount);
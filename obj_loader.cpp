@@ -0,0 +1,82 @@
+#include "obj_loader.h"
+
+#include <chrono>                          // For timing the load
+#include <iostream>                        // Standard input/output stream library
+#include "mesh_cache.h"                    // Binary cache for warm starts
+#include "obj_parser.h"                    // In-tree parallel parser
+#include "thread_pool.h"                   // Worker threads for the parallel parser
+#include "tiny_obj_loader.h"               // For loading OBJ files
+
+namespace {
+
+double millisecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Parse path with the parser chosen in settings
+bool parseObj(const std::string& path, const LoadSettings& settings, Mesh& mesh, std::string& message) {
+    if (settings.parser == ObjParser::Tinyobj)
+        return loadObjWithTinyobj(path, mesh, message);
+    ThreadPool pool(settings.threads);
+    return parseObjParallel(path, pool, mesh, message);
+}
+
+} // namespace
+
+bool loadObjWithTinyobj(const std::string& path, Mesh& mesh, std::string& message) {
+    tinyobj::attrib_t attrib; // Object to store vertex attributes
+    std::vector<tinyobj::shape_t> shapes; // Vector to store shapes
+    std::vector<tinyobj::material_t> materials; // Vector to store materials
+    std::string warn, err; // Strings to store warnings and errors
+
+    bool loaded = tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, path.c_str());
+    message += warn + err;
+    if (!loaded)
+        return false;
+
+    mesh = Mesh();
+    mesh.positions = std::move(attrib.vertices);
+    mesh.normals = std::move(attrib.normals);
+    mesh.texcoords = std::move(attrib.texcoords);
+
+    // tinyobj triangulates by default, so every face contributes exactly three indices
+    for (const auto& shape : shapes) {
+        MeshShape range = {shape.name, static_cast<uint32_t>(mesh.indices.size()),
+                           static_cast<uint32_t>(shape.mesh.indices.size())};
+        for (const auto& index : shape.mesh.indices)
+            mesh.indices.push_back({index.vertex_index, index.normal_index, index.texcoord_index});
+        mesh.materialIds.insert(mesh.materialIds.end(), shape.mesh.material_ids.begin(), shape.mesh.material_ids.end());
+        mesh.shapes.push_back(std::move(range));
+    }
+    return true;
+}
+
+bool loadMesh(const std::string& path, const LoadSettings& settings, Mesh& mesh) {
+    auto start = std::chrono::steady_clock::now();
+
+    MeshSourceStamp stamp;
+    if (settings.useCache && stampMeshSource(path, stamp)) {
+        double textParseMillis = 0.0;
+        if (readMeshCache(path, stamp, mesh, textParseMillis)) {
+            if (settings.verbose)
+                std::cout << "Loaded " << path << " from " << meshCachePath(path) << " in "
+                          << millisecondsSince(start) << " ms (text parse took " << textParseMillis << " ms)" << std::endl;
+            return true;
+        }
+    }
+
+    auto parseStart = std::chrono::steady_clock::now();
+    std::string message;
+    if (!parseObj(path, settings, mesh, message)) {
+        std::cerr << path << ": " << message << std::endl; // Print warnings and errors if loading fails
+        return false;
+    }
+    double parseMillis = millisecondsSince(parseStart);
+    if (settings.verbose)
+        std::cout << "Parsed " << path << " in " << parseMillis << " ms ("
+                  << (settings.parser == ObjParser::Tinyobj ? "tinyobj" : "parallel parser") << ")" << std::endl;
+
+    if (settings.useCache && stamp.size != 0 && !writeMeshCache(path, stamp, mesh, parseMillis))
+        std::cerr << "Could not write mesh cache " << meshCachePath(path) << std::endl;
+    return true;
+}
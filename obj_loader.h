@@ -0,0 +1,29 @@
+#pragma once
+
+#include <string>                          // For file paths and error messages
+#include "mesh.h"                          // Destination layout for every loader
+
+// Which parser turns the OBJ text into a Mesh
+enum class ObjParser {
+    Tinyobj,                               // tinyobj::LoadObj on the calling thread
+    Parallel                               // In-tree chunked parser on every core (obj_parser.h)
+};
+
+// How loadMesh() gets from an OBJ path to a Mesh
+struct LoadSettings {
+    bool useCache = true;                  // Read/write the binary cache next to the OBJ
+    ObjParser parser = ObjParser::Parallel;
+    unsigned threads = 0;                  // Threads for the parallel parser, 0 for all cores
+    bool verbose = true;                   // Print per-file timings (errors are always printed)
+    unsigned lodLevels = 3;                // Simplified levels built per shape while indexing, at most maxLodLevels
+    bool optimize = true;                  // Reorder triangles and vertices for the GPU caches while indexing
+    bool meshlets = true;                  // Group every shape's triangles into clusters for per-cluster culling
+};
+
+// Parse an OBJ file with tinyobjloader and flatten the result into mesh.
+// Warnings and errors reported by tinyobj are appended to message.
+bool loadObjWithTinyobj(const std::string& path, Mesh& mesh, std::string& message);
+
+// Load an OBJ file, going through the binary mesh cache next to it when settings.useCache is set.
+// Prints how long the load took and, on a warm start, how long the text parse used to take.
+bool loadMesh(const std::string& path, const LoadSettings& settings, Mesh& mesh);
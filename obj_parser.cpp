@@ -0,0 +1,436 @@
+#include "obj_parser.h"
+
+#include <algorithm>                       // For std::fill_n()
+#include <cmath>                           // For std::fabs()
+#include <cstring>                         // For std::memchr()
+#include <fstream>                         // For reading mtllib files
+#include <sstream>                         // For splitting mtllib file names
+#include <unordered_map>                   // Material name lookup during the merge
+#include "mapped_file.h"                   // The OBJ is parsed straight out of the mapping
+#include "obj_tokens.h"                    // Number and token kernels
+#include "thread_pool.h"                   // Chunks are counted and parsed on the pool
+
+namespace {
+
+// An "o" or "g" record, positioned by the number of triangles the chunk had produced before it
+struct ShapeStart {
+    std::string name;
+    uint32_t firstTriangle;
+};
+
+// An "mtllib" record, positioned by the number of usemtl records the chunk had seen before it
+struct MaterialLibrary {
+    std::string fileNames;
+    std::size_t materialSlot;
+};
+
+// One thread's slice of the file. The counting pass fills in the record counts, the prefix
+// sums over them place every chunk in the final arrays and the parsing passes write there.
+struct Chunk {
+    const char* begin = nullptr;
+    const char* end = nullptr;
+
+    // Filled in by the counting pass
+    std::size_t positionCount = 0;         // In records, not floats
+    std::size_t normalCount = 0;
+    std::size_t texcoordCount = 0;
+    std::size_t triangleCount = 0;
+    std::size_t lineCount = 0;
+    std::vector<std::string> materialNames;
+    int32_t lastMaterialSlot = -1;         // Material active at chunk end, -1 when the chunk never switched
+    std::vector<MaterialLibrary> materialLibraries;
+    std::vector<ShapeStart> shapeStarts;
+
+    // Filled in by the prefix sums and the material merge
+    std::size_t positionBase = 0;
+    std::size_t normalBase = 0;
+    std::size_t texcoordBase = 0;
+    std::size_t triangleBase = 0;
+    std::size_t firstLine = 0;
+    int32_t inheritedMaterial = -1;
+    std::vector<int32_t> materialIds;      // Global id per material slot
+
+    std::string error;                     // First error found in the chunk
+    std::size_t errorLine = 0;             // Line of that error, relative to the chunk
+};
+
+const char* skipSpaces(const char* p, const char* end) {
+    while (p < end && isObjSpace(*p))
+        ++p;
+    return p;
+}
+
+// Call fn(p, lineEnd) for every line of the chunk (without its newline), counting lines as it goes
+template <typename Fn>
+void forEachLine(const Chunk& chunk, std::size_t& line, Fn&& fn) {
+    const char* p = chunk.begin;
+    for (line = 0; p < chunk.end; ++line) {
+        const char* lineEnd = findLineEnd(p, chunk.end);
+        fn(p, lineEnd);
+        p = lineEnd + 1;
+    }
+}
+
+// Rest of the line with surrounding whitespace removed
+std::string restOfLine(const char* p, const char* end) {
+    p = skipSpaces(p, end);
+    while (end > p && isObjSpace(end[-1]))
+        --end;
+    return std::string(p, end);
+}
+
+// First pass: count the records of a chunk without parsing any numbers, so the
+// final arrays can be allocated once and every chunk knows where its records go
+void countChunk(Chunk& chunk) {
+    forEachLine(chunk, chunk.lineCount, [&](const char* p, const char* end) {
+        switch (classifyObjLine(p, end)) {
+        case ObjRecord::Position: ++chunk.positionCount; break;
+        case ObjRecord::Normal: ++chunk.normalCount; break;
+        case ObjRecord::Texcoord: ++chunk.texcoordCount; break;
+        case ObjRecord::Face: {
+            uint32_t corners = countTokens(p, end);
+            if (corners >= 3) // Points and lines are not part of the triangle mesh
+                chunk.triangleCount += corners - 2;
+            break;
+        }
+        case ObjRecord::Shape:
+            chunk.shapeStarts.push_back({restOfLine(p, end), static_cast<uint32_t>(chunk.triangleCount)});
+            break;
+        case ObjRecord::Material:
+            chunk.materialNames.push_back(restOfLine(p, end));
+            chunk.lastMaterialSlot = static_cast<int32_t>(chunk.materialNames.size() - 1);
+            break;
+        case ObjRecord::MaterialLibrary:
+            chunk.materialLibraries.push_back({restOfLine(p, end), chunk.materialNames.size()});
+            break;
+        case ObjRecord::Other: break;
+        }
+    });
+}
+
+// Number the newmtl records of the first file named by an mtllib record that can be read, after the
+// materialCount materials already known, as tinyobj does: a name defined twice keeps its first number.
+// tinyobj is given no base directory, so like it the file names are relative to the working directory.
+void readMaterialLibrary(const std::string& fileNames, std::unordered_map<std::string, int32_t>& materialIds,
+                         int32_t& materialCount) {
+    std::istringstream names(fileNames);
+    std::string fileName;
+    while (names >> fileName) {
+        std::ifstream in(fileName);
+        if (!in)
+            continue;
+        std::string line;
+        while (std::getline(in, line)) {
+            const char* p = skipSpaces(line.data(), line.data() + line.size());
+            const char* end = line.data() + line.size();
+            if (end - p > 6 && std::memcmp(p, "newmtl", 6) == 0 && isObjSpace(p[6])) {
+                std::string name = restOfLine(p + 6, end);
+                if (!name.empty())
+                    materialIds.emplace(name, materialCount++);
+            }
+        }
+        return;
+    }
+}
+
+// Record the first error of a chunk
+void setError(Chunk& chunk, std::size_t line, const std::string& error) {
+    if (chunk.error.empty()) {
+        chunk.error = error;
+        chunk.errorLine = line;
+    }
+}
+
+// Second pass: parse v/vn/vt records straight into their slots of the mesh
+void parseAttributes(Chunk& chunk, Mesh& mesh) {
+    float* position = mesh.positions.data() + 3 * chunk.positionBase;
+    float* normal = mesh.normals.data() + 3 * chunk.normalBase;
+    float* texcoord = mesh.texcoords.data() + 2 * chunk.texcoordBase;
+    std::size_t line = 0;
+    forEachLine(chunk, line, [&](const char* p, const char* end) {
+        const char* start = p;
+        bool parsed = true;
+        switch (classifyObjLine(p, end)) {
+        case ObjRecord::Position:
+            parsed = parseObjFloat(p, end, position[0]) && parseObjFloat(p, end, position[1]) && parseObjFloat(p, end, position[2]);
+            position += 3;
+            break;
+        case ObjRecord::Normal:
+            parsed = parseObjFloat(p, end, normal[0]) && parseObjFloat(p, end, normal[1]) && parseObjFloat(p, end, normal[2]);
+            normal += 3;
+            break;
+        case ObjRecord::Texcoord:
+            texcoord[1] = 0.0f; // The v coordinate is optional
+            parsed = parseObjFloat(p, end, texcoord[0]) && (skipSpaces(p, end) == end || parseObjFloat(p, end, texcoord[1]));
+            texcoord += 2;
+            break;
+        default: break;
+        }
+        if (!parsed)
+            setError(chunk, line, "malformed record \"" + std::string(start, end) + "\"");
+    });
+}
+
+// Split a polygon with more than four corners into count - 2 triangles by ear clipping
+// in the plane it faces most, falling back to a fan when no ear can be found
+void clipEars(const MeshIndex* corners, uint32_t count, const float* positions, MeshIndex* out) {
+    // Newell normal picks the projection axis
+    float normal[3] = {0.0f, 0.0f, 0.0f};
+    for (uint32_t i = 0; i < count; ++i) {
+        const float* a = &positions[3 * std::size_t(corners[i].vertex)];
+        const float* b = &positions[3 * std::size_t(corners[(i + 1) % count].vertex)];
+        normal[0] += (a[1] - b[1]) * (a[2] + b[2]);
+        normal[1] += (a[2] - b[2]) * (a[0] + b[0]);
+        normal[2] += (a[0] - b[0]) * (a[1] + b[1]);
+    }
+    int dropAxis = 0;
+    if (std::fabs(normal[1]) > std::fabs(normal[dropAxis]))
+        dropAxis = 1;
+    if (std::fabs(normal[2]) > std::fabs(normal[dropAxis]))
+        dropAxis = 2;
+    int axisU = (dropAxis + 1) % 3;
+    int axisV = (dropAxis + 2) % 3;
+
+    std::vector<float> u(count), v(count);
+    float area = 0.0f;
+    for (uint32_t i = 0; i < count; ++i) {
+        u[i] = positions[3 * std::size_t(corners[i].vertex) + axisU];
+        v[i] = positions[3 * std::size_t(corners[i].vertex) + axisV];
+    }
+    for (uint32_t i = 0; i < count; ++i) {
+        uint32_t j = (i + 1) % count;
+        area += u[i] * v[j] - u[j] * v[i];
+    }
+    float winding = area >= 0.0f ? 1.0f : -1.0f;
+    auto cross = [&](uint32_t a, uint32_t b, uint32_t c) {
+        return ((u[b] - u[a]) * (v[c] - v[a]) - (v[b] - v[a]) * (u[c] - u[a])) * winding;
+    };
+
+    std::vector<uint32_t> remaining(count);
+    for (uint32_t i = 0; i < count; ++i)
+        remaining[i] = i;
+
+    std::size_t written = 0;
+    while (remaining.size() > 3) {
+        bool clipped = false;
+        for (std::size_t i = 0; i < remaining.size() && !clipped; ++i) {
+            uint32_t a = remaining[(i + remaining.size() - 1) % remaining.size()];
+            uint32_t b = remaining[i];
+            uint32_t c = remaining[(i + 1) % remaining.size()];
+            if (cross(a, b, c) <= 0.0f) // Reflex corner, not an ear
+                continue;
+            bool empty = true;
+            for (uint32_t other : remaining) {
+                if (other == a || other == b || other == c)
+                    continue;
+                if (cross(a, b, other) >= 0.0f && cross(b, c, other) >= 0.0f && cross(c, a, other) >= 0.0f) {
+                    empty = false;
+                    break;
+                }
+            }
+            if (!empty)
+                continue;
+            out[written++] = corners[a];
+            out[written++] = corners[b];
+            out[written++] = corners[c];
+            remaining.erase(remaining.begin() + static_cast<std::ptrdiff_t>(i));
+            clipped = true;
+        }
+        if (!clipped)
+            break; // Degenerate or self-intersecting polygon
+    }
+    for (std::size_t i = 1; i + 1 < remaining.size(); ++i) { // Fan whatever is left
+        out[written++] = corners[remaining[0]];
+        out[written++] = corners[remaining[i]];
+        out[written++] = corners[remaining[i + 1]];
+    }
+}
+
+// Third pass: parse, resolve and triangulate the faces of a chunk straight into its slice
+// of the index and material arrays. Runs after every position is in place, since quads
+// and larger polygons look at their corner positions to pick a split.
+void parseFaces(Chunk& chunk, const ObjRecordCounts& totals, Mesh& mesh) {
+    ObjRecordCounts seen = {chunk.positionBase, chunk.normalBase, chunk.texcoordBase};
+    std::size_t triangle = chunk.triangleBase;
+    int32_t material = chunk.inheritedMaterial;
+    int32_t materialSlot = -1;
+    std::vector<MeshIndex> corners;        // Reused for every face of the chunk
+    std::size_t line = 0;
+    forEachLine(chunk, line, [&](const char* p, const char* end) {
+        switch (classifyObjLine(p, end)) {
+        case ObjRecord::Position: ++seen.positions; break;
+        case ObjRecord::Normal: ++seen.normals; break;
+        case ObjRecord::Texcoord: ++seen.texcoords; break;
+        case ObjRecord::Material: material = chunk.materialIds[++materialSlot]; break;
+        case ObjRecord::Face:
+            if (!parseObjFace(p, end, seen, totals, corners)) {
+                setError(chunk, line, "malformed face or face index out of range");
+            } else if (corners.size() >= 3 && chunk.error.empty()) {
+                uint32_t count = static_cast<uint32_t>(corners.size());
+                uint32_t written = triangulateFace(corners.data(), count, mesh.positions.data(), &mesh.indices[3 * triangle]);
+                std::fill_n(mesh.materialIds.begin() + static_cast<std::ptrdiff_t>(triangle), written, material);
+                triangle += written;
+            }
+            break;
+        default: break;
+        }
+    });
+}
+
+// Split [data, data + size) into count slices that each end just after a newline
+std::vector<Chunk> splitChunks(const char* data, std::size_t size, std::size_t count) {
+    std::vector<Chunk> chunks;
+    const char* begin = data;
+    const char* end = data + size;
+    for (std::size_t i = 1; i <= count && begin < end; ++i) {
+        const char* split = i == count ? end : data + size * i / count;
+        if (split < begin)
+            split = begin;
+        if (split < end) {
+            const char* newline = static_cast<const char*>(std::memchr(split, '\n', static_cast<std::size_t>(end - split)));
+            split = newline != nullptr ? newline + 1 : end;
+        }
+        if (split == begin)
+            continue;
+        Chunk chunk;
+        chunk.begin = begin;
+        chunk.end = split;
+        chunks.push_back(std::move(chunk));
+        begin = split;
+    }
+    return chunks;
+}
+
+// Report the first error in file order, returns false if there was one
+bool checkErrors(const std::vector<Chunk>& chunks, const std::string& path, std::string& message) {
+    for (const Chunk& chunk : chunks) {
+        if (!chunk.error.empty()) {
+            message += path + ":" + std::to_string(chunk.firstLine + chunk.errorLine + 1) + ": " + chunk.error + "\n";
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+uint32_t triangulateFace(const MeshIndex* corners, uint32_t count, const float* positions, MeshIndex* out) {
+    if (count == 3) {
+        out[0] = corners[0];
+        out[1] = corners[1];
+        out[2] = corners[2];
+    } else if (count == 4) {
+        // Split along the shorter diagonal, as tinyobj does for quads
+        auto distance2 = [&](const MeshIndex& a, const MeshIndex& b) {
+            const float* p = &positions[3 * std::size_t(a.vertex)];
+            const float* q = &positions[3 * std::size_t(b.vertex)];
+            return (p[0] - q[0]) * (p[0] - q[0]) + (p[1] - q[1]) * (p[1] - q[1]) + (p[2] - q[2]) * (p[2] - q[2]);
+        };
+        if (distance2(corners[0], corners[2]) < distance2(corners[1], corners[3])) {
+            const MeshIndex triangles[6] = {corners[0], corners[1], corners[2], corners[0], corners[2], corners[3]};
+            std::memcpy(out, triangles, sizeof(triangles));
+        } else {
+            const MeshIndex triangles[6] = {corners[0], corners[1], corners[3], corners[1], corners[2], corners[3]};
+            std::memcpy(out, triangles, sizeof(triangles));
+        }
+    } else {
+        clipEars(corners, count, positions, out);
+    }
+    return count - 2;
+}
+
+bool parseObjParallel(const std::string& path, ThreadPool& pool, Mesh& mesh, std::string& message) {
+    MappedFile file;
+    if (!file.open(path)) {
+        message += "Cannot open file [" + path + "]\n";
+        return false;
+    }
+
+    // A few chunks per thread keeps the cores busy when some slices are heavier than others.
+    // Each pass hands its pages back once a chunk is done, so the file never has to be
+    // resident all at once; later passes fault them back in from the page cache.
+    std::vector<Chunk> chunks = splitChunks(file.data(), file.size(), std::size_t(pool.size()) * 4);
+    auto releaseChunk = [&](const Chunk& chunk) {
+        file.release(static_cast<std::size_t>(chunk.begin - file.data()), static_cast<std::size_t>(chunk.end - chunk.begin));
+    };
+    pool.parallelFor(chunks.size(), [&](std::size_t i) {
+        countChunk(chunks[i]);
+        releaseChunk(chunks[i]);
+    });
+
+    // Prefix sums give every chunk its global record and triangle offsets
+    ObjRecordCounts totals;
+    std::size_t triangleCount = 0, lineCount = 0;
+    for (Chunk& chunk : chunks) {
+        chunk.positionBase = totals.positions;
+        chunk.normalBase = totals.normals;
+        chunk.texcoordBase = totals.texcoords;
+        chunk.triangleBase = triangleCount;
+        chunk.firstLine = lineCount;
+        totals.positions += chunk.positionCount;
+        totals.normals += chunk.normalCount;
+        totals.texcoords += chunk.texcoordCount;
+        triangleCount += chunk.triangleCount;
+        lineCount += chunk.lineCount;
+    }
+
+    // Materials and shapes carry over chunk boundaries, so they are stitched together in file order.
+    // A usemtl name gets the number of its newmtl in the mtllib files read before it, -1 when none
+    // defines it (or none could be read), as in tinyobj.
+    Mesh result;
+    std::unordered_map<std::string, int32_t> materialIds;
+    int32_t materialCount = 0;
+    int32_t currentMaterial = -1;
+    result.shapes.push_back({"", 0, 0}); // Faces before the first "o" go into an unnamed shape
+    for (Chunk& chunk : chunks) {
+        chunk.inheritedMaterial = currentMaterial;
+        std::size_t library = 0;
+        for (std::size_t slot = 0; slot <= chunk.materialNames.size(); ++slot) {
+            for (; library < chunk.materialLibraries.size() && chunk.materialLibraries[library].materialSlot == slot; ++library)
+                readMaterialLibrary(chunk.materialLibraries[library].fileNames, materialIds, materialCount);
+            if (slot == chunk.materialNames.size())
+                break;
+            auto found = materialIds.find(chunk.materialNames[slot]);
+            chunk.materialIds.push_back(found != materialIds.end() ? found->second : -1);
+        }
+        if (chunk.lastMaterialSlot >= 0)
+            currentMaterial = chunk.materialIds[chunk.lastMaterialSlot];
+
+        for (const ShapeStart& start : chunk.shapeStarts) {
+            uint32_t firstIndex = static_cast<uint32_t>(3 * (chunk.triangleBase + start.firstTriangle));
+            result.shapes.back().indexCount = firstIndex - result.shapes.back().firstIndex;
+            result.shapes.push_back({start.name, firstIndex, 0});
+        }
+    }
+    result.shapes.back().indexCount = static_cast<uint32_t>(3 * triangleCount) - result.shapes.back().firstIndex;
+    std::vector<MeshShape> shapes;
+    for (MeshShape& shape : result.shapes) { // Objects without faces do not become shapes, as in tinyobj
+        if (shape.indexCount > 0)
+            shapes.push_back(std::move(shape));
+    }
+    result.shapes = std::move(shapes);
+
+    // The destination is allocated exactly once; the parsing passes only fill it in
+    result.positions.resize(3 * totals.positions);
+    result.normals.resize(3 * totals.normals);
+    result.texcoords.resize(2 * totals.texcoords);
+    result.indices.resize(3 * triangleCount);
+    result.materialIds.resize(triangleCount);
+
+    pool.parallelFor(chunks.size(), [&](std::size_t i) {
+        parseAttributes(chunks[i], result);
+        releaseChunk(chunks[i]);
+    });
+    if (!checkErrors(chunks, path, message))
+        return false;
+
+    pool.parallelFor(chunks.size(), [&](std::size_t i) {
+        parseFaces(chunks[i], totals, result);
+        releaseChunk(chunks[i]);
+    });
+    if (!checkErrors(chunks, path, message))
+        return false;
+
+    mesh = std::move(result);
+    return true;
+}
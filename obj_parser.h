@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstdint>                         // Fixed-width integer types
+#include <string>                          // For file paths and error messages
+#include "mesh.h"                          // Destination layout, same as the tinyobj path
+
+class ThreadPool;
+
+// Parse an OBJ file on every thread of pool, straight out of a memory mapping and into the
+// final Mesh arrays. The file is split at line boundaries; a first pass counts the records of
+// every chunk, prefix sums place each chunk in arrays that are allocated once, and two more
+// passes parse the v/vn/vt records and then the faces into place, resolving negative relative
+// indices on the spot. Faces are triangulated the way tinyobj does it: quads along the shorter
+// diagonal, larger polygons by ear clipping. As in tinyobj, a usemtl name gets the position of
+// its newmtl in the mtllib files read before it, or -1 when no file defines it. Pages of the
+// mapping are released as each pass finishes a chunk.
+bool parseObjParallel(const std::string& path, ThreadPool& pool, Mesh& mesh, std::string& message);
+
+// Write the triangles of one face with count corners to out and return how many there are
+// (count - 2). positions is the x, y, z array the corners' vertex indices point into.
+uint32_t triangulateFace(const MeshIndex* corners, uint32_t count, const float* positions, MeshIndex* out);
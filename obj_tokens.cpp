@@ -0,0 +1,259 @@
+#include "obj_tokens.h"
+
+#include <cfloat>                          // For FLT_EVAL_METHOD
+#include <cstdlib>                         // For std::strtod()
+#include <cstring>                         // For std::memchr()/std::memcmp()/std::memcpy()
+#include <string>                          // Fallback buffer for very long tokens
+#if defined(__SSE2__)
+#include <emmintrin.h>                     // SSE2 byte compares for countTokens()
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>                      // NEON byte compares for countTokens()
+#endif
+
+namespace {
+
+// Powers of ten that are exact in a double
+const double exactPowersOfTen[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+// Parse [begin, end) with strtod, the reference every fast path has to agree with
+bool parseWithStrtod(const char* begin, const char* end, float& value) {
+    std::size_t length = static_cast<std::size_t>(end - begin);
+    char buffer[64];
+    std::string longToken;
+    char* text = buffer;
+    if (length < sizeof(buffer)) {
+        std::memcpy(buffer, begin, length);
+        buffer[length] = '\0';
+    } else {
+        longToken.assign(begin, end);
+        text = &longToken[0];
+    }
+    char* stop = nullptr;
+    double parsed = std::strtod(text, &stop); // Parse as double and narrow, like tinyobj
+    if (stop != text + length)
+        return false;
+    value = static_cast<float>(parsed);
+    return true;
+}
+
+// Clinger's fast path: a decimal with at most 19 significant digits whose mantissa fits in
+// 53 bits, scaled by at most 10^22, is one correctly rounded multiply or divide of two exact
+// doubles. That is the same double strtod returns, so narrowing it gives the same float.
+// Returns false when the token is not such a decimal.
+bool parseDecimalFast(const char* p, const char* end, float& value) {
+#if !defined(FLT_EVAL_METHOD) || FLT_EVAL_METHOD != 0
+    (void)p; (void)end; (void)value;
+    return false; // Extended precision intermediates would round twice
+#else
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+'))
+        negative = *p++ == '-';
+
+    uint64_t mantissa = 0;
+    int digits = 0;                        // Significant digits in mantissa
+    int exponent = 0;                      // Power of ten applied to mantissa
+    bool anyDigits = false;
+    for (; p < end && *p >= '0' && *p <= '9'; ++p) {
+        anyDigits = true;
+        if (mantissa == 0 && *p == '0')
+            continue; // Leading zeros are not significant
+        if (++digits > 19)
+            return false;
+        mantissa = mantissa * 10 + static_cast<uint64_t>(*p - '0');
+    }
+    if (p < end && *p == '.') {
+        for (++p; p < end && *p >= '0' && *p <= '9'; ++p) {
+            anyDigits = true;
+            --exponent;
+            if (mantissa == 0 && *p == '0')
+                continue;
+            if (++digits > 19)
+                return false;
+            mantissa = mantissa * 10 + static_cast<uint64_t>(*p - '0');
+        }
+    }
+    if (!anyDigits)
+        return false;
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        ++p;
+        bool negativeExponent = false;
+        if (p < end && (*p == '-' || *p == '+'))
+            negativeExponent = *p++ == '-';
+        if (p >= end || *p < '0' || *p > '9')
+            return false;
+        int written = 0;
+        for (; p < end && *p >= '0' && *p <= '9'; ++p) {
+            if (written < 10000) // Anything this large takes the strtod path below anyway
+                written = written * 10 + (*p - '0');
+        }
+        exponent += negativeExponent ? -written : written;
+    }
+    if (p != end)
+        return false;
+
+    double result;
+    if (mantissa == 0)
+        result = 0.0;
+    else if (mantissa > (uint64_t(1) << 53) || exponent < -22 || exponent > 22)
+        return false;
+    else if (exponent < 0)
+        result = static_cast<double>(mantissa) / exactPowersOfTen[-exponent];
+    else
+        result = static_cast<double>(mantissa) * exactPowersOfTen[exponent];
+    value = static_cast<float>(negative ? -result : result);
+    return true;
+#endif
+}
+
+// Turn a 1-based OBJ index into a 0-based one. Negative indices count back from the
+// records seen before the face.
+bool resolveIndex(int32_t raw, std::size_t seen, std::size_t total, int32_t& index) {
+    if (raw == 0) // OBJ indices start at 1
+        return false;
+    int64_t resolved = raw > 0 ? int64_t(raw) - 1 : int64_t(seen) + raw;
+    if (resolved < 0 || static_cast<std::size_t>(resolved) >= total)
+        return false;
+    index = static_cast<int32_t>(resolved);
+    return true;
+}
+
+} // namespace
+
+ObjRecord classifyObjLine(const char*& p, const char* end) {
+    while (p < end && isObjSpace(*p))
+        ++p;
+    std::size_t length = static_cast<std::size_t>(end - p);
+    ObjRecord record = ObjRecord::Other;
+    std::size_t keyword = 1;
+    if (length == 0) {
+        return ObjRecord::Other;
+    } else if ((p[0] == 'o' || p[0] == 'g') && (length == 1 || isObjSpace(p[1]))) {
+        record = ObjRecord::Shape;
+    } else if (length < 2) {
+        return ObjRecord::Other;
+    } else if (p[0] == 'v' && isObjSpace(p[1])) {
+        record = ObjRecord::Position;
+    } else if (p[0] == 'v' && length > 2 && p[1] == 'n' && isObjSpace(p[2])) {
+        record = ObjRecord::Normal;
+        keyword = 2;
+    } else if (p[0] == 'v' && length > 2 && p[1] == 't' && isObjSpace(p[2])) {
+        record = ObjRecord::Texcoord;
+        keyword = 2;
+    } else if (p[0] == 'f' && isObjSpace(p[1])) {
+        record = ObjRecord::Face;
+    } else if (length > 6 && std::memcmp(p, "usemtl", 6) == 0 && isObjSpace(p[6])) {
+        record = ObjRecord::Material;
+        keyword = 6;
+    } else if (length > 6 && std::memcmp(p, "mtllib", 6) == 0 && isObjSpace(p[6])) {
+        record = ObjRecord::MaterialLibrary;
+        keyword = 6;
+    }
+    // Comments, smoothing groups and other records are ignored like in tinyobj
+    if (record != ObjRecord::Other)
+        p += keyword;
+    return record;
+}
+
+const char* findLineEnd(const char* p, const char* end) {
+    // libc's memchr is already vectorized and beats a hand-written loop for long lines
+    const char* newline = static_cast<const char*>(std::memchr(p, '\n', static_cast<std::size_t>(end - p)));
+    return newline != nullptr ? newline : end;
+}
+
+uint32_t countTokens(const char* p, const char* end) {
+    uint32_t count = 0;
+    uint32_t previousSolid = 0;            // 1 when the byte before p belongs to a token
+#if defined(__SSE2__)
+    const __m128i space = _mm_set1_epi8(' ');
+    const __m128i tab = _mm_set1_epi8('\t');
+    const __m128i carriageReturn = _mm_set1_epi8('\r');
+    for (; end - p >= 16; p += 16) {
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        __m128i blank = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(bytes, space), _mm_cmpeq_epi8(bytes, tab)),
+                                     _mm_cmpeq_epi8(bytes, carriageReturn));
+        uint32_t solid = ~static_cast<uint32_t>(_mm_movemask_epi8(blank)) & 0xFFFFu;
+        uint32_t starts = solid & ~((solid << 1) | previousSolid); // Solid bytes after a blank one
+        count += static_cast<uint32_t>(__builtin_popcount(starts));
+        previousSolid = solid >> 15;
+    }
+#elif defined(__ARM_NEON)
+    const uint8x16_t space = vdupq_n_u8(' ');
+    const uint8x16_t tab = vdupq_n_u8('\t');
+    const uint8x16_t carriageReturn = vdupq_n_u8('\r');
+    for (; end - p >= 16; p += 16) {
+        uint8x16_t bytes = vld1q_u8(reinterpret_cast<const uint8_t*>(p));
+        uint8x16_t blank = vorrq_u8(vorrq_u8(vceqq_u8(bytes, space), vceqq_u8(bytes, tab)), vceqq_u8(bytes, carriageReturn));
+        // Narrowing shift packs the byte mask into 4 bits per byte
+        uint64_t solid = ~vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(blank), 4)), 0);
+        uint64_t starts = solid & ~((solid << 4) | (previousSolid ? 0xFu : 0u));
+        count += static_cast<uint32_t>(__builtin_popcountll(starts)) / 4;
+        previousSolid = static_cast<uint32_t>(solid >> 63);
+    }
+#endif
+    for (; p < end; ++p) {
+        uint32_t solid = isObjSpace(*p) ? 0 : 1;
+        count += solid & ~previousSolid;
+        previousSolid = solid;
+    }
+    return count;
+}
+
+bool parseObjFloat(const char*& p, const char* end, float& value) {
+    while (p < end && isObjSpace(*p))
+        ++p;
+    const char* begin = p;
+    while (p < end && !isObjSpace(*p))
+        ++p;
+    if (p == begin)
+        return false;
+    return parseDecimalFast(begin, p, value) || parseWithStrtod(begin, p, value);
+}
+
+bool parseObjInt(const char*& p, const char* end, int32_t& value) {
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+'))
+        negative = *p++ == '-';
+    if (p >= end || *p < '0' || *p > '9')
+        return false;
+    int64_t result = 0;
+    while (p < end && *p >= '0' && *p <= '9') {
+        result = result * 10 + (*p++ - '0');
+        if (result > INT32_MAX)
+            return false;
+    }
+    value = static_cast<int32_t>(negative ? -result : result);
+    return true;
+}
+
+bool parseObjFace(const char* p, const char* end, const ObjRecordCounts& seen, const ObjRecordCounts& totals,
+                  std::vector<MeshIndex>& corners) {
+    corners.clear();
+    for (;;) {
+        while (p < end && isObjSpace(*p))
+            ++p;
+        if (p >= end)
+            return true;
+
+        MeshIndex corner = {-1, -1, -1};
+        int32_t raw = 0;
+        if (!parseObjInt(p, end, raw) || !resolveIndex(raw, seen.positions, totals.positions, corner.vertex))
+            return false;
+        if (p < end && *p == '/') {
+            ++p;
+            if (p < end && *p != '/') { // v/t or v/t/n
+                if (!parseObjInt(p, end, raw) || !resolveIndex(raw, seen.texcoords, totals.texcoords, corner.texcoord))
+                    return false;
+            }
+            if (p < end && *p == '/') { // v//n or v/t/n
+                ++p;
+                if (!parseObjInt(p, end, raw) || !resolveIndex(raw, seen.normals, totals.normals, corner.normal))
+                    return false;
+            }
+        }
+        if (p < end && !isObjSpace(*p))
+            return false;
+        corners.push_back(corner);
+    }
+}
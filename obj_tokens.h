@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>                         // For std::size_t
+#include <cstdint>                         // Fixed-width integer types
+#include <vector>                          // For the corners of a face
+#include "mesh.h"                          // For MeshIndex
+
+// Scanning and number kernels for the OBJ grammar, shared by the parsers and a3_bench.
+// None of them need null-terminated input, they work straight on the mapped file.
+
+// Kind of an OBJ line, as far as the parsers care
+enum class ObjRecord { Other, Position, Normal, Texcoord, Face, Shape, Material, MaterialLibrary };
+
+// Position, normal and texcoord record counts: the records seen before a face, or a file's totals
+struct ObjRecordCounts {
+    std::size_t positions = 0;
+    std::size_t normals = 0;
+    std::size_t texcoords = 0;
+};
+
+// Spaces, tabs and carriage returns separate tokens; newlines end records
+inline bool isObjSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+// End of the line starting at p: the newline, or end if there is none
+const char* findLineEnd(const char* p, const char* end);
+
+// Number of whitespace-separated tokens in [p, end), 16 bytes at a time where SSE2 or NEON is available
+uint32_t countTokens(const char* p, const char* end);
+
+// Skip leading spaces and parse one float token. The result is bit-identical to
+// (float)strtod() on the token: plain decimals take an exact fast path, anything else
+// (long mantissas, large exponents, inf, nan, hex floats) falls back to strtod().
+bool parseObjFloat(const char*& p, const char* end, float& value);
+
+// Parse an optionally signed decimal integer that fits in 32 bits
+bool parseObjInt(const char*& p, const char* end, int32_t& value);
+
+// Classify the line [p, end) and move p past its keyword
+ObjRecord classifyObjLine(const char*& p, const char* end);
+
+// Parse the corners of an "f" record into corners as 0-based indices; p points just past the "f".
+// Negative indices count back from seen; every index has to be below totals. Returns false on a
+// malformed corner or an index out of range.
+bool parseObjFace(const char* p, const char* end, const ObjRecordCounts& seen, const ObjRecordCounts& totals,
+                  std::vector<MeshIndex>& corners);
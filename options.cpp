@@ -0,0 +1,227 @@
+#include "options.h"
+
+#include <cstdlib>                         // For std::strtoul()/std::strtof()
+#include <iostream>                        // Standard input/output stream library
+#include "geometry.h"                      // For maxLodLevels
+
+namespace {
+
+void printUsage(const char* program) {
+    std::cerr << "Usage: " << program << " [options] [model.obj ...]\n"
+              << "  --scene <file>         load the models listed in a scene manifest\n"
+              << "  --repeat <n>           draw n copies of every model on a grid\n"
+              << "  --frames <n>           close after n frames and print the mean frame time\n"
+              << "  --sim-rate <hz>        simulation ticks per second; the camera moves at the same speed at any frame rate (default 60)\n"
+              << "  --fps <n>              draw at most n frames per second, 0 for no cap (default); scripted runs step 1/n s per frame\n"
+              << "  --no-vsync             swap buffers without waiting for the display\n"
+              << "  --render-thread        draw on a dedicated thread while this one polls input and runs the simulation (OpenGL, not offline)\n"
+              << "  --update-load <ms>     keep the CPU busy for ms per simulation tick, to measure frame times under a heavy update\n"
+              << "  --no-cache             always parse the OBJ text, never read or write the binary mesh cache\n"
+              << "  --parser <name>        OBJ parser: parallel (default) or tinyobj\n"
+              << "  --threads <n>          threads for the parallel parser, 0 for all cores (default)\n"
+              << "  --upload-budget <kib>  geometry uploaded to the GPU per frame while loading (default 4096)\n"
+              << "  --no-watch             do not hot reload model files when they change on disk\n"
+              << "  --pick                 click on the model to print the object and point under the cursor\n"
+              << "  --no-cull              draw every shape even when it is outside the view\n"
+              << "  --lods <n>             simplified levels of detail built per shape, 0 to draw full detail only (default 3)\n"
+              << "  --lod-threshold <px>   largest on-screen simplification error of a drawn level (default 1)\n"
+              << "  --no-optimize          keep the OBJ's triangle and vertex order instead of optimising it for the GPU caches\n"
+              << "  --no-meshlets          cull whole shapes only, without splitting them into clusters\n"
+              << "  --cull-backfaces       skip back faces, and clusters facing away from the camera\n"
+              << "  --no-mdi               draw shape by shape even when multi-draw indirect is supported\n"
+              << "  --no-persistent-map    stream per-frame data by orphaning buffers even when buffer storage is supported\n"
+              << "  --vertex-format <name> vertex layout in GPU memory: float (32 bytes, default) or compact (16 bytes)\n"
+              << "  --stream               page models larger than memory through disk and a fixed GPU pool\n"
+              << "  --stream-budget <mib>  host memory used while paging a model (default 256)\n"
+              << "  --page-pool <mib>      GPU memory for resident pages in streaming mode (default 256)\n"
+              << "  --headless             render offscreen without a display, on the CPU when there is no GPU\n"
+              << "  --script <file>        move the camera from a script of \"<keys> <ticks>\" lines instead of the keyboard\n"
+              << "  --record <file>        write the keys held every tick to file as a script that --script replays exactly\n"
+              << "  --output <dir>         write every frame to dir/frame_NNNNN.png (or .ppm)\n"
+              << "  --image-format <name>  format of the written frames: png (default) or ppm\n"
+              << "  --compare <dir>        compare every frame with dir/frame_NNNNN.ppm and fail on any difference\n"
+              << "  --renderer <name>      draw with gl (default) or software, the multithreaded CPU rasteriser\n"
+              << "  --fill                 software renderer: draw shaded, depth-tested triangles instead of the wireframe\n"
+              << "  --render-threads <n>   threads for the software renderer, 0 for all cores (default)\n";
+}
+
+// Parse a non-negative decimal number, false if text is not one
+bool readUnsigned(const char* text, unsigned& value) {
+    char* end = nullptr;
+    unsigned long parsed = std::strtoul(text, &end, 10);
+    if (end == text || *end != '\0' || text[0] == '-')
+        return false;
+    value = static_cast<unsigned>(parsed);
+    return true;
+}
+
+// Parse a non-negative decimal number with an optional fraction, false if text is not one
+bool readFloat(const char* text, float& value) {
+    char* end = nullptr;
+    float parsed = std::strtof(text, &end);
+    if (end == text || *end != '\0' || !(parsed >= 0.0f))
+        return false;
+    value = parsed;
+    return true;
+}
+
+} // namespace
+
+bool parseOptions(int argc, char* argv[], Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--no-cache") {
+            options.load.useCache = false;
+        } else if (arg == "--parser" && i + 1 < argc) {
+            std::string name = argv[++i];
+            if (name == "tinyobj") {
+                options.load.parser = ObjParser::Tinyobj;
+            } else if (name == "parallel") {
+                options.load.parser = ObjParser::Parallel;
+            } else {
+                printUsage(argv[0]);
+                return false;
+            }
+        } else if (arg == "--threads" && i + 1 < argc) {
+            if (!readUnsigned(argv[++i], options.load.threads)) {
+                printUsage(argv[0]);
+                return false;
+            }
+        } else if (arg == "--upload-budget" && i + 1 < argc) {
+            unsigned kib = 0;
+            if (!readUnsigned(argv[++i], kib) || kib == 0) {
+                printUsage(argv[0]);
+                return false;
+            }
+            options.uploadBudgetBytes = std::size_t(kib) << 10;
+        } else if (arg == "--scene" && i + 1 < argc) {
+            options.sceneFile = argv[++i];
+        } else if (arg == "--repeat" && i + 1 < argc) {
+            if (!readUnsigned(argv[++i], options.repeat) || options.repeat == 0) {
+                printUsage(argv[0]);
+                return false;
+            }
+        } else if (arg == "--frames" && i + 1 < argc) {
+            if (!readUnsigned(argv[++i], options.frameLimit)) {
+                printUsage(argv[0]);
+                return false;
+            }
+        } else if (arg == "--sim-rate" && i + 1 < argc) {
+            if (!readUnsigned(argv[++i], options.simulationRate) || options.simulationRate == 0) {
+                printUsage(argv[0]);
+                return false;
+            }
+        } else if (arg == "--fps" && i + 1 < argc) {
+            if (!readUnsigned(argv[++i], options.frameRate)) {
+                printUsage(argv[0]);
+                return false;
+            }
+        } else if (arg == "--no-vsync") {
+            options.vsync = false;
+        } else if (arg == "--render-thread") {
+            options.renderThread = true;
+        } else if (arg == "--update-load" && i + 1 < argc) {
+            if (!readFloat(argv[++i], options.updateLoadMillis) || options.updateLoadMillis < 0.0f) {
+                printUsage(argv[0]);
+                return false;
+            }
+        } else if (arg == "--no-watch") {
+            options.watchFiles = false;
+        } else if (arg == "--pick") {
+            options.pick = true;
+        } else if (arg == "--no-cull") {
+            options.cull = false;
+        } else if (arg == "--lods" && i + 1 < argc) {
+            if (!readUnsigned(argv[++i], options.load.lodLevels) || options.load.lodLevels > maxLodLevels) {
+                printUsage(argv[0]);
+                return false;
+            }
+        } else if (arg == "--lod-threshold" && i + 1 < argc) {
+            if (!readFloat(argv[++i], options.lodThresholdPixels)) {
+                printUsage(argv[0]);
+                return false;
+            }
+        } else if (arg == "--no-optimize") {
+            options.load.optimize = false;
+        } else if (arg == "--no-meshlets") {
+            options.load.meshlets = false;
+        } else if (arg == "--cull-backfaces") {
+            options.cullBackfaces = true;
+        } else if (arg == "--no-mdi") {
+            options.multiDraw = false;
+        } else if (arg == "--no-persistent-map") {
+            options.persistentMapping = false;
+        } else if (arg == "--vertex-format" && i + 1 < argc) {
+            if (!parseVertexFormat(argv[++i], options.vertexFormat)) {
+                printUsage(argv[0]);
+                return false;
+            }
+        } else if (arg == "--stream") {
+            options.stream = true;
+        } else if (arg == "--stream-budget" && i + 1 < argc) {
+            unsigned mib = 0;
+            if (!readUnsigned(argv[++i], mib) || mib == 0) {
+                printUsage(argv[0]);
+                return false;
+            }
+            options.streamBudgetBytes = std::size_t(mib) << 20;
+        } else if (arg == "--page-pool" && i + 1 < argc) {
+            unsigned mib = 0;
+            if (!readUnsigned(argv[++i], mib) || mib == 0) {
+                printUsage(argv[0]);
+                return false;
+            }
+            options.pagePoolBytes = std::size_t(mib) << 20;
+        } else if (arg == "--headless") {
+            options.headless = true;
+        } else if (arg == "--script" && i + 1 < argc) {
+            options.scriptFile = argv[++i];
+        } else if (arg == "--record" && i + 1 < argc) {
+            options.recordFile = argv[++i];
+        } else if (arg == "--output" && i + 1 < argc) {
+            options.outputDir = argv[++i];
+        } else if (arg == "--image-format" && i + 1 < argc) {
+            options.imageFormat = argv[++i];
+            if (options.imageFormat != "png" && options.imageFormat != "ppm") {
+                printUsage(argv[0]);
+                return false;
+            }
+        } else if (arg == "--compare" && i + 1 < argc) {
+            options.compareDir = argv[++i];
+        } else if (arg == "--renderer" && i + 1 < argc) {
+            std::string name = argv[++i];
+            if (name == "gl") {
+                options.renderer = Renderer::OpenGL;
+            } else if (name == "software") {
+                options.renderer = Renderer::Software;
+            } else {
+                printUsage(argv[0]);
+                return false;
+            }
+        } else if (arg == "--fill") {
+            options.fill = true;
+        } else if (arg == "--render-threads" && i + 1 < argc) {
+            if (!readUnsigned(argv[++i], options.renderThreads)) {
+                printUsage(argv[0]);
+                return false;
+            }
+        } else if (!arg.empty() && arg[0] != '-') {
+            options.modelFiles.push_back(arg);
+        } else {
+            printUsage(argv[0]);
+            return false;
+        }
+    }
+    return true;
+}
+
+bool buildScene(const Options& options, Scene& scene) {
+    if (!options.sceneFile.empty() && !loadSceneManifest(options.sceneFile, scene))
+        return false;
+    for (const std::string& path : options.modelFiles)
+        addModelInstance(scene, path, glm::mat4(1.0f));
+    if (scene.instances.empty())
+        addModelInstance(scene, "../contingo.obj", glm::mat4(1.0f)); // Path to the .obj file
+    repeatInstances(scene, options.repeat);
+    return true;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>                         // For std::size_t
+#include <string>                          // For file paths
+#include <vector>                          // For using the std::vector container
+#include "obj_loader.h"                    // For LoadSettings
+#include "scene_manifest.h"                // For building the Scene
+#include "vertex_format.h"                 // For VertexFormat
+
+// What draws the frames
+enum class Renderer {
+    OpenGL,                                // The GL 3.3 pipeline
+    Software                               // The tiled CPU rasteriser, see software_renderer.h
+};
+
+// Settings chosen on the command line
+struct Options {
+    std::vector<std::string> modelFiles;   // OBJ files given on the command line
+    std::string sceneFile;                 // Scene manifest, see scene_manifest.h
+    unsigned repeat = 1;                   // Copies of every instance, laid out on a grid
+    unsigned frameLimit = 0;               // Close the window after this many frames, 0 to run until closed
+    unsigned simulationRate = 60;          // Fixed-timestep ticks per second that move the transform
+    unsigned frameRate = 0;                // Most frames drawn per second, 0 for no cap
+    bool vsync = true;                     // Wait for the display's refresh when swapping buffers
+    bool renderThread = false;             // Draw on a thread of its own, fed scene snapshots by the update thread
+    float updateLoadMillis = 0.0f;         // Busy time added to every simulation tick, to stand in for a heavy update
+    LoadSettings load;                     // Cache, parser and thread count for the OBJ load
+    std::size_t uploadBudgetBytes = 4u << 20; // Most geometry bytes copied to the GPU per frame
+    bool watchFiles = true;                // Hot reload model files when they are rewritten
+    bool pick = false;                     // Build BVHs and report the surface point under left clicks
+    bool cull = true;                      // Skip shapes outside the view frustum
+    bool cullBackfaces = false;            // Skip back faces and meshlets facing away (the wireframe shows them otherwise)
+    float lodThresholdPixels = 1.0f;       // Largest projected simplification error, in pixels, of a drawn level of detail
+    bool multiDraw = true;                 // Submit the draw table with glMultiDrawElementsIndirect when supported
+    bool persistentMapping = true;         // Stream per-frame data through persistently mapped buffers when supported
+    VertexFormat vertexFormat = VertexFormat::Float; // Layout of the vertices in the VBO (streaming always uses Float)
+    bool stream = false;                   // Page models through disk and a fixed GPU pool instead of loading them whole
+    std::size_t streamBudgetBytes = 256u << 20; // Host memory used while paging a model
+    std::size_t pagePoolBytes = 256u << 20;     // GPU memory of the page pool
+    bool headless = false;                 // Render into an offscreen framebuffer without a display
+    std::string scriptFile;                // Camera script replacing the keyboard, see camera_script.h
+    std::string recordFile;                // Write the keys of every frame to this file as a camera script
+    std::string outputDir;                 // Write every frame to this directory as frame_NNNNN.<imageFormat>
+    std::string imageFormat = "png";       // png or ppm
+    std::string compareDir;                // Compare every frame with the frame_NNNNN.ppm images in this directory
+    Renderer renderer = Renderer::OpenGL;
+    bool fill = false;                     // Software renderer: filled, depth-tested triangles instead of the wireframe
+    unsigned renderThreads = 0;            // Software renderer threads, 0 for all cores
+};
+
+// Parse argv into options, prints usage and returns false on an unknown argument
+bool parseOptions(int argc, char* argv[], Options& options);
+
+// Build the scene from the manifest and the model files of options, "../contingo.obj" when neither is given
+bool buildScene(const Options& options, Scene& scene);
@@ -0,0 +1,424 @@
+#include "page_file.h"
+
+#include <algorithm>                       // For std::min()/std::max()
+#include <chrono>                          // For timing the paging
+#include <cstdio>                          // For std::remove()
+#include <cstring>                         // For std::memcpy()
+#include <fcntl.h>                         // For open()
+#include <filesystem>                      // For the temporary directory
+#include <iostream>                        // Standard input/output stream library
+#include <unistd.h>                        // For pread()/pwrite()/close()/getpid()
+#include <unordered_map>                   // Index triple -> page vertex lookup
+#include "mapped_file.h"                   // The OBJ and the attribute spill files are read through mmap
+#include "obj_parser.h"                    // For triangulateFace()
+#include "obj_tokens.h"                    // Line and number kernels
+
+namespace {
+
+// Fresh path in the temporary directory for one of this process's spill files
+std::string temporaryPath(const std::string& stem) {
+    static std::atomic<unsigned> counter{0};
+    std::string name = "a3_" + stem + "_" + std::to_string(getpid()) + "_" + std::to_string(counter++);
+    return (std::filesystem::temp_directory_path() / name).string();
+}
+
+bool writeAt(int fd, const void* data, std::size_t size, uint64_t offset) {
+    const char* bytes = static_cast<const char*>(data);
+    while (size > 0) {
+        ssize_t written = pwrite(fd, bytes, size, static_cast<off_t>(offset));
+        if (written <= 0)
+            return false;
+        bytes += written;
+        size -= static_cast<std::size_t>(written);
+        offset += static_cast<uint64_t>(written);
+    }
+    return true;
+}
+
+bool readAt(int fd, void* data, std::size_t size, uint64_t offset) {
+    char* bytes = static_cast<char*>(data);
+    while (size > 0) {
+        ssize_t read = pread(fd, bytes, size, static_cast<off_t>(offset));
+        if (read <= 0)
+            return false;
+        bytes += read;
+        size -= static_cast<std::size_t>(read);
+        offset += static_cast<uint64_t>(read);
+    }
+    return true;
+}
+
+// Temporary file of floats appended through a bounded buffer and mapped once complete
+class SpillFile {
+public:
+    ~SpillFile() {
+        mapping_.close();
+        if (fd_ >= 0)
+            ::close(fd_);
+        if (!path_.empty())
+            std::remove(path_.c_str());
+    }
+
+    bool create(const std::string& stem, std::size_t bufferBytes) {
+        path_ = temporaryPath(stem);
+        fd_ = ::open(path_.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+        bufferFloats_ = std::max<std::size_t>(bufferBytes / sizeof(float), 1024);
+        buffer_.reserve(bufferFloats_);
+        return fd_ >= 0;
+    }
+
+    bool push(const float* values, std::size_t count) {
+        buffer_.insert(buffer_.end(), values, values + count);
+        return buffer_.size() < bufferFloats_ || flush();
+    }
+
+    // Flush the buffer and map the file; a file without records maps to nullptr
+    bool map() {
+        if (!flush())
+            return false;
+        ::close(fd_);
+        fd_ = -1;
+        return written_ == 0 || mapping_.open(path_);
+    }
+
+    const float* data() const { return reinterpret_cast<const float*>(mapping_.data()); }
+    // Drop the resident pages of the mapping; they are faulted back in on the next access
+    void release() const { mapping_.release(0, mapping_.size()); }
+
+private:
+    bool flush() {
+        std::size_t bytes = buffer_.size() * sizeof(float);
+        if (bytes > 0 && !writeAt(fd_, buffer_.data(), bytes, written_))
+            return false;
+        written_ += bytes;
+        buffer_.clear();
+        return true;
+    }
+
+    int fd_ = -1;
+    std::string path_;
+    std::vector<float> buffer_;
+    std::size_t bufferFloats_ = 0;         // Flush once the buffer holds this many floats
+    uint64_t written_ = 0;                 // Bytes in the file
+    MappedFile mapping_;
+};
+
+// Call fn(p, lineEnd, line) for every line of file, releasing the mapping behind the parser
+// every windowBytes. Stops early when fn returns false.
+template <typename Fn>
+bool forEachWindowedLine(const MappedFile& file, std::size_t windowBytes, Fn&& fn) {
+    const char* p = file.data();
+    const char* end = p + file.size();
+    const char* window = p;
+    for (std::size_t line = 0; p < end; ++line) {
+        const char* lineEnd = findLineEnd(p, end);
+        if (!fn(p, lineEnd, line))
+            return false;
+        p = lineEnd + 1;
+        if (static_cast<std::size_t>(p - window) >= windowBytes) {
+            file.release(static_cast<std::size_t>(window - file.data()), static_cast<std::size_t>(p - window));
+            window = p;
+        }
+    }
+    file.release(static_cast<std::size_t>(window - file.data()), static_cast<std::size_t>(end - window));
+    return true;
+}
+
+// Rest of the line with surrounding whitespace removed
+std::string restOfLine(const char* p, const char* end) {
+    while (p < end && isObjSpace(*p))
+        ++p;
+    while (end > p && isObjSpace(end[-1]))
+        --end;
+    return std::string(p, end);
+}
+
+// Collects triangles into a page until the next one would not fit, then appends it to the page file
+class PageBuilder {
+public:
+    PageBuilder(PageFile& pages, const SpillFile& positions, const SpillFile& normals, const SpillFile& texcoords)
+        : pages_(pages), positions_(positions), normals_(normals), texcoords_(texcoords) {
+        vertices_.reserve(pageMaxVertices);
+        indices_.reserve(3 * std::size_t(pageMaxTriangles));
+        lookup_.reserve(pageMaxVertices);
+        reset();
+    }
+
+    bool addTriangle(uint32_t shape, const MeshIndex* corners) {
+        if (shape != shape_ && !flush())
+            return false;
+        shape_ = shape;
+        uint32_t missing = 0;
+        for (int i = 0; i < 3; ++i)
+            missing += lookup_.count(corners[i]) == 0 ? 1 : 0;
+        if (vertices_.size() + missing > pageMaxVertices || indices_.size() + 3 > 3 * std::size_t(pageMaxTriangles)) {
+            if (!flush())
+                return false;
+        }
+        for (int i = 0; i < 3; ++i) {
+            auto inserted = lookup_.emplace(corners[i], static_cast<uint16_t>(vertices_.size()));
+            if (inserted.second)
+                vertices_.push_back(makeVertex(corners[i]));
+            indices_.push_back(inserted.first->second);
+        }
+        return true;
+    }
+
+    bool flush() {
+        if (indices_.empty())
+            return true;
+        bool appended = pages_.append(shape_, vertices_, indices_, boundsMin_, boundsMax_);
+        reset();
+        // Every page touches a different part of the attribute files, so drop what this one pulled in
+        positions_.release();
+        normals_.release();
+        texcoords_.release();
+        return appended;
+    }
+
+private:
+    Vertex makeVertex(const MeshIndex& index) {
+        Vertex vertex = {};
+        std::memcpy(vertex.position, positions_.data() + 3 * std::size_t(index.vertex), sizeof(vertex.position));
+        if (index.normal >= 0)
+            std::memcpy(vertex.normal, normals_.data() + 3 * std::size_t(index.normal), sizeof(vertex.normal));
+        if (index.texcoord >= 0)
+            std::memcpy(vertex.texcoord, texcoords_.data() + 2 * std::size_t(index.texcoord), sizeof(vertex.texcoord));
+        for (int axis = 0; axis < 3; ++axis) {
+            boundsMin_[axis] = std::min(boundsMin_[axis], vertex.position[axis]);
+            boundsMax_[axis] = std::max(boundsMax_[axis], vertex.position[axis]);
+        }
+        return vertex;
+    }
+
+    void reset() {
+        vertices_.clear();
+        indices_.clear();
+        lookup_.clear();
+        for (int axis = 0; axis < 3; ++axis) {
+            boundsMin_[axis] = 3.4e38f;
+            boundsMax_[axis] = -3.4e38f;
+        }
+    }
+
+    PageFile& pages_;
+    const SpillFile& positions_;
+    const SpillFile& normals_;
+    const SpillFile& texcoords_;
+    uint32_t shape_ = 0;
+    std::vector<Vertex> vertices_;
+    std::vector<uint16_t> indices_;
+    std::unordered_map<MeshIndex, uint16_t, MeshIndexHash, MeshIndexEqual> lookup_;
+    float boundsMin_[3];
+    float boundsMax_[3];
+};
+
+} // namespace
+
+PageFile::~PageFile() {
+    if (fd_ >= 0)
+        ::close(fd_);
+    if (!path_.empty())
+        std::remove(path_.c_str());
+}
+
+bool PageFile::create(uint32_t meshId) {
+    meshId_ = meshId;
+    path_ = temporaryPath("pages");
+    fd_ = ::open(path_.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+    return fd_ >= 0;
+}
+
+bool PageFile::append(uint32_t shape, const std::vector<Vertex>& vertices, const std::vector<uint16_t>& indices,
+                      const float boundsMin[3], const float boundsMax[3]) {
+    PageInfo page = {meshId_, shape, end_, static_cast<uint32_t>(vertices.size()), static_cast<uint32_t>(indices.size()),
+                     {boundsMin[0], boundsMin[1], boundsMin[2]}, {boundsMax[0], boundsMax[1], boundsMax[2]}};
+    std::size_t vertexBytes = vertices.size() * sizeof(Vertex);
+    std::size_t indexBytes = indices.size() * sizeof(uint16_t);
+    if (!writeAt(fd_, vertices.data(), vertexBytes, end_) || !writeAt(fd_, indices.data(), indexBytes, end_ + vertexBytes))
+        return false;
+    end_ += vertexBytes + indexBytes;
+
+    // The bytes are in the file before the page becomes visible to readers
+    std::lock_guard<std::mutex> lock(mutex_);
+    pages_.push_back(page);
+    return true;
+}
+
+uint32_t PageFile::addShape(const std::string& name) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    shapeNames_.push_back(name);
+    return static_cast<uint32_t>(shapeNames_.size() - 1);
+}
+
+std::size_t PageFile::pageCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return pages_.size();
+}
+
+PageInfo PageFile::page(std::size_t i) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return pages_[i];
+}
+
+std::vector<std::string> PageFile::shapeNames() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return shapeNames_;
+}
+
+bool PageFile::readPage(const PageInfo& page, std::vector<Vertex>& vertices, std::vector<uint16_t>& indices) const {
+    vertices.resize(page.vertexCount);
+    indices.resize(page.indexCount);
+    std::size_t vertexBytes = vertices.size() * sizeof(Vertex);
+    return readAt(fd_, vertices.data(), vertexBytes, page.offset) &&
+           readAt(fd_, indices.data(), indices.size() * sizeof(uint16_t), page.offset + vertexBytes);
+}
+
+bool buildPageFile(const std::string& objPath, std::size_t budgetBytes, PageFile& pages, std::string& message) {
+    auto fail = [&](const std::string& error) {
+        message += error + "\n";
+        pages.failed = true;
+        return false;
+    };
+
+    MappedFile file;
+    if (!file.open(objPath))
+        return fail("Cannot open file [" + objPath + "]");
+    std::size_t windowBytes = std::max<std::size_t>(budgetBytes / 4, std::size_t(1) << 20);
+    std::size_t spillBytes = std::max<std::size_t>(budgetBytes / 16, std::size_t(64) << 10);
+
+    // First pass: spill the attribute records to disk so faces can look them up by index
+    SpillFile positions, normals, texcoords;
+    if (!positions.create("positions", spillBytes) || !normals.create("normals", spillBytes) ||
+        !texcoords.create("texcoords", spillBytes))
+        return fail("Cannot create temporary files for " + objPath);
+    ObjRecordCounts totals;
+    std::string error;
+    bool parsed = forEachWindowedLine(file, windowBytes, [&](const char* p, const char* end, std::size_t line) {
+        if (pages.cancelled) {
+            error = "cancelled";
+            return false;
+        }
+        const char* start = p;
+        float values[3] = {0.0f, 0.0f, 0.0f};
+        bool ok = true;
+        switch (classifyObjLine(p, end)) {
+        case ObjRecord::Position:
+            ok = parseObjFloat(p, end, values[0]) && parseObjFloat(p, end, values[1]) && parseObjFloat(p, end, values[2]) &&
+                 positions.push(values, 3);
+            ++totals.positions;
+            break;
+        case ObjRecord::Normal:
+            ok = parseObjFloat(p, end, values[0]) && parseObjFloat(p, end, values[1]) && parseObjFloat(p, end, values[2]) &&
+                 normals.push(values, 3);
+            ++totals.normals;
+            break;
+        case ObjRecord::Texcoord:
+            ok = parseObjFloat(p, end, values[0]);
+            while (ok && p < end && isObjSpace(*p))
+                ++p;
+            ok = ok && (p == end || parseObjFloat(p, end, values[1])) && texcoords.push(values, 2); // v is optional
+            ++totals.texcoords;
+            break;
+        default: break;
+        }
+        if (!ok)
+            error = objPath + ":" + std::to_string(line + 1) + ": malformed record \"" + std::string(start, end) + "\"";
+        return ok;
+    });
+    if (!parsed)
+        return fail(error);
+    if (!positions.map() || !normals.map() || !texcoords.map())
+        return fail("Cannot write temporary files for " + objPath);
+
+    // Second pass: triangulate the faces and pack them into pages, one shape at a time
+    PageBuilder builder(pages, positions, normals, texcoords);
+    ObjRecordCounts seen;
+    uint32_t shape = 0;
+    bool hasShape = false;
+    std::vector<MeshIndex> corners;
+    std::vector<MeshIndex> triangles;
+    parsed = forEachWindowedLine(file, windowBytes, [&](const char* p, const char* end, std::size_t line) {
+        if (pages.cancelled) {
+            error = "cancelled";
+            return false;
+        }
+        switch (classifyObjLine(p, end)) {
+        case ObjRecord::Position: ++seen.positions; break;
+        case ObjRecord::Normal: ++seen.normals; break;
+        case ObjRecord::Texcoord: ++seen.texcoords; break;
+        case ObjRecord::Shape:
+            shape = pages.addShape(restOfLine(p, end));
+            hasShape = true;
+            break;
+        case ObjRecord::Face: {
+            if (!parseObjFace(p, end, seen, totals, corners)) {
+                error = objPath + ":" + std::to_string(line + 1) + ": malformed face or face index out of range";
+                return false;
+            }
+            if (corners.size() < 3) // Points and lines are not part of the triangle mesh
+                break;
+            if (!hasShape) { // Faces before the first "o" go into an unnamed shape
+                shape = pages.addShape("");
+                hasShape = true;
+            }
+            triangles.resize(3 * (corners.size() - 2));
+            uint32_t count = triangulateFace(corners.data(), static_cast<uint32_t>(corners.size()), positions.data(), triangles.data());
+            for (uint32_t i = 0; i < count; ++i) {
+                if (!builder.addTriangle(shape, &triangles[3 * std::size_t(i)])) {
+                    error = "Cannot write the page file for " + objPath;
+                    return false;
+                }
+            }
+            break;
+        }
+        default: break;
+        }
+        return true;
+    });
+    if (!parsed || !builder.flush())
+        return fail(error.empty() ? "Cannot write the page file for " + objPath : error);
+    pages.finished = true;
+    return true;
+}
+
+ModelPager::~ModelPager() {
+    for (auto& file : files_)
+        file->cancelled = true;
+    if (worker_.joinable())
+        worker_.join();
+}
+
+void ModelPager::start(const std::vector<std::string>& paths, std::size_t budgetBytes) {
+    for (std::size_t i = 0; i < paths.size(); ++i)
+        files_.push_back(std::unique_ptr<PageFile>(new PageFile()));
+    worker_ = std::thread(&ModelPager::run, this, paths, budgetBytes);
+}
+
+void ModelPager::run(std::vector<std::string> paths, std::size_t budgetBytes) {
+    auto start = std::chrono::steady_clock::now();
+    uint64_t bytes = 0;
+    std::size_t pageCount = 0;
+    for (std::size_t i = 0; i < paths.size(); ++i) {
+        PageFile& pages = *files_[i];
+        std::string message;
+        if (!pages.create(static_cast<uint32_t>(i))) {
+            std::cerr << "Cannot create a page file for " << paths[i] << std::endl;
+            pages.failed = true;
+        } else if (!buildPageFile(paths[i], budgetBytes, pages, message)) {
+            if (!pages.cancelled)
+                std::cerr << paths[i] << ": " << message << std::endl;
+        }
+        if (pages.failed || pages.cancelled) {
+            failed_ = !pages.cancelled;
+            finished_ = true;
+            return;
+        }
+        bytes += pages.bytes();
+        pageCount += pages.pageCount();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "Paged " << paths.size() << " model file(s) into " << pageCount << " pages ("
+              << bytes / (1024.0 * 1024.0) << " MiB) in " << seconds << " s" << std::endl;
+    finished_ = true;
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <atomic>                          // Build progress flags read by the render thread
+#include <cstddef>                         // For std::size_t
+#include <cstdint>                         // Fixed-width integer types
+#include <memory>                          // For std::unique_ptr
+#include <mutex>                           // Guards the page directory while it grows
+#include <string>                          // For file paths and shape names
+#include <thread>                          // Background paging thread
+#include <vector>                          // For using the std::vector container
+#include "geometry.h"                      // Vertex layout stored in the pages
+
+// Largest page: 16-bit indices and a fixed size so every page fits any slot of the GPU page pool
+const uint32_t pageMaxVertices = 32768;
+const uint32_t pageMaxTriangles = 65536;
+
+// Directory entry of one compacted page: part of one shape, its own vertices and 16-bit indices
+struct PageInfo {
+    uint32_t meshId;                       // Model file the page belongs to (Scene::modelFiles)
+    uint32_t shape;                        // Index into PageFile::shapeNames()
+    uint64_t offset;                       // Byte offset in the page file: vertices, then indices
+    uint32_t vertexCount;
+    uint32_t indexCount;                   // Three per triangle
+    float boundsMin[3];                    // Object-space bounding box of the page's vertices
+    float boundsMax[3];
+};
+
+// Temporary binary file of compacted pages, written by buildPageFile() on one thread while
+// the render thread reads the pages published so far. The file is deleted on destruction.
+class PageFile {
+public:
+    PageFile() = default;
+    ~PageFile();
+    PageFile(const PageFile&) = delete;
+    PageFile& operator=(const PageFile&) = delete;
+
+    // Create an empty page file in the temporary directory
+    bool create(uint32_t meshId);
+
+    // Append a page and publish it to readers
+    bool append(uint32_t shape, const std::vector<Vertex>& vertices, const std::vector<uint16_t>& indices,
+                const float boundsMin[3], const float boundsMax[3]);
+    // Add a shape name, returns its index
+    uint32_t addShape(const std::string& name);
+
+    // Pages published so far; safe to call while the file is being built
+    std::size_t pageCount() const;
+    PageInfo page(std::size_t i) const;
+    // Read a published page back; vertices and indices are resized to fit
+    bool readPage(const PageInfo& page, std::vector<Vertex>& vertices, std::vector<uint16_t>& indices) const;
+
+    uint32_t meshId() const { return meshId_; }
+    std::vector<std::string> shapeNames() const;
+    uint64_t bytes() const { return end_; }
+
+    // Set by buildPageFile() once the whole OBJ has been paged, or once it failed
+    std::atomic<bool> finished{false};
+    std::atomic<bool> failed{false};
+    // Set by the owner to make buildPageFile() stop early
+    std::atomic<bool> cancelled{false};
+
+private:
+    int fd_ = -1;
+    std::string path_;
+    uint32_t meshId_ = 0;
+    uint64_t end_ = 0;                     // Bytes written so far
+    mutable std::mutex mutex_;
+    std::vector<PageInfo> pages_;
+    std::vector<std::string> shapeNames_;
+};
+
+// Stream the OBJ at objPath into pages without ever holding the mesh in memory. The file is
+// read in windows of about budgetBytes / 4 whose pages are released behind the parser: a first
+// pass spills v/vn/vt records to temporary attribute files, a second pass triangulates the faces
+// and packs them, deduplicated, into pages of at most pageMaxVertices vertices. Host memory
+// stays around budgetBytes whatever the size of the model. Sets pages.finished or pages.failed.
+bool buildPageFile(const std::string& objPath, std::size_t budgetBytes, PageFile& pages, std::string& message);
+
+// Pages model files one after another on a background thread, like AssetLoader does for whole meshes.
+// One file at a time keeps host memory within a single budget.
+class ModelPager {
+public:
+    ModelPager() = default;
+    ~ModelPager();
+    ModelPager(const ModelPager&) = delete;
+    ModelPager& operator=(const ModelPager&) = delete;
+
+    // Start paging paths; the pages of paths[i] carry meshId i
+    void start(const std::vector<std::string>& paths, std::size_t budgetBytes);
+
+    // One page file per path, filling up while the pager runs
+    const std::vector<std::unique_ptr<PageFile>>& files() const { return files_; }
+    // True once every file has been paged (or failed)
+    bool finished() const { return finished_; }
+    // True if any OBJ could not be paged
+    bool failed() const { return failed_; }
+
+private:
+    void run(std::vector<std::string> paths, std::size_t budgetBytes);
+
+    std::thread worker_;
+    std::vector<std::unique_ptr<PageFile>> files_; // Created by start(), never resized afterwards
+    std::atomic<bool> finished_{false};
+    std::atomic<bool> failed_{false};
+};
@@ -0,0 +1,179 @@
+#include "page_pool.h"
+
+#include <algorithm>                       // For std::max()/std::sort()
+#include <cstddef>                         // For offsetof
+#include <cstdint>                         // For uintptr_t
+#include "draw_table.h"                    // For setConstantModel()
+
+namespace {
+
+const std::size_t slotVertexBytes = std::size_t(pageMaxVertices) * sizeof(Vertex);
+const std::size_t slotIndexBytes = 3 * std::size_t(pageMaxTriangles) * sizeof(uint16_t);
+
+} // namespace
+
+void PagePool::create(std::size_t poolBytes) {
+    std::size_t slotCount = std::max<std::size_t>(poolBytes / (slotVertexBytes + slotIndexBytes), 1);
+    slots_.assign(slotCount, Slot());
+    residentSlot_.clear();
+    pageBounds_.clear();
+    frame_ = pagesLoaded_ = pagesEvicted_ = 0;
+
+    glGenVertexArrays(1, &vao_);           // Generate VAO to store vertex attribute configuration
+    glGenBuffers(1, &vbo_);                // Generate VBO holding every slot's vertices
+    glGenBuffers(1, &ebo_);                // Generate EBO holding every slot's indices
+
+    glBindVertexArray(vao_);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo_);
+    glBufferData(GL_ARRAY_BUFFER, slotCount * slotVertexBytes, nullptr, GL_DYNAMIC_DRAW); // Allocated once, never grown
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo_); // The element binding is stored in the VAO
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, slotCount * slotIndexBytes, nullptr, GL_DYNAMIC_DRAW);
+
+    // Same vertex layout as SceneBuffers
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, position)); // Position
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, normal)); // Normal
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, texcoord)); // Texture coordinate
+    glEnableVertexAttribArray(2);
+
+    // Unbind the VAO first so it keeps its element buffer, then the VBO
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void PagePool::destroy() {
+    glDeleteVertexArrays(1, &vao_);       // Delete the VAO
+    glDeleteBuffers(1, &vbo_);            // Delete the VBO
+    glDeleteBuffers(1, &ebo_);            // Delete the EBO
+    vao_ = vbo_ = ebo_ = 0;
+    slots_.clear();
+    residentSlot_.clear();
+    pageBounds_.clear();
+}
+
+std::size_t PagePool::update(const std::vector<std::unique_ptr<PageFile>>& files, const std::vector<ModelInstance>& instances,
+                             const glm::mat4& transform, std::size_t budgetBytes) {
+    ++frame_;
+    if (residentSlot_.size() < files.size()) {
+        residentSlot_.resize(files.size());
+        pageBounds_.resize(files.size());
+    }
+    for (std::size_t f = 0; f < files.size(); ++f) {
+        std::size_t pageCount = files[f]->pageCount();
+        residentSlot_[f].resize(pageCount, -1);
+        for (std::size_t p = pageBounds_[f].size(); p < pageCount; ++p) {
+            PageInfo page = files[f]->page(p);
+            pageBounds_[f].push_back(boxBounds(page.boundsMin, page.boundsMax));
+        }
+    }
+
+    // Pages some instance shows inside the view: resident ones are marked so none of them is evicted
+    // below, missing ones are queued by how much of the screen they may cover
+    wanted_.clear();
+    for (const ModelInstance& instance : instances) {
+        glm::mat4 clipFromObject = transform * instance.model;
+        Frustum frustum = extractFrustum(clipFromObject);
+        float scale = 0.0f; // Largest stretch of the instance's axes, as DrawTable::selectLods() measures it
+        for (int column = 0; column < 3; ++column)
+            scale = std::max(scale, glm::length(glm::vec3(clipFromObject[column])));
+        for (std::size_t f = 0; f < files.size(); ++f) {
+            if (files[f]->meshId() != instance.meshId)
+                continue;
+            for (std::size_t p = 0; p < pageBounds_[f].size(); ++p) {
+                const Bounds& bounds = pageBounds_[f][p];
+                if (!boundsVisible(frustum, bounds))
+                    continue;
+                int32_t slot = residentSlot_[f][p];
+                if (slot >= 0)
+                    slots_[slot].lastFrame = frame_;
+                else
+                    wanted_.push_back({bounds.radius * scale, static_cast<uint32_t>(f), static_cast<uint32_t>(p)});
+            }
+        }
+    }
+    // Largest first; a page shown by several instances is queued once per instance and uploaded once
+    std::sort(wanted_.begin(), wanted_.end(), [](const WantedPage& a, const WantedPage& b) { return a.size > b.size; });
+
+    std::size_t uploaded = 0;
+    for (std::size_t w = 0; w < wanted_.size() && uploaded < budgetBytes; ++w) {
+        std::size_t f = wanted_[w].file, p = wanted_[w].page;
+        if (residentSlot_[f][p] >= 0)
+            continue;
+
+        // A free slot, or else the one seen longest ago, as long as it is not in view this frame
+        int32_t victim = -1;
+        for (std::size_t s = 0; s < slots_.size(); ++s) {
+            if (!slots_[s].used) {
+                victim = static_cast<int32_t>(s);
+                break;
+            }
+            if (slots_[s].lastFrame < frame_ && (victim < 0 || slots_[s].lastFrame < slots_[victim].lastFrame))
+                victim = static_cast<int32_t>(s);
+        }
+        if (victim < 0)
+            return uploaded; // Pool full of pages in view
+
+        PageInfo page = files[f]->page(p);
+        if (!files[f]->readPage(page, vertices_, indices_))
+            continue;
+        Slot& slot = slots_[victim];
+        if (slot.used) {
+            residentSlot_[slot.file][slot.page] = -1;
+            ++pagesEvicted_;
+        }
+        glBindBuffer(GL_COPY_WRITE_BUFFER, vbo_); // Avoid touching whatever VAO is bound
+        glBufferSubData(GL_COPY_WRITE_BUFFER, victim * slotVertexBytes, vertices_.size() * sizeof(Vertex), vertices_.data());
+        glBindBuffer(GL_COPY_WRITE_BUFFER, ebo_);
+        glBufferSubData(GL_COPY_WRITE_BUFFER, victim * slotIndexBytes, indices_.size() * sizeof(uint16_t), indices_.data());
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+        slot.used = true;
+        slot.file = static_cast<uint32_t>(f);
+        slot.page = static_cast<uint32_t>(p);
+        slot.meshId = page.meshId;
+        slot.indexCount = page.indexCount;
+        slot.bounds = pageBounds_[f][p];
+        slot.lastFrame = frame_;
+        residentSlot_[f][p] = victim;
+        uploaded += vertices_.size() * sizeof(Vertex) + indices_.size() * sizeof(uint16_t);
+        ++pagesLoaded_;
+    }
+    return uploaded;
+}
+
+CullStats PagePool::draw(const std::vector<ModelInstance>& instances, const glm::mat4& transform, bool cull) const {
+    CullStats stats;
+    glBindVertexArray(vao_); // Bind the VAO
+    for (const ModelInstance& instance : instances) {
+        setConstantModel(instance.model); // Place this instance
+        Frustum frustum = extractFrustum(transform * instance.model);
+        for (std::size_t s = 0; s < slots_.size(); ++s) {
+            const Slot& slot = slots_[s];
+            if (!slot.used || slot.meshId != instance.meshId)
+                continue;
+            ++stats.objects;
+            stats.triangles += slot.indexCount / 3;
+            if (cull && !boundsVisible(frustum, slot.bounds)) {
+                ++stats.objectsCulled;
+                stats.trianglesCulled += slot.indexCount / 3;
+                continue;
+            }
+            glDrawElementsBaseVertex(GL_TRIANGLES, slot.indexCount, GL_UNSIGNED_SHORT,
+                                     (void*)(uintptr_t)(s * slotIndexBytes), static_cast<GLint>(s * pageMaxVertices)); // Draw the page's triangles
+        }
+    }
+    glBindVertexArray(0); // Unbind the VAO
+    return stats;
+}
+
+bool PagePool::pageResident(std::size_t f, std::size_t p) const {
+    return f < residentSlot_.size() && p < residentSlot_[f].size() && residentSlot_[f][p] >= 0;
+}
+
+std::size_t PagePool::residentPages() const {
+    std::size_t resident = 0;
+    for (const Slot& slot : slots_)
+        resident += slot.used ? 1 : 0;
+    return resident;
+}
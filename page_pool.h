@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstddef>                         // For std::size_t
+#include <cstdint>                         // Fixed-width integer types
+#include <memory>                          // For std::unique_ptr
+#include <vector>                          // For using the std::vector container
+#include <GL/glew.h>                       // GLEW library for managing OpenGL extensions
+#include "frustum.h"                       // For culling pages against the view
+#include "page_file.h"                     // Pages to stream in
+#include "scene_manifest.h"                // Instances to draw
+
+// Fixed-size pool of GPU page slots in one VBO/EBO pair. Every frame the pages inside the view are
+// made resident from their page files under a byte budget, largest on screen first, evicting the
+// pages seen longest ago when the pool is full, so GPU memory stays fixed whatever the size of the
+// models and a model larger than the pool shows whichever part of it is in view.
+class PagePool {
+public:
+    // Create the VAO and buffers for as many slots as fit in poolBytes (at least one); needs a current GL context
+    void create(std::size_t poolBytes);
+    // Delete every GL object
+    void destroy();
+
+    // Stream in the missing pages of files that some instance shows inside the view of transform, those
+    // covering the most of the screen first, until about budgetBytes were uploaded; returns the bytes
+    // uploaded. Resident pages are kept; a page is only evicted for one when it is not in view this frame.
+    std::size_t update(const std::vector<std::unique_ptr<PageFile>>& files, const std::vector<ModelInstance>& instances,
+                       const glm::mat4& transform, std::size_t budgetBytes);
+
+    // Draw every resident page of every instance, setting the model matrix attribute per instance.
+    // With cull, pages outside the view of transform are skipped.
+    CullStats draw(const std::vector<ModelInstance>& instances, const glm::mat4& transform, bool cull) const;
+
+    std::size_t slotCount() const { return slots_.size(); }
+    std::size_t residentPages() const;
+    // True when page p of the file at index f in the files passed to update() is in a slot
+    bool pageResident(std::size_t f, std::size_t p) const;
+    uint64_t pagesLoaded() const { return pagesLoaded_; }    // Uploads since create()
+    uint64_t pagesEvicted() const { return pagesEvicted_; }
+
+private:
+    // What one slot holds
+    struct Slot {
+        bool used = false;
+        uint32_t file = 0;                 // Index into the files passed to update()
+        uint32_t page = 0;                 // Page within that file
+        uint32_t meshId = 0;
+        uint32_t indexCount = 0;
+        Bounds bounds = {};                // Of the page's vertices
+        uint64_t lastFrame = 0;            // Last frame the page was in view
+    };
+
+    // Page in view that is not resident yet
+    struct WantedPage {
+        float size;                        // Projected radius of its bounds, in clip units
+        uint32_t file;
+        uint32_t page;
+    };
+
+    GLuint vao_ = 0;
+    GLuint vbo_ = 0;
+    GLuint ebo_ = 0;
+    std::vector<Slot> slots_;
+    std::vector<std::vector<int32_t>> residentSlot_; // Slot per page of every file, -1 when not resident
+    std::vector<std::vector<Bounds>> pageBounds_;    // Per page of every file, copied from its PageInfo once
+    std::vector<WantedPage> wanted_;       // This frame's, reused to avoid allocating
+    uint64_t frame_ = 0;
+    uint64_t pagesLoaded_ = 0;
+    uint64_t pagesEvicted_ = 0;
+    std::vector<Vertex> vertices_;         // Staging for the page being read
+    std::vector<uint16_t> indices_;
+};
@@ -0,0 +1,50 @@
+#include "picking.h"
+
+#include <algorithm>                       // For std::upper_bound()
+
+uint32_t PickableMesh::shapeOf(uint32_t triangle) const {
+    auto next = std::upper_bound(shapeFirstTriangle.begin(), shapeFirstTriangle.end(), triangle);
+    return next == shapeFirstTriangle.begin() ? 0 : static_cast<uint32_t>(next - shapeFirstTriangle.begin() - 1);
+}
+
+void buildPickableMesh(const Mesh& mesh, ThreadPool& pool, PickableMesh& pickable) {
+    std::vector<uint32_t> corners(mesh.indices.size());
+    for (std::size_t i = 0; i < corners.size(); ++i)
+        corners[i] = static_cast<uint32_t>(mesh.indices[i].vertex);
+    pickable.bvh.build(mesh.positions.data(), corners.data(), corners.size() / 3, pool);
+    pickable.shapeFirstTriangle.clear();
+    pickable.shapeNames.clear();
+    for (const MeshShape& shape : mesh.shapes) {
+        pickable.shapeFirstTriangle.push_back(shape.firstIndex / 3);
+        pickable.shapeNames.push_back(shape.name);
+    }
+}
+
+bool pickScene(const std::vector<ModelInstance>& instances, const std::vector<std::shared_ptr<const PickableMesh>>& meshes,
+               const glm::mat4& transform, float ndcX, float ndcY, PickResult& result) {
+    bool found = false;
+    float nearest = 2.0f; // Segment parameter of the best hit; the same for every instance since the maps are affine
+    for (uint32_t i = 0; i < instances.size(); ++i) {
+        const ModelInstance& instance = instances[i];
+        if (instance.meshId >= meshes.size() || !meshes[instance.meshId])
+            continue;
+        const PickableMesh& mesh = *meshes[instance.meshId];
+
+        // Bring the clip-space segment into the instance's object space instead of transforming its triangles
+        glm::mat4 objectFromClip = glm::inverse(transform * instance.model);
+        glm::vec4 from = objectFromClip * glm::vec4(ndcX, ndcY, -1.0f, 1.0f);
+        glm::vec4 to = objectFromClip * glm::vec4(ndcX, ndcY, 1.0f, 1.0f);
+        glm::vec3 start = glm::vec3(from) / from.w;
+        glm::vec3 end = glm::vec3(to) / to.w;
+
+        RayHit hit;
+        if (!mesh.bvh.intersectSegment(start, end, hit) || hit.t >= nearest)
+            continue;
+        nearest = hit.t;
+        glm::vec3 point = start + (end - start) * hit.t;
+        result = {i, instance.meshId, mesh.shapeOf(hit.triangle), hit.triangle, point,
+                  glm::vec3(instance.model * glm::vec4(point, 1.0f))};
+        found = true;
+    }
+    return found;
+}
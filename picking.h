@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdint>                         // Fixed-width integer types
+#include <memory>                          // For std::shared_ptr
+#include <string>                          // For shape names
+#include <vector>                          // For using the std::vector container
+#include <glm/glm.hpp>                     // GLM library for handling matrices and vectors
+#include "bvh.h"                           // Ray queries
+#include "mesh.h"                          // Source triangles
+#include "scene_manifest.h"                // Instances to pick from
+#include "thread_pool.h"                   // Threads for the BVH build
+
+// BVH of one model file plus what is needed to name the shape a triangle belongs to
+struct PickableMesh {
+    Bvh bvh;                               // Triangles numbered as in Mesh::indices
+    std::vector<uint32_t> shapeFirstTriangle; // Per shape, ascending
+    std::vector<std::string> shapeNames;
+
+    // Shape of a triangle, by binary search over shapeFirstTriangle
+    uint32_t shapeOf(uint32_t triangle) const;
+};
+
+// Build the BVH of mesh's positions
+void buildPickableMesh(const Mesh& mesh, ThreadPool& pool, PickableMesh& pickable);
+
+// The surface point under the cursor
+struct PickResult {
+    uint32_t instance;                     // Index into the scene's instances
+    uint32_t meshId;
+    uint32_t shape;                        // Index into the mesh's shapes
+    uint32_t triangle;                     // Index into the mesh's triangles
+    glm::vec3 objectPoint;                 // In the model file's coordinates
+    glm::vec3 scenePoint;                  // After the instance's model matrix
+};
+
+// Cast the view ray through (ndcX, ndcY), from the near to the far plane of the clip volume of
+// transform, against every instance whose mesh has a BVH and return the nearest hit. meshes is
+// indexed by meshId; null entries are not pickable yet.
+bool pickScene(const std::vector<ModelInstance>& instances, const std::vector<std::shared_ptr<const PickableMesh>>& meshes,
+               const glm::mat4& transform, float ndcX, float ndcY, PickResult& result);
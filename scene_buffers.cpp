@@ -0,0 +1,274 @@
+#include "scene_buffers.h"
+
+#include <algorithm>                       // For std::min()/std::max()
+#include <cstddef>                         // For offsetof
+#include <cstdint>                         // For uintptr_t
+
+void SceneBuffers::create(bool multiDraw, VertexFormat format, bool persistentStreaming) {
+    format_ = format;
+    vertexStride_ = vertexStride(format);
+    glGenVertexArrays(1, &vao_);           // Generate VAO to store vertex attribute configuration
+    glGenBuffers(1, &vbo_);                // Generate VBO to store vertex data in GPU memory
+    glGenBuffers(1, &ebo_);                // Generate EBO to store the indices in GPU memory
+    table_.create(multiDraw, format, persistentStreaming); // Generate the indirect and per-record matrix buffers
+    bindLayout();
+}
+
+void SceneBuffers::destroy() {
+    glDeleteVertexArrays(1, &vao_);       // Delete the VAO
+    glDeleteBuffers(1, &vbo_);            // Delete the VBO
+    glDeleteBuffers(1, &ebo_);            // Delete the EBO
+    vao_ = vbo_ = ebo_ = 0;
+    vertexCapacity_ = indexCapacity_ = vertexBytes_ = indexBytes_ = wastedBytes_ = 0;
+    meshShapes_.clear();
+    pending_ = false;
+    table_.destroy();
+    tableStale_ = true;
+    tableInstances_ = 0;
+}
+
+void SceneBuffers::bindLayout() {
+    glBindVertexArray(vao_);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo_);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo_); // The element binding is stored in the VAO
+
+    // Define vertex attributes
+    if (format_ == VertexFormat::Compact) {
+        GLsizei stride = sizeof(CompactVertex);
+        glVertexAttribPointer(0, 3, GL_UNSIGNED_SHORT, GL_TRUE, stride, (void*)offsetof(CompactVertex, position)); // 0..1 in the shape's bounds
+        glVertexAttribPointer(1, 2, GL_SHORT, GL_TRUE, stride, (void*)offsetof(CompactVertex, normal)); // Octahedral normal
+        glVertexAttribPointer(2, 2, GL_HALF_FLOAT, GL_FALSE, stride, (void*)offsetof(CompactVertex, texcoord)); // Texture coordinate
+    } else {
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, position)); // Position
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, normal)); // Normal
+        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, texcoord)); // Texture coordinate
+    }
+    glEnableVertexAttribArray(0);
+    glEnableVertexAttribArray(1);
+    glEnableVertexAttribArray(2);
+    table_.bindModelAttribute();           // Per-instance model matrix, when drawing indirectly
+
+    // Unbind the VAO first so it keeps its element buffer, then the VBO
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void SceneBuffers::reserve(GLuint& buffer, std::size_t& capacity, std::size_t used, std::size_t needed) {
+    if (needed <= capacity)
+        return;
+
+    // Double the capacity so a stream of chunks costs amortised constant copies
+    std::size_t newCapacity = std::max(needed, capacity * 2);
+    GLuint grown;
+    glGenBuffers(1, &grown);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, grown);
+    glBufferData(GL_COPY_WRITE_BUFFER, newCapacity, nullptr, GL_STATIC_DRAW);
+    if (used > 0) {
+        glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, used);
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    }
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    glDeleteBuffers(1, &buffer);
+    buffer = grown;
+    capacity = newCapacity;
+    bindLayout();
+}
+
+std::size_t SceneBuffers::upload(AssetLoader& loader, std::size_t budgetBytes) {
+    std::size_t uploaded = 0;
+    while (uploaded < budgetBytes) {
+        if (!pending_) {
+            if (!loader.tryPop(chunk_))
+                break;
+
+            // Claim space for the whole chunk up front; shapes are appended, 4-byte aligned in the EBO
+            if (format_ != VertexFormat::Float)
+                encodeGeometry(format_, chunk_, chunkVertices_);
+            vertexTarget_ = vertexBytes_;
+            indexTarget_ = (indexBytes_ + 3) & ~std::size_t(3);
+            vertexBytes_ = vertexTarget_ + chunk_.vertices.size() * vertexStride_;
+            indexBytes_ = indexTarget_ + chunk_.indexData.size();
+            reserve(vbo_, vertexCapacity_, vertexTarget_, vertexBytes_);
+            reserve(ebo_, indexCapacity_, indexTarget_, indexBytes_);
+            vertexDone_ = indexDone_ = 0;
+            pending_ = true;
+        }
+
+        std::size_t vertexTotal = chunk_.vertices.size() * vertexStride_;
+        std::size_t indexTotal = chunk_.indexData.size();
+        if (vertexDone_ < vertexTotal) {
+            std::size_t bytes = std::min(vertexTotal - vertexDone_, budgetBytes - uploaded);
+            const uint8_t* vertices = format_ == VertexFormat::Float ? reinterpret_cast<const uint8_t*>(chunk_.vertices.data())
+                                                                     : chunkVertices_.data();
+            glBindBuffer(GL_ARRAY_BUFFER, vbo_);
+            glBufferSubData(GL_ARRAY_BUFFER, vertexTarget_ + vertexDone_, bytes, vertices + vertexDone_);
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+            vertexDone_ += bytes;
+            uploaded += bytes;
+        } else if (indexDone_ < indexTotal) {
+            std::size_t bytes = std::min(indexTotal - indexDone_, budgetBytes - uploaded);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, ebo_); // Avoid touching whatever VAO is bound
+            glBufferSubData(GL_COPY_WRITE_BUFFER, indexTarget_ + indexDone_, bytes, chunk_.indexData.data() + indexDone_);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+            indexDone_ += bytes;
+            uploaded += bytes;
+        }
+
+        if (vertexDone_ == vertexTotal && indexDone_ == indexTotal) {
+            // The chunk is complete: rebase its shapes onto their place in the shared buffers
+            uint32_t baseVertex = static_cast<uint32_t>(vertexTarget_ / vertexStride_);
+            for (DrawShape shape : chunk_.shapes) {
+                shape.baseVertex += baseVertex;
+                shape.indexOffset += static_cast<uint32_t>(indexTarget_);
+                if (shape.meshId >= meshShapes_.size())
+                    meshShapes_.resize(shape.meshId + 1);
+                meshShapes_[shape.meshId].push_back(std::move(shape));
+            }
+            chunk_ = IndexedGeometry();
+            chunkVertices_.clear();
+            pending_ = false;
+            tableStale_ = true;
+        }
+    }
+    return uploaded;
+}
+
+void SceneBuffers::appendStorage(DrawShape& shape) {
+    std::size_t vertexTarget = vertexBytes_;
+    std::size_t indexTarget = (indexBytes_ + 3) & ~std::size_t(3);
+    std::size_t vertexEnd = vertexTarget + std::size_t(shape.vertexCount) * vertexStride_;
+    std::size_t indexEnd = indexTarget + shape.indexBytes();
+    reserve(vbo_, vertexCapacity_, vertexBytes_, vertexEnd); // Keeps any partially uploaded chunk
+    reserve(ebo_, indexCapacity_, indexBytes_, indexEnd);
+    vertexBytes_ = vertexEnd;
+    indexBytes_ = indexEnd;
+
+    shape.baseVertex = static_cast<uint32_t>(vertexTarget / vertexStride_);
+    shape.indexOffset = static_cast<uint32_t>(indexTarget);
+    shape.vertexCapacity = shape.vertexCount;
+    shape.indexCapacity = static_cast<uint32_t>(shape.indexBytes());
+}
+
+void SceneBuffers::writeShape(const DrawShape& shape, const Vertex* vertices, const uint8_t* indices) {
+    const void* data = vertices;
+    if (format_ != VertexFormat::Float) {
+        staging_.resize(std::size_t(shape.vertexCount) * vertexStride_);
+        encodeVertices(format_, vertices, shape.vertexCount, shape.bounds, staging_.data());
+        data = staging_.data();
+    }
+    glBindBuffer(GL_COPY_WRITE_BUFFER, vbo_);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, std::size_t(shape.baseVertex) * vertexStride_,
+                    std::size_t(shape.vertexCount) * vertexStride_, data);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, ebo_);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, shape.indexOffset, shape.indexBytes(), indices);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+void SceneBuffers::uploadNow(const IndexedGeometry& chunk) {
+    for (DrawShape shape : chunk.shapes) {
+        const Vertex* vertices = &chunk.vertices[shape.baseVertex];
+        const uint8_t* indices = chunk.indexData.data() + shape.indexOffset;
+        appendStorage(shape);
+        writeShape(shape, vertices, indices);
+        if (shape.meshId >= meshShapes_.size())
+            meshShapes_.resize(shape.meshId + 1);
+        meshShapes_[shape.meshId].push_back(std::move(shape));
+    }
+    tableStale_ = true;
+}
+
+ReloadStats SceneBuffers::applyReload(const ReloadBatch& batch) {
+    if (batch.meshId >= meshShapes_.size())
+        meshShapes_.resize(batch.meshId + 1);
+    std::vector<DrawShape>& resident = meshShapes_[batch.meshId];
+    std::vector<bool> matched(resident.size(), false);
+    std::vector<DrawShape> updated;
+
+    ReloadStats stats;
+    stats.shapes = static_cast<unsigned>(batch.geometry.shapes.size());
+    for (const DrawShape& incoming : batch.geometry.shapes) {
+        const Vertex* vertices = &batch.geometry.vertices[incoming.baseVertex];
+        const uint8_t* indices = batch.geometry.indexData.data() + incoming.indexOffset;
+        std::size_t bytes = std::size_t(incoming.vertexCount) * vertexStride_ + incoming.indexBytes();
+
+        // Match by name; duplicate names pair up in file order
+        std::size_t old = 0;
+        while (old < resident.size() && (matched[old] || resident[old].name != incoming.name))
+            ++old;
+
+        DrawShape shape = incoming;
+        if (old < resident.size()) {
+            matched[old] = true;
+            const DrawShape& previous = resident[old];
+            if (previous.contentHash == incoming.contentHash) {
+                updated.push_back(previous); // Unchanged: keep the GPU storage untouched
+                continue;
+            }
+            if (incoming.vertexCount <= previous.vertexCapacity &&
+                incoming.indexBytes() <= previous.indexCapacity &&
+                previous.indexOffset % incoming.indexSize == 0) {
+                shape.baseVertex = previous.baseVertex; // Rewrite in place
+                shape.indexOffset = previous.indexOffset;
+                shape.vertexCapacity = previous.vertexCapacity;
+                shape.indexCapacity = previous.indexCapacity;
+                writeShape(shape, vertices, indices);
+                updated.push_back(shape);
+                ++stats.changed;
+                ++stats.inPlace;
+                stats.bytesUploaded += bytes;
+                continue;
+            }
+            wastedBytes_ += std::size_t(previous.vertexCapacity) * vertexStride_ + previous.indexCapacity;
+        }
+
+        // Grown or new shape: give it fresh storage at the end of the buffers
+        appendStorage(shape);
+        writeShape(shape, vertices, indices);
+        updated.push_back(shape);
+        ++stats.changed;
+        stats.bytesUploaded += bytes;
+    }
+
+    for (std::size_t old = 0; old < resident.size(); ++old) {
+        if (!matched[old]) {
+            wastedBytes_ += std::size_t(resident[old].vertexCapacity) * vertexStride_ + resident[old].indexCapacity;
+            ++stats.removed;
+        }
+    }
+    resident = std::move(updated);
+    tableStale_ = true;
+    return stats;
+}
+
+void SceneBuffers::refreshTable(const std::vector<ModelInstance>& instances) {
+    if (!tableStale_ && tableInstances_ == instances.size())
+        return;
+    table_.rebuild(meshShapes_, instances); // Every record starts visible
+    tableStale_ = false;
+    tableInstances_ = instances.size();
+}
+
+CullStats SceneBuffers::cull(const std::vector<ModelInstance>& instances, const glm::mat4& transform) {
+    refreshTable(instances);
+    return table_.cull(meshShapes_, transform);
+}
+
+LodStats SceneBuffers::selectLods(const std::vector<ModelInstance>& instances, const glm::mat4& transform, float pixelsPerUnit,
+                                  float thresholdPixels, int forcedLevel) {
+    refreshTable(instances);
+    return table_.selectLods(meshShapes_, transform, pixelsPerUnit, thresholdPixels, forcedLevel);
+}
+
+ClusterStats SceneBuffers::cullClusters(const std::vector<ModelInstance>& instances, const glm::mat4& transform, bool backfaces,
+                                        ThreadPool& pool) {
+    refreshTable(instances);
+    return table_.cullClusters(meshShapes_, transform, backfaces, pool);
+}
+
+void SceneBuffers::draw(const std::vector<ModelInstance>& instances) {
+    refreshTable(instances);
+    glBindVertexArray(vao_); // Bind the VAO
+    table_.submit();         // Draw every visible shape of every instance
+    glBindVertexArray(0);    // Unbind the VAO
+}
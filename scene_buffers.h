@@ -0,0 +1,109 @@
+#pragma once
+
+#include <cstddef>                         // For std::size_t
+#include <vector>                          // For using the std::vector container
+#include <GL/glew.h>                       // GLEW library for managing OpenGL extensions
+#include "asset_loader.h"                  // Source of the chunks to upload
+#include "draw_table.h"                    // Indirect commands for the resident shapes
+#include "geometry.h"                      // Vertex layout and draw ranges
+#include "scene_manifest.h"                // Instances to draw
+#include "vertex_format.h"                 // Layout of the vertices in the VBO
+
+// What applying a hot reload changed
+struct ReloadStats {
+    unsigned shapes = 0;                   // Shapes in the new version of the file
+    unsigned changed = 0;                  // Shapes whose contents differ, including new ones
+    unsigned inPlace = 0;                  // Changed shapes that fit in their old storage
+    unsigned removed = 0;                  // Shapes that no longer exist
+    std::size_t bytesUploaded = 0;         // Vertex and index bytes written
+};
+
+// Shared VBO/EBO that grow as chunks arrive, uploaded under a per-frame byte budget
+class SceneBuffers {
+public:
+    // Create the VAO, buffers and draw table; needs a current GL context. multiDraw allows
+    // glMultiDrawElementsIndirect where the context supports it. Vertices are stored in format,
+    // which must match the shader program the scene is drawn with. persistentStreaming allows the
+    // draw table to stream its commands through a persistently mapped buffer.
+    void create(bool multiDraw = true, VertexFormat format = VertexFormat::Float, bool persistentStreaming = true);
+    // Delete every GL object
+    void destroy();
+
+    // Upload queued chunks until about budgetBytes have been copied this frame, returns the bytes copied.
+    // A chunk larger than the budget is spread over several frames and drawn once it is complete.
+    std::size_t upload(AssetLoader& loader, std::size_t budgetBytes);
+
+    // Upload every shape of chunk immediately, ignoring any budget
+    void uploadNow(const IndexedGeometry& chunk);
+
+    // Replace the resident shapes of batch.meshId by the re-parsed ones. Shapes are matched by name;
+    // unchanged ones keep their storage, changed ones are rewritten with glBufferSubData in place when
+    // they fit and appended otherwise. Storage that is no longer referenced is counted, not reclaimed.
+    ReloadStats applyReload(const ReloadBatch& batch);
+
+    // Bytes of buffer storage orphaned by reloads
+    std::size_t wastedBytes() const { return wastedBytes_; }
+    // Bytes of VBO and EBO storage claimed by resident or pending shapes
+    std::size_t vertexBytes() const { return vertexBytes_; }
+    std::size_t indexBytes() const { return indexBytes_; }
+    VertexFormat vertexFormat() const { return format_; }
+
+    // Hide the shapes of instances that fall outside the view of transform until the next cull()
+    CullStats cull(const std::vector<ModelInstance>& instances, const glm::mat4& transform);
+
+    // Pick the level of detail of every shape from its projected error, see DrawTable::selectLods()
+    LodStats selectLods(const std::vector<ModelInstance>& instances, const glm::mat4& transform, float pixelsPerUnit,
+                        float thresholdPixels, int forcedLevel = -1);
+
+    // Draw only the meshlets of full-detail shapes that are in view, see DrawTable::cullClusters()
+    ClusterStats cullClusters(const std::vector<ModelInstance>& instances, const glm::mat4& transform, bool backfaces,
+                              ThreadPool& pool);
+
+    // Draw every fully uploaded, unculled shape of every instance through the draw table
+    void draw(const std::vector<ModelInstance>& instances);
+
+    // Table of the last draw; records may be hidden or reordered until shapes or instances change
+    DrawTable& drawTable() { return table_; }
+
+    // Shapes that are resident on the GPU, grouped by meshId
+    const std::vector<std::vector<DrawShape>>& meshShapes() const { return meshShapes_; }
+    // True when no chunk is partially uploaded
+    bool idle() const { return !pending_; }
+
+private:
+    // Grow buffer to hold at least needed bytes, keeping its first used bytes
+    void reserve(GLuint& buffer, std::size_t& capacity, std::size_t used, std::size_t needed);
+    // Rebuild the draw table when shapes were added or replaced or the instance count changed
+    void refreshTable(const std::vector<ModelInstance>& instances);
+    // Point the VAO's attributes and element binding at the current buffers
+    void bindLayout();
+    // Give shape fresh storage at the end of both buffers
+    void appendStorage(DrawShape& shape);
+    // Write a shape's vertices, encoded in the buffer's format, and its indices to the storage it points at
+    void writeShape(const DrawShape& shape, const Vertex* vertices, const uint8_t* indices);
+
+    GLuint vao_ = 0;
+    GLuint vbo_ = 0;
+    GLuint ebo_ = 0;
+    VertexFormat format_ = VertexFormat::Float;
+    std::size_t vertexStride_ = sizeof(Vertex); // Bytes per vertex in the VBO
+    std::vector<uint8_t> staging_;         // Encoded vertices of the shape being written
+    std::size_t vertexCapacity_ = 0;       // Allocated VBO bytes
+    std::size_t indexCapacity_ = 0;        // Allocated EBO bytes
+    std::size_t vertexBytes_ = 0;          // VBO bytes claimed by resident or pending shapes
+    std::size_t indexBytes_ = 0;           // EBO bytes claimed by resident or pending shapes
+    std::vector<std::vector<DrawShape>> meshShapes_; // Resident shapes per meshId
+    std::size_t wastedBytes_ = 0;
+    DrawTable table_;
+    bool tableStale_ = true;               // Resident shapes changed since the table was built
+    std::size_t tableInstances_ = 0;       // Instance count the table was built for
+
+    // Chunk currently being uploaded
+    bool pending_ = false;
+    IndexedGeometry chunk_;
+    std::vector<uint8_t> chunkVertices_;   // chunk_'s vertices encoded, unless the format is Float
+    std::size_t vertexTarget_ = 0;         // Destination byte offset in the VBO
+    std::size_t indexTarget_ = 0;          // Destination byte offset in the EBO
+    std::size_t vertexDone_ = 0;           // Bytes of the chunk's vertices already copied
+    std::size_t indexDone_ = 0;            // Bytes of the chunk's indices already copied
+};
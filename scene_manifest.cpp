@@ -0,0 +1,94 @@
+#include "scene_manifest.h"
+
+#include <algorithm>                       // For std::find()
+#include <cmath>                           // For std::ceil()/std::sqrt()
+#include <filesystem>                      // For resolving relative model paths
+#include <fstream>                         // For reading the manifest
+#include <iostream>                        // Standard input/output stream library
+#include <sstream>                         // For splitting manifest lines
+#include <glm/gtc/matrix_transform.hpp>    // GLM utilities for matrix transformations
+
+void addModelInstance(Scene& scene, const std::string& path, const glm::mat4& model) {
+    auto found = std::find(scene.modelFiles.begin(), scene.modelFiles.end(), path);
+    uint32_t meshId = static_cast<uint32_t>(found - scene.modelFiles.begin());
+    if (found == scene.modelFiles.end())
+        scene.modelFiles.push_back(path);
+    scene.instances.push_back({meshId, model});
+}
+
+bool loadSceneManifest(const std::string& manifestPath, Scene& scene) {
+    std::ifstream in(manifestPath);
+    if (!in) {
+        std::cerr << "Cannot open scene manifest " << manifestPath << std::endl;
+        return false;
+    }
+    std::filesystem::path baseDirectory = std::filesystem::path(manifestPath).parent_path();
+
+    std::string line;
+    for (int lineNumber = 1; std::getline(in, line); ++lineNumber) {
+        std::istringstream words(line);
+        std::string keyword;
+        if (!(words >> keyword) || keyword[0] == '#')
+            continue;
+
+        auto fail = [&](const std::string& reason) {
+            std::cerr << manifestPath << ":" << lineNumber << ": " << reason << std::endl;
+            return false;
+        };
+        std::string path;
+        if (keyword != "model" || !(words >> path))
+            return fail("expected \"model <path> ...\"");
+        if (std::filesystem::path(path).is_relative())
+            path = (baseDirectory / path).lexically_normal().string();
+
+        glm::mat4 model = glm::mat4(1.0f);
+        std::string transform;
+        while (words >> transform) {
+            if (transform == "translate") {
+                glm::vec3 offset;
+                if (!(words >> offset.x >> offset.y >> offset.z))
+                    return fail("translate needs x y z");
+                model = glm::translate(model, offset);
+            } else if (transform == "rotate") {
+                float degrees;
+                glm::vec3 axis;
+                if (!(words >> degrees >> axis.x >> axis.y >> axis.z))
+                    return fail("rotate needs degrees x y z");
+                model = glm::rotate(model, glm::radians(degrees), axis);
+            } else if (transform == "scale") {
+                glm::vec3 factor;
+                if (!(words >> factor.x))
+                    return fail("scale needs s or x y z");
+                if (!(words >> factor.y)) { // A single number scales uniformly
+                    words.clear();
+                    factor.y = factor.z = factor.x;
+                } else if (!(words >> factor.z)) {
+                    return fail("scale needs s or x y z"); // Two numbers are a typo, not a guess
+                }
+                model = glm::scale(model, factor);
+            } else {
+                return fail("unknown transform \"" + transform + "\"");
+            }
+        }
+        addModelInstance(scene, path, model);
+    }
+    return true;
+}
+
+void repeatInstances(Scene& scene, unsigned copies) {
+    if (copies <= 1)
+        return;
+    unsigned columns = static_cast<unsigned>(std::ceil(std::sqrt(double(copies))));
+    float cell = 2.0f / columns; // Width of one grid cell in normalised device coordinates
+
+    std::vector<ModelInstance> repeated;
+    repeated.reserve(scene.instances.size() * copies);
+    for (const ModelInstance& instance : scene.instances) {
+        for (unsigned i = 0; i < copies; ++i) {
+            glm::vec3 centre(-1.0f + cell * (i % columns + 0.5f), -1.0f + cell * (i / columns + 0.5f), 0.0f);
+            glm::mat4 placement = glm::scale(glm::translate(glm::mat4(1.0f), centre), glm::vec3(1.0f / columns));
+            repeated.push_back({instance.meshId, placement * instance.model});
+        }
+    }
+    scene.instances = std::move(repeated);
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstdint>                         // Fixed-width integer types
+#include <string>                          // For file paths
+#include <vector>                          // For using the std::vector container
+#include <glm/glm.hpp>                     // GLM library for handling matrices and vectors
+
+// One placement of a model in the scene
+struct ModelInstance {
+    uint32_t meshId;                       // Index into Scene::modelFiles
+    glm::mat4 model;                       // Model matrix, applied before the interactive transform
+};
+
+// Models to load and where to draw them; a file used by several instances is loaded once
+struct Scene {
+    std::vector<std::string> modelFiles;   // Unique OBJ paths
+    std::vector<ModelInstance> instances;
+};
+
+// Add an instance of path to the scene, reusing the file entry if it is already listed
+void addModelInstance(Scene& scene, const std::string& path, const glm::mat4& model);
+
+// Read a scene manifest. Every non-empty line that is not a "#" comment reads
+//     model <path> [translate <x> <y> <z>] [rotate <degrees> <x> <y> <z>] [scale <s> | scale <x> <y> <z>]
+// with the transforms applied in the order written. Relative paths are relative to the manifest.
+bool loadSceneManifest(const std::string& manifestPath, Scene& scene);
+
+// Replace every instance by copies laid out on a grid filling the [-1, 1] view, for stress tests
+void repeatInstances(Scene& scene, unsigned copies);
@@ -0,0 +1,103 @@
+#include "shader_program.h"
+
+#include <cstddef>                         // For NULL
+#include <iostream>                        // Standard input/output stream library
+
+// Shader version line, passed ahead of each source so the vertex shader can be given defines
+const char* shaderVersion = "#version 330 core\n"; // Specify OpenGL version 3.3 core
+
+// Vertex Shader source code; COMPACT_VERTICES selects the CompactVertex attributes of vertex_format.h
+const char* vertexShaderSource = R"glsl(
+layout (location = 0) in vec3 aPos;         // Input vertex attribute position at location 0, 0..1 in the shape's bounds when compact
+#ifdef COMPACT_VERTICES
+layout (location = 1) in vec2 aNormal;      // Octahedral-encoded normal
+#else
+layout (location = 1) in vec3 aNormal;      // Normal
+#endif
+layout (location = 2) in vec2 aTexCoord;    // Texture coordinate (half floats are widened by the fetch)
+layout (location = 3) in mat4 aModel;       // Placement of the record being drawn, decoding compact positions, see draw_table.h
+uniform mat4 transform;                     // Uniform matrix for transformations
+out vec3 vNormal;
+out vec2 vTexCoord;
+
+#ifdef COMPACT_VERTICES
+// Unfold the octahedron stored in the square back onto the unit sphere
+vec3 decodeNormal(vec2 encoded) {
+    vec3 n = vec3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+    float fold = max(-n.z, 0.0);
+    n.xy += vec2(n.x >= 0.0 ? -fold : fold, n.y >= 0.0 ? -fold : fold);
+    return normalize(n);
+}
+#else
+vec3 decodeNormal(vec3 normal) {
+    return normal;
+}
+#endif
+
+void main() {
+    gl_Position = transform * aModel * vec4(aPos, 1.0); // Apply transformation to vertex position
+    vNormal = decodeNormal(aNormal);
+    vTexCoord = aTexCoord;
+}
+)glsl";
+
+// Fragment Shader source code
+const char* fragmentShaderSource = R"glsl(
+in vec3 vNormal;                            // Not shaded yet: the scene is drawn as a white wireframe
+in vec2 vTexCoord;
+out vec4 FragColor;                         // Output fragment color
+void main() {
+    FragColor = vec4(1.0f, 1.0f, 1.0f, 1.0f); // Set output color to white
+}
+)glsl";
+
+namespace {
+
+// Print the info log of a shader or program that failed to compile or link
+void reportShaderErrors(GLuint object, bool isProgram) {
+    GLint ok = GL_FALSE;
+    if (isProgram)
+        glGetProgramiv(object, GL_LINK_STATUS, &ok);
+    else
+        glGetShaderiv(object, GL_COMPILE_STATUS, &ok);
+    if (ok == GL_TRUE)
+        return;
+    char log[1024];
+    if (isProgram)
+        glGetProgramInfoLog(object, sizeof(log), NULL, log);
+    else
+        glGetShaderInfoLog(object, sizeof(log), NULL, log);
+    std::cerr << (isProgram ? "Shader link failed: " : "Shader compile failed: ") << log << std::endl;
+}
+
+} // namespace
+
+GLuint createShaderProgram(VertexFormat format) {
+    // Compile the vertex shader
+    const char* vertexSources[] = {shaderVersion, format == VertexFormat::Compact ? "#define COMPACT_VERTICES\n" : "",
+                                   vertexShaderSource};
+    GLuint vertexShader = glCreateShader(GL_VERTEX_SHADER);    // Create a vertex shader object
+    glShaderSource(vertexShader, 3, vertexSources, NULL);      // Attach the shader source code
+    glCompileShader(vertexShader);                              // Compile the vertex shader
+    reportShaderErrors(vertexShader, false);
+
+    // Compile the fragment shader
+    GLuint fragmentShader = glCreateShader(GL_FRAGMENT_SHADER); // Create a fragment shader object
+    const char* fragmentSources[] = {shaderVersion, fragmentShaderSource};
+    glShaderSource(fragmentShader, 2, fragmentSources, NULL);   // Attach the shader source code
+    glCompileShader(fragmentShader);                            // Compile the fragment shader
+    reportShaderErrors(fragmentShader, false);
+
+    // Link shaders to create a shader program
+    GLuint shaderProgram = glCreateProgram();        // Create a shader program object
+    glAttachShader(shaderProgram, vertexShader);     // Attach the vertex shader
+    glAttachShader(shaderProgram, fragmentShader);   // Attach the fragment shader
+    glLinkProgram(shaderProgram);                    // Link the shaders into a program
+    reportShaderErrors(shaderProgram, true);
+
+    // Delete the shader objects after linking them into the program
+    glDeleteShader(vertexShader);                    // Delete the vertex shader object
+    glDeleteShader(fragmentShader);                  // Delete the fragment shader object
+
+    return shaderProgram;
+}
@@ -0,0 +1,7 @@
+#pragma once
+
+#include <GL/glew.h>                       // GLEW library for managing OpenGL extensions
+#include "vertex_format.h"                 // Vertex layout the shader decodes
+
+// Compile and link the scene's vertex and fragment shaders for vertices stored in format, returns the program object
+GLuint createShaderProgram(VertexFormat format = VertexFormat::Float);
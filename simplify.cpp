@@ -0,0 +1,342 @@
+#include "simplify.h"
+
+#include <algorithm>                       // For std::sort()/std::max()
+#include <cmath>                           // For std::sqrt()
+#include <numeric>                         // For std::iota()
+#include <unordered_map>                   // Edge use counts
+
+namespace {
+
+const double borderWeight = 10.0;          // Weight of the planes that hold open borders in place
+
+uint64_t edgeKey(uint32_t a, uint32_t b) {
+    return a < b ? (uint64_t(a) << 32) | b : (uint64_t(b) << 32) | a;
+}
+
+void cross(const double a[3], const double b[3], double out[3]) {
+    out[0] = a[1] * b[2] - a[2] * b[1];
+    out[1] = a[2] * b[0] - a[0] * b[2];
+    out[2] = a[0] * b[1] - a[1] * b[0];
+}
+
+double dot(const double a[3], const double b[3]) {
+    return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+}
+
+} // namespace
+
+void Simplifier::Quadric::addPlane(double x, double y, double z, double w, double planeWeight) {
+    a00 += planeWeight * x * x; a01 += planeWeight * x * y; a02 += planeWeight * x * z; a03 += planeWeight * x * w;
+    a11 += planeWeight * y * y; a12 += planeWeight * y * z; a13 += planeWeight * y * w;
+    a22 += planeWeight * z * z; a23 += planeWeight * z * w;
+    a33 += planeWeight * w * w;
+    weight += planeWeight;
+}
+
+Simplifier::Quadric& Simplifier::Quadric::operator+=(const Quadric& other) {
+    a00 += other.a00; a01 += other.a01; a02 += other.a02; a03 += other.a03;
+    a11 += other.a11; a12 += other.a12; a13 += other.a13;
+    a22 += other.a22; a23 += other.a23;
+    a33 += other.a33;
+    weight += other.weight;
+    return *this;
+}
+
+double Simplifier::Quadric::evaluate(const double p[3]) const {
+    double x = p[0], y = p[1], z = p[2];
+    double value = a00 * x * x + 2.0 * a01 * x * y + 2.0 * a02 * x * z + 2.0 * a03 * x
+                 + a11 * y * y + 2.0 * a12 * y * z + 2.0 * a13 * y
+                 + a22 * z * z + 2.0 * a23 * z
+                 + a33;
+    return std::max(value, 0.0); // Rounding can take a sum of squares slightly below zero
+}
+
+Simplifier::Simplifier(const Vertex* vertices, std::size_t vertexCount, const uint32_t* indices, std::size_t indexCount)
+    : normals_(3 * vertexCount), group_(vertexCount) {
+    // Group the vertices that share a position; a group whose texcoords differ lies on a UV seam
+    std::vector<uint32_t> order(vertexCount);
+    std::iota(order.begin(), order.end(), 0u);
+    auto samePosition = [&](uint32_t a, uint32_t b) {
+        return vertices[a].position[0] == vertices[b].position[0] && vertices[a].position[1] == vertices[b].position[1] &&
+               vertices[a].position[2] == vertices[b].position[2];
+    };
+    std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+        for (int axis = 0; axis < 3; ++axis) {
+            if (vertices[a].position[axis] != vertices[b].position[axis])
+                return vertices[a].position[axis] < vertices[b].position[axis];
+        }
+        return a < b;
+    });
+    members_ = order;
+    for (std::size_t i = 0; i < vertexCount;) {
+        std::size_t end = i + 1;
+        while (end < vertexCount && samePosition(order[i], order[end]))
+            ++end;
+        uint32_t group = static_cast<uint32_t>(memberStart_.size());
+        bool seam = false;
+        for (std::size_t j = i; j < end; ++j) {
+            group_[order[j]] = group;
+            seam = seam || vertices[order[j]].texcoord[0] != vertices[order[i]].texcoord[0] ||
+                   vertices[order[j]].texcoord[1] != vertices[order[i]].texcoord[1];
+        }
+        memberStart_.push_back(static_cast<uint32_t>(i));
+        kinds_.push_back(seam ? Kind::Seam : Kind::Manifold);
+        for (int axis = 0; axis < 3; ++axis)
+            positions_.push_back(vertices[order[i]].position[axis]);
+        i = end;
+    }
+    std::size_t groupCount = memberStart_.size();
+    memberStart_.push_back(static_cast<uint32_t>(vertexCount));
+    quadrics_.assign(groupCount, Quadric());
+    for (std::size_t v = 0; v < vertexCount; ++v) {
+        for (int axis = 0; axis < 3; ++axis)
+            normals_[3 * v + axis] = vertices[v].normal[axis];
+    }
+
+    // Keep the triangles that have an area, by position
+    indices_.reserve(indexCount);
+    for (std::size_t t = 0; t + 2 < indexCount; t += 3) {
+        uint32_t a = indices[t], b = indices[t + 1], c = indices[t + 2];
+        if (group_[a] != group_[b] && group_[b] != group_[c] && group_[a] != group_[c]) {
+            indices_.push_back(a);
+            indices_.push_back(b);
+            indices_.push_back(c);
+        }
+    }
+
+    // Plane quadric of every triangle on its corners, weighted by its area
+    std::unordered_map<uint64_t, uint32_t> edgeUses;
+    edgeUses.reserve(indices_.size());
+    for (std::size_t t = 0; t < indices_.size(); t += 3) {
+        const double* p0 = &positions_[3 * std::size_t(group_[indices_[t]])];
+        const double* p1 = &positions_[3 * std::size_t(group_[indices_[t + 1]])];
+        const double* p2 = &positions_[3 * std::size_t(group_[indices_[t + 2]])];
+        double e1[3] = {p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]};
+        double e2[3] = {p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]};
+        double n[3];
+        cross(e1, e2, n);
+        double length = std::sqrt(dot(n, n));
+        if (length > 0.0) {
+            for (double& c : n)
+                c /= length;
+            for (int k = 0; k < 3; ++k)
+                quadrics_[group_[indices_[t + k]]].addPlane(n[0], n[1], n[2], -dot(n, p0), 0.5 * length);
+        }
+        for (int k = 0; k < 3; ++k)
+            ++edgeUses[edgeKey(group_[indices_[t + k]], group_[indices_[t + (k + 1) % 3]])];
+    }
+
+    // Open borders get planes through the edge at right angles to the face, so border positions stay
+    // on the border line; non-manifold edges lock their ends
+    for (std::size_t t = 0; t < indices_.size(); t += 3) {
+        for (int k = 0; k < 3; ++k) {
+            uint32_t a = group_[indices_[t + k]], b = group_[indices_[t + (k + 1) % 3]];
+            uint32_t uses = edgeUses[edgeKey(a, b)];
+            if (uses > 2) {
+                kinds_[a] = kinds_[b] = Kind::Locked;
+                continue;
+            }
+            if (uses != 1)
+                continue;
+            const double* pa = &positions_[3 * std::size_t(a)];
+            const double* pb = &positions_[3 * std::size_t(b)];
+            const double* pc = &positions_[3 * std::size_t(group_[indices_[t + (k + 2) % 3]])];
+            double edge[3] = {pb[0] - pa[0], pb[1] - pa[1], pb[2] - pa[2]};
+            double other[3] = {pc[0] - pa[0], pc[1] - pa[1], pc[2] - pa[2]};
+            double n[3], m[3];
+            cross(edge, other, n);
+            cross(edge, n, m);
+            double length = std::sqrt(dot(m, m));
+            if (length == 0.0)
+                continue;
+            for (double& c : m)
+                c /= length;
+            double weight = borderWeight * dot(edge, edge);
+            quadrics_[a].addPlane(m[0], m[1], m[2], -dot(m, pa), weight);
+            quadrics_[b].addPlane(m[0], m[1], m[2], -dot(m, pa), weight);
+        }
+    }
+}
+
+bool Simplifier::mapVertices(uint32_t from, uint32_t to, std::vector<uint32_t>& remap) const {
+    // A vertex goes to the target vertex it shares a triangle with; on a seam that must exist and be unique
+    bool seam = kinds_[from] == Kind::Seam;
+    for (uint32_t m = memberStart_[from]; m < memberStart_[from + 1]; ++m) {
+        uint32_t vertex = members_[m], target = UINT32_MAX;
+        float closest = -2.0f;
+        for (uint32_t i = triangleStart_[vertex]; i < triangleStart_[vertex + 1]; ++i) {
+            const uint32_t* corners = &indices_[3 * std::size_t(vertexTriangles_[i])];
+            for (int k = 0; k < 3; ++k) {
+                if (group_[corners[k]] != to || corners[k] == target)
+                    continue;
+                if (seam && target != UINT32_MAX)
+                    return false;
+                const float* a = &normals_[3 * std::size_t(vertex)];
+                const float* b = &normals_[3 * std::size_t(corners[k])];
+                float similarity = a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+                if (similarity > closest) {
+                    closest = similarity;
+                    target = corners[k];
+                }
+            }
+        }
+        if (target == UINT32_MAX && triangleStart_[vertex] != triangleStart_[vertex + 1]) {
+            if (seam)
+                return false;
+            // Not next to the target (a hard-normal split): take the target vertex with the closest
+            // normal among those the group touches, which are all on the same side of any UV seam
+            for (uint32_t n = memberStart_[from]; n < memberStart_[from + 1]; ++n) {
+                uint32_t neighbour = remap[members_[n]];
+                if (group_[neighbour] != to)
+                    continue;
+                const float* a = &normals_[3 * std::size_t(vertex)];
+                const float* b = &normals_[3 * std::size_t(neighbour)];
+                float similarity = a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+                if (similarity > closest) {
+                    closest = similarity;
+                    target = neighbour;
+                }
+            }
+            if (target == UINT32_MAX)
+                return false;
+        }
+        if (target != UINT32_MAX)
+            remap[vertex] = target;
+    }
+    return true;
+}
+
+bool Simplifier::keepsOrientation(uint32_t from, uint32_t to) const {
+    const double* moved = &positions_[3 * std::size_t(to)];
+    for (uint32_t m = memberStart_[from]; m < memberStart_[from + 1]; ++m) {
+        uint32_t vertex = members_[m];
+        for (uint32_t i = triangleStart_[vertex]; i < triangleStart_[vertex + 1]; ++i) {
+            const uint32_t* corners = &indices_[3 * std::size_t(vertexTriangles_[i])];
+            if (group_[corners[0]] == to || group_[corners[1]] == to || group_[corners[2]] == to)
+                continue; // Collapses to nothing
+            const double* p[3];
+            const double* q[3];
+            for (int k = 0; k < 3; ++k) {
+                p[k] = &positions_[3 * std::size_t(group_[corners[k]])];
+                q[k] = group_[corners[k]] == from ? moved : p[k];
+            }
+            double a1[3] = {p[1][0] - p[0][0], p[1][1] - p[0][1], p[1][2] - p[0][2]};
+            double a2[3] = {p[2][0] - p[0][0], p[2][1] - p[0][1], p[2][2] - p[0][2]};
+            double b1[3] = {q[1][0] - q[0][0], q[1][1] - q[0][1], q[1][2] - q[0][2]};
+            double b2[3] = {q[2][0] - q[0][0], q[2][1] - q[0][1], q[2][2] - q[0][2]};
+            double before[3], after[3];
+            cross(a1, a2, before);
+            cross(b1, b2, after);
+            if (dot(before, after) <= 0.0)
+                return false; // Flipped or degenerate
+        }
+    }
+    return true;
+}
+
+const std::vector<uint32_t>& Simplifier::simplify(std::size_t targetIndexCount, float maxError) {
+    double maxCost = double(maxError) * double(maxError);
+    std::size_t vertexCount = group_.size(), groupCount = kinds_.size();
+    struct Collapse {
+        uint32_t from;                     // Groups
+        uint32_t to;
+        double cost;                       // Mean squared distance to the merged planes
+    };
+    std::vector<Collapse> candidates;
+    std::vector<uint8_t> touched(groupCount);
+    std::vector<uint8_t> onBorder(groupCount);
+    std::vector<uint32_t> remap(vertexCount);
+    std::unordered_map<uint64_t, uint32_t> edgeUses;
+
+    // Each pass collapses an independent set of the cheapest edges, then compacts the triangles
+    while (indices_.size() > targetIndexCount) {
+        triangleStart_.assign(vertexCount + 1, 0);
+        for (uint32_t index : indices_)
+            ++triangleStart_[index + 1];
+        for (std::size_t v = 0; v < vertexCount; ++v)
+            triangleStart_[v + 1] += triangleStart_[v];
+        vertexTriangles_.resize(indices_.size());
+        std::vector<uint32_t> fill(triangleStart_.begin(), triangleStart_.end() - 1);
+        for (std::size_t i = 0; i < indices_.size(); ++i)
+            vertexTriangles_[fill[indices_[i]]++] = static_cast<uint32_t>(i / 3);
+
+        edgeUses.clear();
+        for (std::size_t t = 0; t < indices_.size(); t += 3) {
+            for (int k = 0; k < 3; ++k)
+                ++edgeUses[edgeKey(group_[indices_[t + k]], group_[indices_[t + (k + 1) % 3]])];
+        }
+        std::fill(onBorder.begin(), onBorder.end(), 0);
+        for (const auto& edge : edgeUses) {
+            if (edge.second == 1)
+                onBorder[edge.first >> 32] = onBorder[edge.first & 0xffffffffu] = 1;
+        }
+
+        // Both directions of every edge that the kinds allow
+        candidates.clear();
+        for (std::size_t t = 0; t < indices_.size(); t += 3) {
+            for (int k = 0; k < 3; ++k) {
+                uint32_t a = group_[indices_[t + k]], b = group_[indices_[t + (k + 1) % 3]];
+                bool borderEdge = edgeUses[edgeKey(a, b)] == 1;
+                for (int direction = 0; direction < 2; ++direction) {
+                    uint32_t from = direction == 0 ? a : b, to = direction == 0 ? b : a;
+                    if (kinds_[from] == Kind::Locked || (onBorder[from] && !borderEdge))
+                        continue;
+                    Quadric sum = quadrics_[from];
+                    sum += quadrics_[to];
+                    double cost = sum.weight > 0.0 ? sum.evaluate(&positions_[3 * std::size_t(to)]) / sum.weight : 0.0;
+                    candidates.push_back({from, to, cost});
+                }
+            }
+        }
+        std::sort(candidates.begin(), candidates.end(), [](const Collapse& a, const Collapse& b) { return a.cost < b.cost; });
+
+        std::size_t trianglesToRemove = (indices_.size() - targetIndexCount + 2) / 3;
+        std::size_t removed = 0, collapses = 0;
+        std::fill(touched.begin(), touched.end(), 0);
+        std::iota(remap.begin(), remap.end(), 0u);
+        for (const Collapse& collapse : candidates) {
+            if (collapse.cost > maxCost || removed >= trianglesToRemove)
+                break;
+            if (touched[collapse.from] || touched[collapse.to] || !keepsOrientation(collapse.from, collapse.to))
+                continue;
+            if (!mapVertices(collapse.from, collapse.to, remap)) {
+                for (uint32_t m = memberStart_[collapse.from]; m < memberStart_[collapse.from + 1]; ++m)
+                    remap[members_[m]] = members_[m];
+                continue;
+            }
+            quadrics_[collapse.to] += quadrics_[collapse.from];
+            error_ = std::max(error_, static_cast<float>(std::sqrt(collapse.cost)));
+            ++collapses;
+
+            // Freeze the ring so later collapses in this pass see unchanged neighbourhoods
+            touched[collapse.from] = touched[collapse.to] = 1;
+            for (uint32_t m = memberStart_[collapse.from]; m < memberStart_[collapse.from + 1]; ++m) {
+                uint32_t vertex = members_[m];
+                for (uint32_t i = triangleStart_[vertex]; i < triangleStart_[vertex + 1]; ++i) {
+                    const uint32_t* corners = &indices_[3 * std::size_t(vertexTriangles_[i])];
+                    bool vanishes = false;
+                    for (int k = 0; k < 3; ++k) {
+                        touched[group_[corners[k]]] = 1;
+                        vanishes = vanishes || group_[corners[k]] == collapse.to;
+                    }
+                    removed += vanishes ? 1 : 0;
+                }
+            }
+        }
+        if (collapses == 0)
+            break; // Everything left is locked, flips or costs too much
+
+        // Apply the collapses and drop the triangles they made degenerate
+        std::size_t kept = 0;
+        for (std::size_t t = 0; t < indices_.size(); t += 3) {
+            uint32_t a = remap[indices_[t]], b = remap[indices_[t + 1]], c = remap[indices_[t + 2]];
+            if (group_[a] == group_[b] || group_[b] == group_[c] || group_[a] == group_[c])
+                continue;
+            indices_[kept++] = a;
+            indices_[kept++] = b;
+            indices_[kept++] = c;
+        }
+        indices_.resize(kept);
+    }
+    return indices_;
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstddef>                         // For std::size_t
+#include <cstdint>                         // Fixed-width integer types
+#include <vector>                          // For using the std::vector container
+#include "geometry.h"                      // Vertex layout
+
+// Quadric error mesh simplification of one indexed shape by half-edge collapses: a position is
+// merged into a neighbouring one, so every level reuses the shape's vertices and only the indices
+// change. All vertices at a position (split by hard normals or UV seams) move together, each onto a
+// vertex of the target on the same side. Positions on a UV seam only slide along the seam, positions
+// on an open border only along the border, and non-manifold positions never move, so seams and
+// borders keep their shape. Quadrics accumulate across calls, so each level is simplified from
+// the previous one while its error is still measured against the original surface.
+class Simplifier {
+public:
+    // Copies the positions and indices, so neither needs to outlive the simplifier
+    Simplifier(const Vertex* vertices, std::size_t vertexCount, const uint32_t* indices, std::size_t indexCount);
+
+    // Collapse edges, cheapest first, until at most targetIndexCount indices remain or the next
+    // collapse would exceed maxError. Returns the indices of the result.
+    const std::vector<uint32_t>& simplify(std::size_t targetIndexCount, float maxError);
+
+    // Largest error of any collapse so far: the root mean square distance of the moved position to
+    // the original planes merged into it, in the units of the positions
+    float error() const { return error_; }
+    const std::vector<uint32_t>& indices() const { return indices_; }
+
+private:
+    // Symmetric 4x4 matrix of the summed squared distances to a set of planes
+    struct Quadric {
+        double a00, a01, a02, a03, a11, a12, a13, a22, a23, a33;
+        double weight;                     // Sum of the plane weights
+
+        void addPlane(double x, double y, double z, double w, double planeWeight);
+        Quadric& operator+=(const Quadric& other);
+        double evaluate(const double p[3]) const;
+    };
+
+    // Per position group
+    enum class Kind : uint8_t {
+        Manifold,                          // Free to collapse onto any neighbour
+        Seam,                              // Vertices with different texcoords: collapses only along the seam
+        Locked,                            // Non-manifold: never collapses
+    };
+
+    // Pick the vertex of group to that each vertex of group from becomes, writing them into remap.
+    // False if a vertex has no target on its side of a seam.
+    bool mapVertices(uint32_t from, uint32_t to, std::vector<uint32_t>& remap) const;
+    // True if moving group from onto group to keeps every remaining triangle around from facing the same way
+    bool keepsOrientation(uint32_t from, uint32_t to) const;
+
+    std::vector<double> positions_;        // xyz per group
+    std::vector<float> normals_;           // xyz per vertex, to match vertices across hard-normal splits
+    std::vector<uint32_t> group_;          // Position group of every vertex
+    std::vector<uint32_t> memberStart_;    // Per group, into members_
+    std::vector<uint32_t> members_;        // Vertices of each group
+    std::vector<Kind> kinds_;
+    std::vector<Quadric> quadrics_;
+    std::vector<uint32_t> indices_;
+    std::vector<uint32_t> triangleStart_;  // Per vertex, into vertexTriangles_ (rebuilt every pass)
+    std::vector<uint32_t> vertexTriangles_;
+    float error_ = 0.0f;
+};
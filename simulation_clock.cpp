@@ -0,0 +1,60 @@
+#include "simulation_clock.h"
+
+#include <algorithm>                       // For std::max()
+#include <cmath>                           // For std::ceil()
+#include <thread>                          // For std::this_thread::sleep_until()
+
+SimulationClock::SimulationClock(unsigned simulationRate, unsigned frameRate, bool live)
+    : simulationRate_(std::max(simulationRate, 1u)), frameRate_(frameRate), live_(live) {}
+
+unsigned SimulationClock::advance() {
+    frameStart_ = Clock::now();
+    if (frames_ == 0)
+        start_ = frameStart_;
+    uint64_t due = 0;
+    if (live_) {
+        // Time of the frame in ticks, keeping at most a quarter second of ticks to catch up on
+        double elapsed = std::chrono::duration<double>(frameStart_ - start_).count() * simulationRate_;
+        double maxBehind = std::max(0.25 * simulationRate_, 1.0);
+        if (elapsed - ticks_ > maxBehind) {
+            start_ += std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>((elapsed - ticks_ - maxBehind) / simulationRate_));
+            elapsed = ticks_ + maxBehind;
+        }
+        due = static_cast<uint64_t>(std::ceil(elapsed));
+        alpha_ = due == 0 ? 1.0f : static_cast<float>(elapsed - (due - 1));
+    } else {
+        // Frame n is drawn at n / frameRate seconds and tick t ends at t / simulationRate, in whole numbers
+        uint64_t rate = frameRate_ != 0 ? frameRate_ : simulationRate_;
+        uint64_t elapsed = frames_ * simulationRate_; // Time of the frame in ticks, times rate
+        due = (elapsed + rate - 1) / rate;
+        alpha_ = due == 0 ? 1.0f : static_cast<float>(double(elapsed - (due - 1) * rate) / rate);
+    }
+    ++frames_;
+    unsigned count = static_cast<unsigned>(due - ticks_);
+    ticks_ = due;
+    return count;
+}
+
+void SimulationClock::waitForNextFrame() const {
+    if (frameRate_ != 0)
+        std::this_thread::sleep_until(frameStart_ + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / frameRate_)));
+}
+
+SimulationClock::Clock::time_point SimulationClock::tickTime() const {
+    return start_ + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(double(ticks_) / simulationRate_));
+}
+
+unsigned SimulationClock::framesFor(uint64_t ticks) const {
+    uint64_t rate = frameRate_ != 0 ? frameRate_ : simulationRate_;
+    return static_cast<unsigned>((ticks * rate + simulationRate_ - 1) / simulationRate_ + 1);
+}
+
+glm::mat4 interpolateTransform(const glm::mat4& previous, const glm::mat4& current, float alpha) {
+    // Weights that sum to one, so alpha 1 gives current exactly; a still transform is kept as it is
+    if (previous == current)
+        return current;
+    glm::mat4 blended;
+    for (int column = 0; column < 4; ++column)
+        blended[column] = previous[column] * (1.0f - alpha) + current[column] * alpha;
+    return blended;
+}
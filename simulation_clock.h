@@ -0,0 +1,48 @@
+#pragma once
+
+#include <chrono>                          // For the wall clock of live runs
+#include <cstdint>                         // Fixed-width integer types
+#include <glm/glm.hpp>                     // GLM library for handling matrices and vectors
+
+// Schedules the ticks of a simulation running at a fixed rate against the frames drawn from it.
+// A live clock follows the wall clock, so the simulation keeps real time at any frame rate; a
+// virtual one advances exactly 1 / frameRate seconds per frame (one tick when frameRate is 0), so
+// scripted and offline runs tick the same way however fast their frames are drawn. Either way the
+// simulation runs at most one tick ahead: a frame draws the state at its own time, which lies
+// between the last two ticks, alpha of the way from the older one.
+class SimulationClock {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    SimulationClock(unsigned simulationRate, unsigned frameRate, bool live);
+
+    // Start a frame and return the number of ticks to run before drawing it. A live clock that falls
+    // more than a quarter second behind drops the excess rather than catching up.
+    unsigned advance();
+    // Where the frame started by advance() lies between the last two ticks, in (0, 1]
+    float alpha() const { return alpha_; }
+    // Sleep until the next frame is due when frames are capped at frameRate per second
+    void waitForNextFrame() const;
+
+    double tickSeconds() const { return 1.0 / simulationRate_; }
+    // Ticks returned by advance() so far
+    uint64_t ticks() const { return ticks_; }
+    // Wall time at which a live clock reaches the state after the last tick; the next tick is due after it
+    Clock::time_point tickTime() const;
+    // Frames a virtual clock draws until it shows the state after ticks ticks
+    unsigned framesFor(uint64_t ticks) const;
+
+private:
+    unsigned simulationRate_;
+    unsigned frameRate_;                   // 0 for no cap
+    bool live_;
+    uint64_t frames_ = 0;                  // Started by advance()
+    uint64_t ticks_ = 0;
+    float alpha_ = 0.0f;
+    Clock::time_point start_;              // Of the live clock's tick 0
+    Clock::time_point frameStart_;         // Of the current frame
+};
+
+// Transform drawn alpha of the way from previous to current, blending the matrices element by
+// element; close enough to the true motion for the small steps of one tick
+glm::mat4 interpolateTransform(const glm::mat4& previous, const glm::mat4& current, float alpha);
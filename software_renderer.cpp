@@ -0,0 +1,356 @@
+#include "software_renderer.h"
+
+#include <algorithm>                       // For std::min()/std::max()/std::upper_bound()
+#include <chrono>                          // For the stage timings
+#include <cmath>                           // For std::ceil()/std::floor()/std::sqrt()
+#include "frustum.h"                       // For skipping shapes outside the view
+#include "vertex_transform.h"              // Vertex stage and outcodes
+
+namespace {
+
+// Vertices transformed per task of the vertex stage
+const std::size_t vertexChunk = 4096;
+// Triangles set up per task of the binning stage, each batch binning into its own lists
+const std::size_t triangleBatch = 4096;
+
+// Background and line colours of the GL path: glClearColor(0.2, 0.2, 0.2) and a white fragment shader
+const uint8_t background = 51;
+const uint8_t lineColour = 255;
+
+// Keep the part of the convex polygon in[0, count) where side * z + w >= 0, returns the new count
+int clipPolygon(const glm::vec4* in, int count, glm::vec4* out, float side) {
+    int kept = 0;
+    for (int i = 0; i < count; ++i) {
+        const glm::vec4& a = in[i];
+        const glm::vec4& b = in[(i + 1) % count];
+        float da = side * a.z + a.w;
+        float db = side * b.z + b.w;
+        if (da >= 0.0f)
+            out[kept++] = a;
+        if ((da >= 0.0f) != (db >= 0.0f))
+            out[kept++] = a + (b - a) * (da / (da - db));
+    }
+    return kept;
+}
+
+// Index of the job whose range of member values holds value; jobs are sorted by it
+template <typename Job>
+std::size_t findJob(const std::vector<Job>& jobs, std::size_t value, std::size_t Job::*member) {
+    auto after = std::upper_bound(jobs.begin(), jobs.end(), value,
+                                  [member](std::size_t v, const Job& job) { return v < job.*member; });
+    return static_cast<std::size_t>(after - jobs.begin()) - 1;
+}
+
+double millisSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+} // namespace
+
+SoftwareStats& SoftwareStats::operator+=(const SoftwareStats& other) {
+    frames += other.frames;
+    shapes += other.shapes;
+    shapesInside += other.shapesInside;
+    triangles += other.triangles;
+    trianglesDrawn += other.trianglesDrawn;
+    tileEntries += other.tileEntries;
+    vertexMillis += other.vertexMillis;
+    binMillis += other.binMillis;
+    rasterMillis += other.rasterMillis;
+    return *this;
+}
+
+void SoftwareRenderer::resize(int width, int height) {
+    width_ = width;
+    height_ = height;
+    tilesX_ = (width + softwareTileSize - 1) / softwareTileSize;
+    tilesY_ = (height + softwareTileSize - 1) / softwareTileSize;
+    colour_.assign(std::size_t(width) * height * 3, background);
+    depth_.assign(std::size_t(width) * height, 1.0f);
+    bins_.clear();                         // Laid out per tile
+}
+
+void SoftwareRenderer::addShapes(const IndexedGeometry& chunk) {
+    for (const DrawShape& source : chunk.shapes) {
+        if (source.meshId >= meshShapes_.size())
+            meshShapes_.resize(source.meshId + 1);
+        Shape shape;
+        shape.bounds = source.bounds;
+        shape.x.resize(source.vertexCount);
+        shape.y.resize(source.vertexCount);
+        shape.z.resize(source.vertexCount);
+        for (uint32_t v = 0; v < source.vertexCount; ++v) {
+            const float* p = chunk.vertices[source.baseVertex + v].position;
+            shape.x[v] = p[0];
+            shape.y[v] = p[1];
+            shape.z[v] = p[2];
+        }
+        shape.indices.resize(source.indexCount);
+        for (uint32_t i = 0; i < source.indexCount; ++i)
+            shape.indices[i] = shapeIndex(chunk, source, i);
+        meshShapes_[source.meshId].push_back(std::move(shape));
+    }
+}
+
+SoftwareStats SoftwareRenderer::render(const std::vector<ModelInstance>& instances, const glm::mat4& transform,
+                                       bool wireframe, bool cull, bool cullBackfaces, ThreadPool& pool) {
+    SoftwareStats stats;
+    stats.frames = 1;
+    auto start = std::chrono::steady_clock::now();
+
+    // Shapes in view, with their place among the frame's vertices and triangles
+    jobs_.clear();
+    std::size_t vertexCount = 0, triangleCount = 0;
+    for (const ModelInstance& instance : instances) {
+        if (instance.meshId >= meshShapes_.size())
+            continue;
+        glm::mat4 clipFromObject = transform * instance.model;
+        Frustum frustum = extractFrustum(clipFromObject);
+        for (const Shape& shape : meshShapes_[instance.meshId]) {
+            if (cull && !boundsVisible(frustum, shape.bounds))
+                continue;
+            jobs_.push_back({&shape, clipFromObject, vertexCount, triangleCount, ClipSummary()});
+            vertexCount += shape.x.size();
+            triangleCount += shape.indices.size() / 3;
+        }
+    }
+    stats.triangles = triangleCount;
+
+    // Vertex stage: every shape in ranges of at most vertexChunk vertices, whose outcodes are then combined per shape
+    clipX_.resize(vertexCount);
+    clipY_.resize(vertexCount);
+    clipZ_.resize(vertexCount);
+    clipW_.resize(vertexCount);
+    outcodes_.resize(vertexCount);
+    vertexTasks_.clear();
+    for (std::size_t j = 0; j < jobs_.size(); ++j) {
+        for (std::size_t first = 0; first < jobs_[j].shape->x.size(); first += vertexChunk)
+            vertexTasks_.push_back({j, first, std::min(vertexChunk, jobs_[j].shape->x.size() - first), ClipSummary()});
+    }
+    TransformKernel kernel = bestTransformKernel();
+    pool.parallelFor(vertexTasks_.size(), [&](std::size_t t) {
+        VertexTask& task = vertexTasks_[t];
+        const Shape& shape = *jobs_[task.job].shape;
+        std::size_t at = jobs_[task.job].firstVertex + task.first;
+        PositionArrays positions = {&shape.x[task.first], &shape.y[task.first], &shape.z[task.first]};
+        ClipArrays clip = {&clipX_[at], &clipY_[at], &clipZ_[at], &clipW_[at]};
+        task.clip = transformPositions(jobs_[task.job].clipFromObject, positions, task.count, clip, &outcodes_[at], kernel);
+    });
+    for (const VertexTask& task : vertexTasks_)
+        jobs_[task.job].clip += task.clip;
+    for (const Job& job : jobs_)
+        stats.shapesInside += job.clip.anyOutside == 0;
+    stats.shapes = jobs_.size();
+    stats.vertexMillis = millisSince(start);
+
+    // Clipping, setup and binning, each batch of triangles into its own bins
+    start = std::chrono::steady_clock::now();
+    std::size_t tileCount = std::size_t(tilesX_) * tilesY_;
+    std::size_t batchCount = (triangleCount + triangleBatch - 1) / triangleBatch;
+    if (batchTriangles_.size() < batchCount)
+        batchTriangles_.resize(batchCount);
+    if (bins_.size() < batchCount * tileCount)
+        bins_.resize(batchCount * tileCount);
+    batchEntries_.assign(batchCount, 0);
+    pool.parallelFor(batchCount, [&](std::size_t batch) {
+        binTriangles(batch, batch * triangleBatch, std::min(triangleCount, (batch + 1) * triangleBatch), cullBackfaces);
+    });
+    for (std::size_t batch = 0; batch < batchCount; ++batch) {
+        stats.trianglesDrawn += batchTriangles_[batch].size();
+        stats.tileEntries += batchEntries_[batch];
+    }
+    batchCount_ = batchCount;
+    stats.binMillis = millisSince(start);
+
+    // Every tile is cleared and drawn by one task
+    start = std::chrono::steady_clock::now();
+    pool.parallelFor(tileCount, [&](std::size_t tile) { rasterTile(tile, wireframe); });
+    stats.rasterMillis = millisSince(start);
+    return stats;
+}
+
+void SoftwareRenderer::binTriangles(std::size_t batch, std::size_t first, std::size_t last, bool cullBackfaces) {
+    std::size_t tileCount = std::size_t(tilesX_) * tilesY_;
+    batchTriangles_[batch].clear();
+    for (std::size_t tile = 0; tile < tileCount; ++tile)
+        bins_[batch * tileCount + tile].clear();
+
+    std::size_t j = findJob(jobs_, first, &Job::firstTriangle);
+    for (std::size_t t = first; t < last; ++t) {
+        while (t >= jobs_[j].firstTriangle + jobs_[j].shape->indices.size() / 3)
+            ++j;
+        const Job& job = jobs_[j];
+        if (job.clip.allOutside) {         // Every vertex is outside one plane: skip the rest of the shape
+            t = std::min(last, job.firstTriangle + job.shape->indices.size() / 3) - 1;
+            continue;
+        }
+        const uint32_t* corners = &job.shape->indices[3 * (t - job.firstTriangle)];
+        std::size_t ia = job.firstVertex + corners[0], ib = job.firstVertex + corners[1], ic = job.firstVertex + corners[2];
+        glm::vec4 a(clipX_[ia], clipY_[ia], clipZ_[ia], clipW_[ia]);
+        glm::vec4 b(clipX_[ib], clipY_[ib], clipZ_[ib], clipW_[ib]);
+        glm::vec4 c(clipX_[ic], clipY_[ic], clipZ_[ic], clipW_[ic]);
+
+        // Shapes inside the clip volume need no tests; otherwise reject triangles outside one plane.
+        // Only the near and far planes are clipped, the others are left to the screen bounds of the setup.
+        unsigned codes = 0;
+        if (job.clip.anyOutside) {
+            uint8_t codeA = outcodes_[ia], codeB = outcodes_[ib], codeC = outcodes_[ic];
+            if (codeA & codeB & codeC)
+                continue;
+            codes = codeA | codeB | codeC;
+        }
+        if (!(codes & (outsideNear | outsideFar))) {
+            setupTriangle(batch, a, b, c, cullBackfaces);
+            continue;
+        }
+        glm::vec4 polygon[5] = {a, b, c};
+        glm::vec4 clipped[5];
+        int count = clipPolygon(polygon, 3, clipped, 1.0f);     // z >= -w
+        count = clipPolygon(clipped, count, polygon, -1.0f);    // z <= w
+        for (int k = 2; k < count; ++k)
+            setupTriangle(batch, polygon[0], polygon[k - 1], polygon[k], cullBackfaces);
+    }
+}
+
+bool SoftwareRenderer::setupTriangle(std::size_t batch, const glm::vec4& a, const glm::vec4& b, const glm::vec4& c,
+                                     bool cullBackfaces) {
+    const glm::vec4* corners[3] = {&a, &b, &c};
+    Triangle triangle;
+    glm::vec3 ndc[3];
+    float depth[3];
+    for (int k = 0; k < 3; ++k) {
+        const glm::vec4& v = *corners[k];
+        if (!(v.w > 1e-6f))
+            return false;                  // Only a sliver at the eye is left after clipping
+        ndc[k] = glm::vec3(v) / v.w;
+        triangle.x[k] = (0.5f * ndc[k].x + 0.5f) * width_;
+        triangle.y[k] = (0.5f - 0.5f * ndc[k].y) * height_;
+        depth[k] = 0.5f * ndc[k].z + 0.5f;
+    }
+
+    // Counter-clockwise front faces turn clockwise with y pointing down, giving a negative area
+    float dx1 = triangle.x[1] - triangle.x[0], dy1 = triangle.y[1] - triangle.y[0];
+    float dx2 = triangle.x[2] - triangle.x[0], dy2 = triangle.y[2] - triangle.y[0];
+    float area = dx1 * dy2 - dx2 * dy1;
+    if (area == 0.0f || (cullBackfaces && area > 0.0f))
+        return false;
+
+    // First and last pixels whose centres the bounding box holds, rounded as rasterTile() walks them and
+    // kept within the target; a box that starts past the last pixel centre but still holds it is kept
+    float minX = std::min({triangle.x[0], triangle.x[1], triangle.x[2]}), maxX = std::max({triangle.x[0], triangle.x[1], triangle.x[2]});
+    float minY = std::min({triangle.y[0], triangle.y[1], triangle.y[2]}), maxY = std::max({triangle.y[0], triangle.y[1], triangle.y[2]});
+    float firstX = std::max(std::ceil(minX - 0.5f), 0.0f), lastX = std::min(std::ceil(maxX - 0.5f), float(width_)) - 1.0f;
+    float firstY = std::max(std::ceil(minY - 0.5f), 0.0f), lastY = std::min(std::ceil(maxY - 0.5f), float(height_)) - 1.0f;
+    if (firstX > lastX || firstY > lastY)
+        return false;
+    int tileX0 = int(firstX) / softwareTileSize, tileX1 = int(lastX) / softwareTileSize;
+    int tileY0 = int(firstY) / softwareTileSize, tileY1 = int(lastY) / softwareTileSize;
+
+    // Depth is affine in screen space; flat shading from the facing of the normalised-device triangle
+    float dd1 = depth[1] - depth[0], dd2 = depth[2] - depth[0];
+    triangle.depthA = (dd1 * dy2 - dd2 * dy1) / area;
+    triangle.depthB = (dx1 * dd2 - dx2 * dd1) / area;
+    triangle.depthC = depth[0] - triangle.depthA * triangle.x[0] - triangle.depthB * triangle.y[0];
+    glm::vec3 normal = glm::cross(ndc[1] - ndc[0], ndc[2] - ndc[0]);
+    float length = glm::length(normal);
+    triangle.shade = static_cast<uint8_t>(length > 0.0f ? 64.0f + 191.0f * std::abs(normal.z) / length : 255.0f);
+
+    std::vector<Triangle>& triangles = batchTriangles_[batch];
+    uint32_t index = static_cast<uint32_t>(triangles.size());
+    triangles.push_back(triangle);
+    std::size_t tileCount = std::size_t(tilesX_) * tilesY_;
+    for (int tileY = tileY0; tileY <= tileY1; ++tileY) {
+        for (int tileX = tileX0; tileX <= tileX1; ++tileX)
+            bins_[batch * tileCount + std::size_t(tileY) * tilesX_ + tileX].push_back(index);
+    }
+    batchEntries_[batch] += std::size_t(tileY1 - tileY0 + 1) * (tileX1 - tileX0 + 1);
+    return true;
+}
+
+namespace {
+
+// Draw the segment from a to b with one pixel per column (or row, for steep segments) whose centre it
+// crosses, within the pixels [x0, x1) x [y0, y1)
+void drawLine(uint8_t* colour, int width, float ax, float ay, float bx, float by, int x0, int x1, int y0, int y1) {
+    bool steep = std::abs(by - ay) > std::abs(bx - ax);
+    if (steep) {                           // Walk rows instead: swap the axes
+        std::swap(ax, ay);
+        std::swap(bx, by);
+        std::swap(x0, y0);
+        std::swap(x1, y1);
+    }
+    if (ax > bx) {
+        std::swap(ax, bx);
+        std::swap(ay, by);
+    }
+    if (bx == ax)
+        return;
+    float slope = (by - ay) / (bx - ax);
+    int first = int(std::ceil(std::max(ax - 0.5f, float(x0))));
+    int last = int(std::ceil(std::min(bx - 0.5f, float(x1))));
+    for (int i = first; i < last; ++i) {
+        float j = ay + (i + 0.5f - ax) * slope;
+        if (!(j >= y0 && j < y1))
+            continue;
+        int row = steep ? i : int(j), column = steep ? int(j) : i;
+        uint8_t* pixel = colour + 3 * (std::size_t(row) * width + column);
+        pixel[0] = pixel[1] = pixel[2] = lineColour;
+    }
+}
+
+} // namespace
+
+void SoftwareRenderer::rasterTile(std::size_t tile, bool wireframe) {
+    int x0 = int(tile % tilesX_) * softwareTileSize, x1 = std::min(x0 + softwareTileSize, width_);
+    int y0 = int(tile / tilesX_) * softwareTileSize, y1 = std::min(y0 + softwareTileSize, height_);
+    for (int y = y0; y < y1; ++y) {
+        std::fill(colour_.begin() + 3 * (std::size_t(y) * width_ + x0), colour_.begin() + 3 * (std::size_t(y) * width_ + x1), background);
+        std::fill(depth_.begin() + std::size_t(y) * width_ + x0, depth_.begin() + std::size_t(y) * width_ + x1, 1.0f);
+    }
+
+    std::size_t tileCount = std::size_t(tilesX_) * tilesY_;
+    for (std::size_t batch = 0; batch < batchCount_; ++batch) {
+        for (uint32_t index : bins_[batch * tileCount + tile]) {
+            const Triangle& t = batchTriangles_[batch][index];
+            if (wireframe) {
+                for (int k = 0; k < 3; ++k)
+                    drawLine(colour_.data(), width_, t.x[k], t.y[k], t.x[(k + 1) % 3], t.y[(k + 1) % 3], x0, x1, y0, y1);
+                continue;
+            }
+
+            // Pixel centres inside all three edges, walked over the triangle's box within the tile
+            float area = (t.x[1] - t.x[0]) * (t.y[2] - t.y[0]) - (t.x[2] - t.x[0]) * (t.y[1] - t.y[0]);
+            float side = area > 0.0f ? 1.0f : -1.0f;
+            float stepX[3], stepY[3], offset[3];
+            for (int k = 0; k < 3; ++k) {  // side * edge(k, k + 1) at (px, py) = stepX * px + stepY * py + offset
+                int n = (k + 1) % 3;
+                stepX[k] = -side * (t.y[n] - t.y[k]);
+                stepY[k] = side * (t.x[n] - t.x[k]);
+                offset[k] = -stepX[k] * t.x[k] - stepY[k] * t.y[k];
+            }
+            float minX = std::min({t.x[0], t.x[1], t.x[2]}), maxX = std::max({t.x[0], t.x[1], t.x[2]});
+            float minY = std::min({t.y[0], t.y[1], t.y[2]}), maxY = std::max({t.y[0], t.y[1], t.y[2]});
+            int px0 = int(std::ceil(std::max(minX - 0.5f, float(x0))));
+            int px1 = int(std::ceil(std::min(maxX - 0.5f, float(x1))));
+            int py0 = int(std::ceil(std::max(minY - 0.5f, float(y0))));
+            int py1 = int(std::ceil(std::min(maxY - 0.5f, float(y1))));
+            for (int py = py0; py < py1; ++py) {
+                float cy = py + 0.5f;
+                float e[3];
+                for (int k = 0; k < 3; ++k)
+                    e[k] = stepX[k] * (px0 + 0.5f) + stepY[k] * cy + offset[k];
+                float depth = t.depthA * (px0 + 0.5f) + t.depthB * cy + t.depthC;
+                std::size_t pixel = std::size_t(py) * width_ + px0;
+                for (int px = px0; px < px1; ++px, ++pixel) {
+                    if (e[0] >= 0.0f && e[1] >= 0.0f && e[2] >= 0.0f && depth < depth_[pixel]) {
+                        depth_[pixel] = depth;
+                        colour_[3 * pixel] = colour_[3 * pixel + 1] = colour_[3 * pixel + 2] = t.shade;
+                    }
+                    for (int k = 0; k < 3; ++k)
+                        e[k] += stepX[k];
+                    depth += t.depthA;
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <cstddef>                         // For std::size_t
+#include <cstdint>                         // Fixed-width integer types
+#include <vector>                          // For using the std::vector container
+#include <glm/glm.hpp>                     // GLM library for handling matrices and vectors
+#include "geometry.h"                      // Shapes of the loaded chunks
+#include "scene_manifest.h"                // Instances and their model matrices
+#include "thread_pool.h"                   // Workers for every stage of a frame
+#include "vertex_transform.h"              // Clip-space outcodes of the shapes
+
+// Side in pixels of the square screen tiles triangles are binned into
+const int softwareTileSize = 64;
+
+// Work and time of the software frames, summed with +=
+struct SoftwareStats {
+    uint64_t frames = 0;
+    uint64_t shapes = 0;                   // Shapes of every instance in the view frustum
+    uint64_t shapesInside = 0;             // Of those, shapes drawn without a clip test per triangle
+    uint64_t triangles = 0;                // Of the shapes in view
+    uint64_t trianglesDrawn = 0;           // Left after clipping and face culling, counting clipped pieces
+    uint64_t tileEntries = 0;              // Triangle and tile pairs binned
+    double vertexMillis = 0.0;             // Transforming the shapes' vertices to clip space
+    double binMillis = 0.0;                // Clipping, triangle setup and binning
+    double rasterMillis = 0.0;             // Clearing and rasterising the tiles
+
+    SoftwareStats& operator+=(const SoftwareStats& other);
+};
+
+// Renders the scene on the CPU, without OpenGL, into an RGB image. A frame runs in three stages on
+// the pool: the vertices of every shape in view are transformed to clip space in fixed-size chunks
+// by the widest transformPositions() kernel, whose outcodes let whole shapes skip per-triangle clip
+// tests or be rejected; triangles are clipped against the near and far planes, set up in screen space and binned into
+// softwareTileSize tiles, each batch of triangles into bins of its own; then the tiles are cleared and
+// rasterised independently, walking the batches in submission order so the image does not depend on
+// the thread count. Filled triangles are flat shaded and depth tested; the wireframe draws the
+// triangles' edges in white without depth, as the GL path does with glPolygonMode(GL_LINE).
+class SoftwareRenderer {
+public:
+    // Size the colour and depth buffers
+    void resize(int width, int height);
+    // Keep the full-detail triangles of every shape of chunk, drawn for the instances of its meshId
+    void addShapes(const IndexedGeometry& chunk);
+
+    // Draw every instance with transform; with cull, shapes outside the view are skipped before the
+    // vertex stage and with cullBackfaces so are triangles facing away (clockwise on screen)
+    SoftwareStats render(const std::vector<ModelInstance>& instances, const glm::mat4& transform, bool wireframe,
+                         bool cull, bool cullBackfaces, ThreadPool& pool);
+
+    // Colour of the last frame as 8-bit RGB, top row first
+    const std::vector<uint8_t>& pixels() const { return colour_; }
+    int width() const { return width_; }
+    int height() const { return height_; }
+
+private:
+    // Positions stored as separate x, y and z arrays, and indices relative to them
+    struct Shape {
+        Bounds bounds;
+        std::vector<float> x, y, z;
+        std::vector<uint32_t> indices;
+    };
+
+    // One shape of one instance in view
+    struct Job {
+        const Shape* shape;
+        glm::mat4 clipFromObject;
+        std::size_t firstVertex;           // Of the job's clip-space vertices in clipX_...
+        std::size_t firstTriangle;         // Of the job's triangles among all jobs'
+        ClipSummary clip;                  // Outcodes of the job's vertices
+    };
+
+    // Range of one job's vertices transformed by one task
+    struct VertexTask {
+        std::size_t job;
+        std::size_t first;
+        std::size_t count;
+        ClipSummary clip;
+    };
+
+    // Screen-space triangle: pixel coordinates with y down and depth in [0, 1]
+    struct Triangle {
+        float x[3], y[3];
+        float depthA, depthB, depthC;      // Depth plane: depthA * x + depthB * y + depthC
+        uint8_t shade;                     // Grey level of a filled triangle
+    };
+
+    // Clip, set up and bin the triangles [first, last) into batch
+    void binTriangles(std::size_t batch, std::size_t first, std::size_t last, bool cullBackfaces);
+    // Set up one clipped triangle, given in clip space, and bin it; false if it covers no pixel
+    bool setupTriangle(std::size_t batch, const glm::vec4& a, const glm::vec4& b, const glm::vec4& c, bool cullBackfaces);
+    // Clear tile and draw the triangles binned into it
+    void rasterTile(std::size_t tile, bool wireframe);
+
+    int width_ = 0;
+    int height_ = 0;
+    int tilesX_ = 0;
+    int tilesY_ = 0;
+    std::vector<std::vector<Shape>> meshShapes_; // Per meshId
+    std::vector<uint8_t> colour_;
+    std::vector<float> depth_;
+
+    // Frame state, kept between frames for its capacity
+    std::vector<Job> jobs_;
+    std::vector<VertexTask> vertexTasks_;
+    std::vector<float> clipX_, clipY_, clipZ_, clipW_; // Clip-space vertices of every job
+    std::vector<uint8_t> outcodes_;        // And their outcodes
+    std::vector<std::vector<Triangle>> batchTriangles_;
+    std::size_t batchCount_ = 0;           // Batches binned this frame
+    std::vector<std::vector<uint32_t>> bins_; // Per batch and tile: indices into the batch's triangles
+    std::vector<uint64_t> batchEntries_;   // Tile entries binned by each batch
+};
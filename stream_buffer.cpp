@@ -0,0 +1,147 @@
+#include "stream_buffer.h"
+
+#include <algorithm>                       // For std::max()
+#include <chrono>                          // For timing fence waits
+
+StreamStats& StreamStats::operator+=(const StreamStats& other) {
+    frames += other.frames;
+    bytes += other.bytes;
+    fenceWaits += other.fenceWaits;
+    fenceWaitMillis += other.fenceWaitMillis;
+    return *this;
+}
+
+void StreamBuffer::create(GLenum target, std::size_t capacity, bool allowPersistent) {
+    target_ = target;
+    capacity_ = capacity;
+    allowPersistent_ = allowPersistent;
+    allocateStorage();
+}
+
+void StreamBuffer::destroy() {
+    releaseStorage();
+    capacity_ = 0;
+    staging_.clear();
+    staging_.shrink_to_fit();
+}
+
+void StreamBuffer::allocateStorage() {
+    glGenBuffers(1, &buffer_);
+    glBindBuffer(target_, buffer_);
+    if (allowPersistent_ && (GLEW_VERSION_4_4 || GLEW_ARB_buffer_storage)) {
+        // Coherent: writes through the mapping reach the GPU without an explicit flush
+        const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(target_, capacity_, nullptr, flags);
+        mapped_ = static_cast<uint8_t*>(glMapBufferRange(target_, 0, capacity_, flags));
+        if (mapped_ == nullptr) { // Immutable storage cannot be respecified, so start over with a mutable buffer
+            glDeleteBuffers(1, &buffer_);
+            glGenBuffers(1, &buffer_);
+            glBindBuffer(target_, buffer_);
+        }
+    }
+    if (mapped_ == nullptr) {
+        glBufferData(target_, capacity_, nullptr, GL_STREAM_DRAW);
+        staging_.assign(capacity_, 0);
+    }
+    glBindBuffer(target_, 0);
+}
+
+void StreamBuffer::releaseStorage() {
+    for (const Frame& frame : inFlight_)
+        glDeleteSync(frame.fence);
+    inFlight_.clear();
+    if (mapped_ != nullptr) {
+        glBindBuffer(target_, buffer_);
+        glUnmapBuffer(target_);
+        glBindBuffer(target_, 0);
+        mapped_ = nullptr;
+    }
+    glDeleteBuffers(1, &buffer_);
+    buffer_ = 0;
+    head_ = used_ = frameBytes_ = 0;
+}
+
+void StreamBuffer::reserve(std::size_t bytesPerFrame) {
+    if (3 * bytesPerFrame <= capacity_ || frame_.bytes > 0)
+        return;
+    capacity_ = std::max(2 * capacity_, 3 * bytesPerFrame);
+    releaseStorage();
+    allocateStorage();
+}
+
+void StreamBuffer::retireOldest() {
+    Frame frame = inFlight_.front();
+    inFlight_.pop_front();
+    if (glClientWaitSync(frame.fence, 0, 0) == GL_TIMEOUT_EXPIRED) {
+        auto start = std::chrono::steady_clock::now();
+        GLenum status = GL_TIMEOUT_EXPIRED;
+        while (status == GL_TIMEOUT_EXPIRED)
+            status = glClientWaitSync(frame.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000); // 1 ms
+        ++frame_.fenceWaits;
+        frame_.fenceWaitMillis += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+    glDeleteSync(frame.fence);
+    used_ -= frame.bytes;
+}
+
+StreamAllocation StreamBuffer::allocate(std::size_t bytes, std::size_t alignment) {
+    StreamAllocation allocation;
+    std::size_t offset = (head_ + alignment - 1) & ~(alignment - 1);
+    if (mapped_ == nullptr) {
+        // Every frame starts over in a fresh (orphaned) buffer
+        if (offset + bytes > capacity_)
+            return allocation;
+        frame_.bytes += offset + bytes - head_;
+        head_ = offset + bytes;
+        allocation.data = staging_.data() + offset;
+        allocation.offset = offset;
+        return allocation;
+    }
+
+    // Space from the head to the end of the allocation, wrapping to the start when it does not fit
+    if (bytes > capacity_)
+        return allocation;
+    if (offset + bytes > capacity_)
+        offset = 0;
+    std::size_t needed = (offset >= head_ ? offset - head_ : capacity_ - head_ + offset) + bytes;
+    while (used_ + needed > capacity_ && !inFlight_.empty())
+        retireOldest();
+    if (used_ + needed > capacity_)
+        return allocation;                 // This frame alone fills the ring
+    used_ += needed;
+    frameBytes_ += needed;
+    frame_.bytes += needed;
+    head_ = offset + bytes;
+    allocation.data = mapped_ + offset;
+    allocation.offset = offset;
+    return allocation;
+}
+
+void StreamBuffer::flush() {
+    glBindBuffer(target_, buffer_);
+    if (mapped_ == nullptr && head_ > 0) {
+        glBufferData(target_, capacity_, nullptr, GL_STREAM_DRAW); // Orphan: draws in flight keep the old storage
+        glBufferSubData(target_, 0, head_, staging_.data());
+    }
+}
+
+StreamStats StreamBuffer::endFrame() {
+    if (mapped_ != nullptr) {
+        if (frameBytes_ > 0)
+            inFlight_.push_back({glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0), frameBytes_});
+        // Return the space of frames the GPU already finished without waiting
+        while (inFlight_.size() > 1 && glClientWaitSync(inFlight_.front().fence, 0, 0) != GL_TIMEOUT_EXPIRED) {
+            glDeleteSync(inFlight_.front().fence);
+            used_ -= inFlight_.front().bytes;
+            inFlight_.pop_front();
+        }
+    } else {
+        head_ = 0;
+    }
+    frameBytes_ = 0;
+    frame_.frames = 1;
+    StreamStats finished = frame_;
+    totals_ += finished;
+    frame_ = StreamStats();
+    return finished;
+}
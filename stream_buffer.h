@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstddef>                         // For std::size_t
+#include <cstdint>                         // Fixed-width integer types
+#include <deque>                           // Frames still read by the GPU
+#include <vector>                          // For using the std::vector container
+#include <GL/glew.h>                       // GLEW library for managing OpenGL extensions
+
+// Bytes written through a stream buffer and time spent waiting for the GPU to release its space
+struct StreamStats {
+    uint64_t frames = 0;                   // Frames ended with endFrame()
+    uint64_t bytes = 0;                    // Allocated, including alignment padding
+    uint64_t fenceWaits = 0;               // Allocations that had to wait for a fence
+    double fenceWaitMillis = 0.0;
+
+    StreamStats& operator+=(const StreamStats& other);
+};
+
+// Space handed out for this frame: write size bytes at data, then draw from offset in buffer()
+struct StreamAllocation {
+    uint8_t* data = nullptr;               // Null when the request does not fit in the ring
+    std::size_t offset = 0;                // In bytes from the start of the buffer
+};
+
+// Ring of transient per-frame data for one buffer target. With GL 4.4 (or ARB_buffer_storage) the
+// buffer is mapped once, persistently and coherently, and allocations are written in place; every
+// frame's space is fenced and only reused once the GPU has passed the fence. On GL 3.3 allocations
+// are staged in memory and flush() orphans the buffer with glBufferData before copying the frame's
+// bytes with one glBufferSubData, so the driver never waits for draws still reading the old storage.
+class StreamBuffer {
+public:
+    // Create the ring of capacity bytes for target (GL_ARRAY_BUFFER, GL_DRAW_INDIRECT_BUFFER, ...);
+    // persistent mapping is used only if allowed and supported. Needs a current GL context.
+    void create(GLenum target, std::size_t capacity, bool allowPersistent = true);
+    // Delete the buffer and fences without waiting; draws already issued keep the storage alive
+    void destroy();
+
+    // Grow the ring so at least three frames of bytesPerFrame fit; only before this frame's first allocation
+    void reserve(std::size_t bytesPerFrame);
+    // Space for bytes at an offset aligned to alignment (a power of two). Waits on the fences of
+    // earlier frames when the ring is full; fails when the request is larger than the free ring.
+    StreamAllocation allocate(std::size_t bytes, std::size_t alignment = 16);
+    // Make this frame's writes visible to GL; leaves the buffer bound to its target
+    void flush();
+    // Fence everything allocated this frame, returns what the frame streamed
+    StreamStats endFrame();
+
+    GLuint buffer() const { return buffer_; }
+    bool persistent() const { return mapped_ != nullptr; }
+    std::size_t capacity() const { return capacity_; }
+    // Every frame since create()
+    const StreamStats& totals() const { return totals_; }
+
+private:
+    // Allocate the storage (and mapping) of capacity_ bytes
+    void allocateStorage();
+    // Release the storage, dropping the fences
+    void releaseStorage();
+    // Wait for the oldest fenced frame and return its space to the ring
+    void retireOldest();
+
+    struct Frame {
+        GLsync fence;
+        std::size_t bytes;                 // Ring bytes the frame holds, including padding and wrap
+    };
+
+    GLenum target_ = GL_ARRAY_BUFFER;
+    GLuint buffer_ = 0;
+    std::size_t capacity_ = 0;
+    bool allowPersistent_ = true;
+    uint8_t* mapped_ = nullptr;            // Persistent mapping, null on the orphaning path
+    std::vector<uint8_t> staging_;         // This frame's bytes on the orphaning path
+    std::size_t head_ = 0;                 // Next free byte
+    std::size_t used_ = 0;                 // Bytes held by fenced frames and this frame
+    std::size_t frameBytes_ = 0;           // Of used_, those allocated this frame
+    std::deque<Frame> inFlight_;           // Oldest first
+    StreamStats frame_;                    // This frame so far
+    StreamStats totals_;
+};
@@ -0,0 +1,55 @@
+#include "synthetic_obj.h"
+
+#include <cmath>                           // For std::sin()/std::cos()/std::sqrt()
+#include <cstdio>                          // Buffered output through FILE*
+
+namespace {
+
+// Rough bytes per grid cell: one v, vt and vn record plus one quad face
+const double bytesPerCell = 175.0;
+
+} // namespace
+
+bool writeSyntheticObj(const std::string& path, unsigned gridSize) {
+    std::FILE* out = std::fopen(path.c_str(), "wb");
+    if (out == nullptr)
+        return false;
+    static char buffer[1 << 20];
+    std::setvbuf(out, buffer, _IOFBF, sizeof(buffer));
+
+    unsigned side = gridSize + 1; // Vertices per row
+    std::fprintf(out, "# Synthetic %ux%u grid\no Grid\n", gridSize, gridSize);
+    for (unsigned y = 0; y < side; ++y) {
+        for (unsigned x = 0; x < side; ++x) {
+            float u = float(x) / gridSize, v = float(y) / gridSize;
+            float height = 0.05f * std::sin(12.0f * u) * std::cos(9.0f * v);
+            std::fprintf(out, "v %.6f %.6f %.6f\n", 2.0f * u - 1.0f, height, 2.0f * v - 1.0f);
+        }
+    }
+    for (unsigned y = 0; y < side; ++y) {
+        for (unsigned x = 0; x < side; ++x)
+            std::fprintf(out, "vt %.6f %.6f\n", float(x) / gridSize, float(y) / gridSize);
+    }
+    for (unsigned y = 0; y < side; ++y) {
+        for (unsigned x = 0; x < side; ++x) {
+            float u = float(x) / gridSize, v = float(y) / gridSize;
+            float dx = -0.05f * 12.0f * std::cos(12.0f * u) * std::cos(9.0f * v) * 0.5f; // Slope of the height field
+            float dz = 0.05f * 9.0f * std::sin(12.0f * u) * std::sin(9.0f * v) * 0.5f;
+            float length = std::sqrt(dx * dx + 1.0f + dz * dz);
+            std::fprintf(out, "vn %.6f %.6f %.6f\n", dx / length, 1.0f / length, dz / length);
+        }
+    }
+    for (unsigned y = 0; y < gridSize; ++y) {
+        for (unsigned x = 0; x < gridSize; ++x) {
+            unsigned a = y * side + x + 1, b = a + 1, c = a + side + 1, d = a + side; // 1-based corners
+            // Counter-clockwise seen from +y, so the faces wind the way their normals point
+            std::fprintf(out, "f %u/%u/%u %u/%u/%u %u/%u/%u %u/%u/%u\n", a, a, a, d, d, d, c, c, c, b, b, b);
+        }
+    }
+    bool ok = std::ferror(out) == 0;
+    return std::fclose(out) == 0 && ok;
+}
+
+unsigned syntheticGridSizeForBytes(uint64_t bytes) {
+    return static_cast<unsigned>(std::sqrt(double(bytes) / bytesPerCell)) + 1;
+}
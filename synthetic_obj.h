@@ -0,0 +1,11 @@
+#pragma once
+
+#include <cstdint>                         // Fixed-width integer types
+#include <string>                          // For file paths
+
+// Write a gridSize x gridSize wavy quad grid as an OBJ with positions, texcoords and normals,
+// returns false if the file cannot be written. Used to benchmark meshes of any size.
+bool writeSyntheticObj(const std::string& path, unsigned gridSize);
+
+// Grid size whose OBJ comes out at roughly the given number of bytes
+unsigned syntheticGridSizeForBytes(uint64_t bytes);
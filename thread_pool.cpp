@@ -0,0 +1,78 @@
+#include "thread_pool.h"
+
+#include <algorithm>                       // For std::max()
+
+ThreadPool::ThreadPool(unsigned threadCount) {
+    if (threadCount == 0)
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    for (unsigned i = 1; i < threadCount; ++i) // The caller is the first thread of every batch
+        workers_.emplace_back(&ThreadPool::workerLoop, this);
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    for (std::thread& worker : workers_)
+        worker.join();
+}
+
+void ThreadPool::parallelFor(std::size_t count, const std::function<void(std::size_t)>& body) {
+    if (count == 0)
+        return;
+    if (workers_.empty() || count == 1) { // Nothing to share, skip the synchronisation
+        for (std::size_t i = 0; i < count; ++i)
+            body(i);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        body_ = &body;
+        count_ = count;
+        next_ = 0;
+        remaining_ = count;
+        ++generation_;
+    }
+    wake_.notify_all();
+
+    runTasks();
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    finished_.wait(lock, [this] { return remaining_ == 0; });
+    body_ = nullptr;
+}
+
+void ThreadPool::workerLoop() {
+    unsigned seenGeneration = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            wake_.wait(lock, [&] { return stopping_ || generation_ != seenGeneration; });
+            if (stopping_)
+                return;
+            seenGeneration = generation_;
+        }
+        runTasks();
+    }
+}
+
+void ThreadPool::runTasks() {
+    for (;;) {
+        std::size_t index;
+        const std::function<void(std::size_t)>* body;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (body_ == nullptr || next_ >= count_)
+                return;
+            index = next_++;
+            body = body_;
+        }
+        (*body)(index);
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (--remaining_ == 0)
+            finished_.notify_all();
+    }
+}
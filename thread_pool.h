@@ -0,0 +1,39 @@
+#pragma once
+
+#include <condition_variable>              // Wakes workers when a batch is posted
+#include <cstddef>                         // For std::size_t
+#include <functional>                      // For the task body
+#include <mutex>                           // Guards the batch state
+#include <thread>                          // Worker threads
+#include <vector>                          // For using the std::vector container
+
+// Fixed set of worker threads that run indexed batches; the calling thread takes part in every batch
+class ThreadPool {
+public:
+    // threadCount includes the calling thread, 0 picks std::thread::hardware_concurrency()
+    explicit ThreadPool(unsigned threadCount = 0);
+    ~ThreadPool();
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Number of threads that execute a batch, including the caller
+    unsigned size() const { return static_cast<unsigned>(workers_.size()) + 1; }
+
+    // Run body(i) for every i in [0, count) and return once all of them finished
+    void parallelFor(std::size_t count, const std::function<void(std::size_t)>& body);
+
+private:
+    void workerLoop();
+    void runTasks();
+
+    std::vector<std::thread> workers_;
+    std::mutex mutex_;
+    std::condition_variable wake_;         // Signalled when a new batch is posted or on shutdown
+    std::condition_variable finished_;     // Signalled when the last task of a batch completes
+    const std::function<void(std::size_t)>* body_ = nullptr;
+    std::size_t count_ = 0;                // Tasks in the current batch
+    std::size_t next_ = 0;                 // Next task index to hand out
+    std::size_t remaining_ = 0;            // Tasks not yet completed
+    unsigned generation_ = 0;              // Incremented for every batch so workers notice new work
+    bool stopping_ = false;
+};
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <atomic>                          // For the slot exchange
+
+// Hands the newest value from one writer thread to one reader thread without locks or waiting.
+// There are three slots: the writer fills its back slot and publish() swaps it with the middle
+// one, the reader's acquire() swaps its front slot with the middle one when something new was
+// published. Neither ever touches the other's slot, so a value read through front() stays
+// unchanged until the next acquire(), and values published faster than they are read are skipped.
+template <typename T>
+class TripleBuffer {
+public:
+    // Writer: the slot to fill before publish(); it holds whatever value was last left in it
+    T& back() { return slots_[back_]; }
+    // Writer: make back() the newest value and take another slot to fill
+    void publish() { back_ = middle_.exchange(back_ | fresh, std::memory_order_acq_rel) & indexMask; }
+
+    // Reader: move to the newest published value, if there is one since the last call; false otherwise
+    bool acquire() {
+        if ((middle_.load(std::memory_order_relaxed) & fresh) == 0)
+            return false;
+        front_ = middle_.exchange(front_, std::memory_order_acq_rel) & indexMask;
+        return true;
+    }
+    // Reader: the value taken by the last acquire() that returned true
+    const T& front() const { return slots_[front_]; }
+
+private:
+    static constexpr unsigned indexMask = 3;
+    static constexpr unsigned fresh = 4;   // Set in middle_ when the writer published since the reader last took it
+
+    T slots_[3];
+    unsigned back_ = 0;                    // Owned by the writer
+    unsigned front_ = 1;                   // Owned by the reader
+    std::atomic<unsigned> middle_{2};      // Slot index, or-ed with fresh
+};
@@ -0,0 +1,207 @@
+#include "vertex_format.h"
+
+#include <algorithm>                       // For std::min()/std::max()
+#include <cfloat>                          // For FLT_EPSILON
+#include <cmath>                           // For std::abs()/std::nearbyint()/std::atan2()
+#include <cstring>                         // For std::memcpy()
+
+namespace {
+
+const float unormMax = 65535.0f;           // GL maps a stored 16-bit unsigned value c to c / 65535
+const float snormMax = 32767.0f;           // and a signed one to max(c / 32767, -1)
+
+// Round a float to the nearest half float, ties to even; too large values become infinity
+uint16_t floatToHalf(float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, 4);
+    uint16_t sign = static_cast<uint16_t>((bits >> 16) & 0x8000);
+    bits &= 0x7FFFFFFF;
+    if (bits >= 0x7F800000)
+        return sign | (bits > 0x7F800000 ? 0x7E00 : 0x7C00); // NaN stays NaN
+    if (bits < 0x38800000) {
+        // Below the smallest normal half: a multiple of 2^-24, rounded in the default (to even) mode
+        float magnitude;
+        std::memcpy(&magnitude, &bits, 4);
+        return sign | static_cast<uint16_t>(std::nearbyint(magnitude * 16777216.0f));
+    }
+    // Drop 13 mantissa bits rounding to even, then rebias the exponent from 127 to 15
+    uint32_t rounded = bits + 0xFFF + ((bits >> 13) & 1) - 0x38000000;
+    if (rounded >= 0x0F800000)
+        return sign | 0x7C00;
+    return sign | static_cast<uint16_t>(rounded >> 13);
+}
+
+float halfToFloat(uint16_t half) {
+    uint32_t sign = uint32_t(half & 0x8000) << 16;
+    uint32_t exponent = (half >> 10) & 0x1F;
+    uint32_t mantissa = half & 0x3FF;
+    if (exponent == 0) {
+        float magnitude = mantissa / 16777216.0f;
+        return sign != 0 ? -magnitude : magnitude;
+    }
+    uint32_t bits = exponent == 31 ? sign | 0x7F800000 | (mantissa << 13) : sign | ((exponent + 112) << 23) | (mantissa << 13);
+    float value;
+    std::memcpy(&value, &bits, 4);
+    return value;
+}
+
+// Unit normal of an octahedral encoding, as the vertex shader computes it
+void decodeOctahedral(const int16_t encoded[2], float normal[3]) {
+    float x = std::max(encoded[0] / snormMax, -1.0f);
+    float y = std::max(encoded[1] / snormMax, -1.0f);
+    float z = 1.0f - std::abs(x) - std::abs(y);
+    float fold = std::max(-z, 0.0f);       // Lower hemisphere: unfold the corners of the square
+    x += x >= 0.0f ? -fold : fold;
+    y += y >= 0.0f ? -fold : fold;
+    float length = std::sqrt(x * x + y * y + z * z);
+    normal[0] = x / length;
+    normal[1] = y / length;
+    normal[2] = z / length;
+}
+
+// Project a normal onto the octahedron and unfold it into the square. Of the four neighbouring
+// 16-bit values the one that decodes closest to the normal is kept, which more than halves the
+// error of plain rounding. A zero normal (none in the OBJ) encodes as +z.
+void encodeOctahedral(const float normal[3], int16_t encoded[2]) {
+    float sum = std::abs(normal[0]) + std::abs(normal[1]) + std::abs(normal[2]);
+    if (sum == 0.0f) {
+        encoded[0] = encoded[1] = 0;
+        return;
+    }
+    float x = normal[0] / sum, y = normal[1] / sum;
+    if (normal[2] < 0.0f) {
+        float foldedX = (1.0f - std::abs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+        float foldedY = (1.0f - std::abs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+        x = foldedX;
+        y = foldedY;
+    }
+    float length = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+    float baseX = std::floor(x * snormMax), baseY = std::floor(y * snormMax);
+    float best = -2.0f;
+    for (int corner = 0; corner < 4; ++corner) {
+        int16_t candidate[2] = {static_cast<int16_t>(std::min(std::max(baseX + (corner & 1), -snormMax), snormMax)),
+                                static_cast<int16_t>(std::min(std::max(baseY + (corner >> 1), -snormMax), snormMax))};
+        float decoded[3];
+        decodeOctahedral(candidate, decoded);
+        float cosine = (decoded[0] * normal[0] + decoded[1] * normal[1] + decoded[2] * normal[2]) / length;
+        if (cosine > best) {
+            best = cosine;
+            encoded[0] = candidate[0];
+            encoded[1] = candidate[1];
+        }
+    }
+}
+
+CompactVertex encodeCompact(const Vertex& vertex, const Bounds& bounds) {
+    CompactVertex compact = {};
+    for (int axis = 0; axis < 3; ++axis) {
+        float extent = bounds.max[axis] - bounds.min[axis];
+        float unit = extent > 0.0f ? (vertex.position[axis] - bounds.min[axis]) / extent : 0.0f;
+        compact.position[axis] = static_cast<uint16_t>(std::nearbyint(std::min(std::max(unit, 0.0f), 1.0f) * unormMax));
+    }
+    encodeOctahedral(vertex.normal, compact.normal);
+    compact.texcoord[0] = floatToHalf(vertex.texcoord[0]);
+    compact.texcoord[1] = floatToHalf(vertex.texcoord[1]);
+    return compact;
+}
+
+} // namespace
+
+std::size_t vertexStride(VertexFormat format) {
+    return format == VertexFormat::Compact ? sizeof(CompactVertex) : sizeof(Vertex);
+}
+
+const char* vertexFormatName(VertexFormat format) {
+    return format == VertexFormat::Compact ? "compact" : "float";
+}
+
+bool parseVertexFormat(const std::string& name, VertexFormat& format) {
+    if (name == "float")
+        format = VertexFormat::Float;
+    else if (name == "compact")
+        format = VertexFormat::Compact;
+    else
+        return false;
+    return true;
+}
+
+void positionDecode(VertexFormat format, const Bounds& bounds, float scale[3], float offset[3]) {
+    for (int axis = 0; axis < 3; ++axis) {
+        bool compact = format == VertexFormat::Compact;
+        scale[axis] = compact ? bounds.max[axis] - bounds.min[axis] : 1.0f;
+        offset[axis] = compact ? bounds.min[axis] : 0.0f;
+    }
+}
+
+void encodeVertices(VertexFormat format, const Vertex* vertices, std::size_t count, const Bounds& bounds, uint8_t* out) {
+    if (format == VertexFormat::Float) {
+        std::memcpy(out, vertices, count * sizeof(Vertex));
+        return;
+    }
+    for (std::size_t i = 0; i < count; ++i) {
+        CompactVertex compact = encodeCompact(vertices[i], bounds);
+        std::memcpy(out + i * sizeof(CompactVertex), &compact, sizeof(CompactVertex));
+    }
+}
+
+void encodeGeometry(VertexFormat format, const IndexedGeometry& geometry, std::vector<uint8_t>& out) {
+    std::size_t stride = vertexStride(format);
+    out.resize(geometry.vertices.size() * stride);
+    for (const DrawShape& shape : geometry.shapes) {
+        encodeVertices(format, &geometry.vertices[shape.baseVertex], shape.vertexCount, shape.bounds,
+                       out.data() + std::size_t(shape.baseVertex) * stride);
+    }
+}
+
+Vertex decodeCompactVertex(const CompactVertex& vertex, const Bounds& bounds) {
+    Vertex decoded;
+    float scale[3], offset[3];
+    positionDecode(VertexFormat::Compact, bounds, scale, offset);
+    for (int axis = 0; axis < 3; ++axis)
+        decoded.position[axis] = offset[axis] + scale[axis] * (vertex.position[axis] / unormMax);
+    decodeOctahedral(vertex.normal, decoded.normal);
+    decoded.texcoord[0] = halfToFloat(vertex.texcoord[0]);
+    decoded.texcoord[1] = halfToFloat(vertex.texcoord[1]);
+    return decoded;
+}
+
+QuantizationError measureQuantizationError(const IndexedGeometry& geometry) {
+    const float radiansToDegrees = 57.2957795f;
+    QuantizationError error;
+    for (const DrawShape& shape : geometry.shapes) {
+        const Bounds& bounds = shape.bounds;
+        for (uint32_t v = 0; v < shape.vertexCount; ++v) {
+            const Vertex& original = geometry.vertices[shape.baseVertex + v];
+            Vertex decoded = decodeCompactVertex(encodeCompact(original, bounds), bounds);
+
+            for (int axis = 0; axis < 3; ++axis) {
+                float step = (bounds.max[axis] - bounds.min[axis]) / unormMax;
+                float rounding = 4.0f * FLT_EPSILON * std::max(std::abs(bounds.min[axis]), std::abs(bounds.max[axis]));
+                float difference = std::abs(decoded.position[axis] - original.position[axis]);
+                error.position = std::max(error.position, difference);
+                if (step > 0.0f)
+                    error.positionSteps = std::max(error.positionSteps, difference / step);
+                error.withinBounds = error.withinBounds && difference <= 0.5f * step + rounding;
+            }
+
+            const float* n = original.normal;
+            float length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+            if (length > 0.0f) {
+                const float* d = decoded.normal;
+                float cross[3] = {n[1] * d[2] - n[2] * d[1], n[2] * d[0] - n[0] * d[2], n[0] * d[1] - n[1] * d[0]};
+                float sine = std::sqrt(cross[0] * cross[0] + cross[1] * cross[1] + cross[2] * cross[2]);
+                float degrees = std::atan2(sine, n[0] * d[0] + n[1] * d[1] + n[2] * d[2]) * radiansToDegrees;
+                error.normalDegrees = std::max(error.normalDegrees, degrees);
+                error.withinBounds = error.withinBounds && degrees <= maxNormalErrorDegrees;
+            }
+
+            for (int k = 0; k < 2; ++k) {
+                float difference = std::abs(decoded.texcoord[k] - original.texcoord[k]);
+                float halfUlp = std::max(std::abs(original.texcoord[k]) / 2048.0f, 1.0f / 33554432.0f); // 2^-11 relative, 2^-25 below 2^-14
+                error.texcoord = std::max(error.texcoord, difference);
+                error.withinBounds = error.withinBounds && difference <= halfUlp;
+            }
+        }
+    }
+    return error;
+}
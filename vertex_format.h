@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>                         // For std::size_t
+#include <cstdint>                         // Fixed-width integer types
+#include <string>                          // For format names
+#include <vector>                          // For using the std::vector container
+#include "geometry.h"                      // Source vertices and shape bounds
+
+// Layout of the vertices in the VBO
+enum class VertexFormat {
+    Float,                                 // Vertex as built, 32 bytes
+    Compact                                // CompactVertex, 16 bytes
+};
+
+// Quantised vertex: positions as 16-bit unsigned normalised values across the shape's bounds (undone
+// by the per-draw model matrix, see positionDecode()), normals octahedral-encoded into two signed
+// normalised 16-bit values and texture coordinates as half floats
+struct CompactVertex {
+    uint16_t position[4];                  // Attribute location 0, the fourth value pads to 8 bytes
+    int16_t normal[2];                     // Attribute location 1, decoded in the vertex shader
+    uint16_t texcoord[2];                  // Attribute location 2, GL_HALF_FLOAT
+};
+
+// Bytes per vertex in the VBO
+std::size_t vertexStride(VertexFormat format);
+
+// "float" or "compact"
+const char* vertexFormatName(VertexFormat format);
+// Parse a format name, false if name is not one
+bool parseVertexFormat(const std::string& name, VertexFormat& format);
+
+// Scale and offset taking stored positions of a shape with bounds back to object space:
+// position = offset + scale * stored, with stored in 0..1 for compact vertices
+void positionDecode(VertexFormat format, const Bounds& bounds, float scale[3], float offset[3]);
+
+// Write count vertices of a shape with bounds in format to out, vertexStride(format) bytes each
+void encodeVertices(VertexFormat format, const Vertex* vertices, std::size_t count, const Bounds& bounds, uint8_t* out);
+
+// Encode every shape of geometry in format into out, in the order of geometry.vertices
+void encodeGeometry(VertexFormat format, const IndexedGeometry& geometry, std::vector<uint8_t>& out);
+
+// Object-space vertex the vertex shader sees for a compact vertex of a shape with bounds
+Vertex decodeCompactVertex(const CompactVertex& vertex, const Bounds& bounds);
+
+// Largest differences between the vertices of a geometry and their compact encoding
+struct QuantizationError {
+    float position = 0.0f;                 // Largest distance along an axis, object units
+    float positionSteps = 0.0f;            // The same in 16-bit steps of the shape's extent on that axis
+    float normalDegrees = 0.0f;            // Largest angle to an OBJ normal (vertices without one are skipped)
+    float texcoord = 0.0f;                 // Largest difference of a texture coordinate
+    bool withinBounds = true;              // Every difference within the format's guaranteed bounds
+};
+
+// Largest angle between a unit normal and its octahedral encoding, in degrees
+const float maxNormalErrorDegrees = 0.01f;
+
+// Encode and decode every vertex of geometry and compare with the vertices as built from the OBJ. The
+// bounds are half a 16-bit step of the shape's extent per position axis, maxNormalErrorDegrees per
+// normal and half a half-float ulp per texture coordinate, each plus float rounding.
+QuantizationError measureQuantizationError(const IndexedGeometry& geometry);
@@ -0,0 +1,283 @@
+#include "vertex_transform.h"
+
+#include <cstring>                         // For std::memcpy()
+#if defined(__x86_64__) || defined(__i386__)
+#define VERTEX_TRANSFORM_X86 1
+#include <immintrin.h>                     // SSE2, AVX2 and AVX-512 kernels, each compiled for its own target
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>                      // NEON kernel
+#endif
+
+// Compilers fuse multiplies and adds into FMAs where the target has them, which rounds differently;
+// clang follows the standard pragma, GCC only its own function attribute
+#if defined(__clang__)
+#pragma STDC FP_CONTRACT OFF
+#define NO_FP_CONTRACT
+#elif defined(__GNUC__)
+#define NO_FP_CONTRACT __attribute__((optimize("fp-contract=off")))
+#else
+#define NO_FP_CONTRACT
+#endif
+
+namespace {
+
+// Vertices [first, count) one at a time; the reference the wider kernels match and finish with
+NO_FP_CONTRACT
+ClipSummary transformScalar(const glm::mat4& m, const PositionArrays& p, std::size_t first, std::size_t count,
+                            const ClipArrays& clip, uint8_t* outcodes) {
+    ClipSummary summary;
+    for (std::size_t i = first; i < count; ++i) {
+        float x = p.x[i], y = p.y[i], z = p.z[i];
+        float cx = m[0][0] * x + m[1][0] * y + m[2][0] * z + m[3][0];
+        float cy = m[0][1] * x + m[1][1] * y + m[2][1] * z + m[3][1];
+        float cz = m[0][2] * x + m[1][2] * y + m[2][2] * z + m[3][2];
+        float cw = m[0][3] * x + m[1][3] * y + m[2][3] * z + m[3][3];
+        clip.x[i] = cx;
+        clip.y[i] = cy;
+        clip.z[i] = cz;
+        clip.w[i] = cw;
+        uint8_t code = clipOutcode(cx, cy, cz, cw);
+        outcodes[i] = code;
+        summary.allOutside &= code;
+        summary.anyOutside |= code;
+    }
+    return summary;
+}
+
+// Fold per-lane outcode accumulators into a summary
+ClipSummary summarize(const uint32_t* all, const uint32_t* any, int lanes) {
+    ClipSummary summary;
+    for (int lane = 0; lane < lanes; ++lane) {
+        summary.allOutside &= static_cast<uint8_t>(all[lane]);
+        summary.anyOutside |= static_cast<uint8_t>(any[lane]);
+    }
+    return summary;
+}
+
+#if defined(VERTEX_TRANSFORM_X86)
+
+__attribute__((target("sse2"))) NO_FP_CONTRACT
+ClipSummary transformSse2(const glm::mat4& m, const PositionArrays& p, std::size_t count, const ClipArrays& clip, uint8_t* outcodes) {
+    __m128 c[4][4];                        // c[column][row], broadcast
+    for (int column = 0; column < 4; ++column) {
+        for (int row = 0; row < 4; ++row)
+            c[column][row] = _mm_set1_ps(m[column][row]);
+    }
+    const __m128i bits[6] = {_mm_set1_epi32(outsideLeft), _mm_set1_epi32(outsideRight), _mm_set1_epi32(outsideBottom),
+                             _mm_set1_epi32(outsideTop), _mm_set1_epi32(outsideNear), _mm_set1_epi32(outsideFar)};
+    __m128i all = _mm_set1_epi32(0x3F), any = _mm_setzero_si128();
+    std::size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128 x = _mm_loadu_ps(p.x + i), y = _mm_loadu_ps(p.y + i), z = _mm_loadu_ps(p.z + i);
+        __m128 out[4];
+        for (int row = 0; row < 4; ++row) {
+            out[row] = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(c[0][row], x), _mm_mul_ps(c[1][row], y)),
+                                             _mm_mul_ps(c[2][row], z)), c[3][row]);
+        }
+        _mm_storeu_ps(clip.x + i, out[0]);
+        _mm_storeu_ps(clip.y + i, out[1]);
+        _mm_storeu_ps(clip.z + i, out[2]);
+        _mm_storeu_ps(clip.w + i, out[3]);
+
+        __m128 w = out[3], negativeW = _mm_sub_ps(_mm_setzero_ps(), out[3]);
+        __m128i code = _mm_setzero_si128();
+        for (int axis = 0; axis < 3; ++axis) {
+            code = _mm_or_si128(code, _mm_and_si128(_mm_castps_si128(_mm_cmplt_ps(out[axis], negativeW)), bits[2 * axis]));
+            code = _mm_or_si128(code, _mm_and_si128(_mm_castps_si128(_mm_cmpgt_ps(out[axis], w)), bits[2 * axis + 1]));
+        }
+        all = _mm_and_si128(all, code);
+        any = _mm_or_si128(any, code);
+        int32_t packed = _mm_cvtsi128_si32(_mm_packus_epi16(_mm_packs_epi32(code, code), _mm_setzero_si128()));
+        std::memcpy(outcodes + i, &packed, 4);
+    }
+    uint32_t allLanes[4], anyLanes[4];
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(allLanes), all);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(anyLanes), any);
+    ClipSummary summary = summarize(allLanes, anyLanes, 4);
+    return summary += transformScalar(m, p, i, count, clip, outcodes);
+}
+
+__attribute__((target("avx2"))) NO_FP_CONTRACT
+ClipSummary transformAvx2(const glm::mat4& m, const PositionArrays& p, std::size_t count, const ClipArrays& clip, uint8_t* outcodes) {
+    __m256 c[4][4];
+    for (int column = 0; column < 4; ++column) {
+        for (int row = 0; row < 4; ++row)
+            c[column][row] = _mm256_set1_ps(m[column][row]);
+    }
+    const __m256i bits[6] = {_mm256_set1_epi32(outsideLeft), _mm256_set1_epi32(outsideRight), _mm256_set1_epi32(outsideBottom),
+                             _mm256_set1_epi32(outsideTop), _mm256_set1_epi32(outsideNear), _mm256_set1_epi32(outsideFar)};
+    __m256i all = _mm256_set1_epi32(0x3F), any = _mm256_setzero_si256();
+    std::size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 x = _mm256_loadu_ps(p.x + i), y = _mm256_loadu_ps(p.y + i), z = _mm256_loadu_ps(p.z + i);
+        __m256 out[4];
+        for (int row = 0; row < 4; ++row) {
+            out[row] = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(c[0][row], x), _mm256_mul_ps(c[1][row], y)),
+                                                   _mm256_mul_ps(c[2][row], z)), c[3][row]);
+        }
+        _mm256_storeu_ps(clip.x + i, out[0]);
+        _mm256_storeu_ps(clip.y + i, out[1]);
+        _mm256_storeu_ps(clip.z + i, out[2]);
+        _mm256_storeu_ps(clip.w + i, out[3]);
+
+        __m256 w = out[3], negativeW = _mm256_sub_ps(_mm256_setzero_ps(), out[3]);
+        __m256i code = _mm256_setzero_si256();
+        for (int axis = 0; axis < 3; ++axis) {
+            code = _mm256_or_si256(code, _mm256_and_si256(_mm256_castps_si256(_mm256_cmp_ps(out[axis], negativeW, _CMP_LT_OQ)), bits[2 * axis]));
+            code = _mm256_or_si256(code, _mm256_and_si256(_mm256_castps_si256(_mm256_cmp_ps(out[axis], w, _CMP_GT_OQ)), bits[2 * axis + 1]));
+        }
+        all = _mm256_and_si256(all, code);
+        any = _mm256_or_si256(any, code);
+        __m128i words = _mm_packs_epi32(_mm256_castsi256_si128(code), _mm256_extracti128_si256(code, 1));
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(outcodes + i), _mm_packus_epi16(words, words));
+    }
+    uint32_t allLanes[8], anyLanes[8];
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(allLanes), all);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(anyLanes), any);
+    ClipSummary summary = summarize(allLanes, anyLanes, 8);
+    return summary += transformScalar(m, p, i, count, clip, outcodes);
+}
+
+__attribute__((target("avx512f"))) NO_FP_CONTRACT
+ClipSummary transformAvx512(const glm::mat4& m, const PositionArrays& p, std::size_t count, const ClipArrays& clip, uint8_t* outcodes) {
+    __m512 c[4][4];
+    for (int column = 0; column < 4; ++column) {
+        for (int row = 0; row < 4; ++row)
+            c[column][row] = _mm512_set1_ps(m[column][row]);
+    }
+    const __m512i bits[6] = {_mm512_set1_epi32(outsideLeft), _mm512_set1_epi32(outsideRight), _mm512_set1_epi32(outsideBottom),
+                             _mm512_set1_epi32(outsideTop), _mm512_set1_epi32(outsideNear), _mm512_set1_epi32(outsideFar)};
+    __m512i all = _mm512_set1_epi32(0x3F), any = _mm512_setzero_si512();
+    std::size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m512 x = _mm512_loadu_ps(p.x + i), y = _mm512_loadu_ps(p.y + i), z = _mm512_loadu_ps(p.z + i);
+        __m512 out[4];
+        for (int row = 0; row < 4; ++row) {
+            out[row] = _mm512_add_ps(_mm512_add_ps(_mm512_add_ps(_mm512_mul_ps(c[0][row], x), _mm512_mul_ps(c[1][row], y)),
+                                                   _mm512_mul_ps(c[2][row], z)), c[3][row]);
+        }
+        _mm512_storeu_ps(clip.x + i, out[0]);
+        _mm512_storeu_ps(clip.y + i, out[1]);
+        _mm512_storeu_ps(clip.z + i, out[2]);
+        _mm512_storeu_ps(clip.w + i, out[3]);
+
+        // Comparisons give lane masks, which select the lanes each bit is or-ed into
+        __m512 w = out[3], negativeW = _mm512_sub_ps(_mm512_setzero_ps(), out[3]);
+        __m512i code = _mm512_setzero_si512();
+        for (int axis = 0; axis < 3; ++axis) {
+            code = _mm512_mask_or_epi32(code, _mm512_cmp_ps_mask(out[axis], negativeW, _CMP_LT_OQ), code, bits[2 * axis]);
+            code = _mm512_mask_or_epi32(code, _mm512_cmp_ps_mask(out[axis], w, _CMP_GT_OQ), code, bits[2 * axis + 1]);
+        }
+        all = _mm512_and_si512(all, code);
+        any = _mm512_or_si512(any, code);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(outcodes + i), _mm512_cvtepi32_epi8(code));
+    }
+    uint32_t allLanes[16], anyLanes[16];
+    _mm512_storeu_si512(allLanes, all);
+    _mm512_storeu_si512(anyLanes, any);
+    ClipSummary summary = summarize(allLanes, anyLanes, 16);
+    return summary += transformScalar(m, p, i, count, clip, outcodes);
+}
+
+#elif defined(__ARM_NEON)
+
+NO_FP_CONTRACT
+ClipSummary transformNeon(const glm::mat4& m, const PositionArrays& p, std::size_t count, const ClipArrays& clip, uint8_t* outcodes) {
+    float32x4_t c[4][4];
+    for (int column = 0; column < 4; ++column) {
+        for (int row = 0; row < 4; ++row)
+            c[column][row] = vdupq_n_f32(m[column][row]);
+    }
+    const uint32x4_t bits[6] = {vdupq_n_u32(outsideLeft), vdupq_n_u32(outsideRight), vdupq_n_u32(outsideBottom),
+                                vdupq_n_u32(outsideTop), vdupq_n_u32(outsideNear), vdupq_n_u32(outsideFar)};
+    uint32x4_t all = vdupq_n_u32(0x3F), any = vdupq_n_u32(0);
+    std::size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        float32x4_t x = vld1q_f32(p.x + i), y = vld1q_f32(p.y + i), z = vld1q_f32(p.z + i);
+        float32x4_t out[4];
+        for (int row = 0; row < 4; ++row) { // Multiplies and adds kept separate, as in the other kernels
+            out[row] = vaddq_f32(vaddq_f32(vaddq_f32(vmulq_f32(c[0][row], x), vmulq_f32(c[1][row], y)),
+                                           vmulq_f32(c[2][row], z)), c[3][row]);
+        }
+        vst1q_f32(clip.x + i, out[0]);
+        vst1q_f32(clip.y + i, out[1]);
+        vst1q_f32(clip.z + i, out[2]);
+        vst1q_f32(clip.w + i, out[3]);
+
+        float32x4_t w = out[3], negativeW = vnegq_f32(out[3]);
+        uint32x4_t code = vdupq_n_u32(0);
+        for (int axis = 0; axis < 3; ++axis) {
+            code = vorrq_u32(code, vandq_u32(vcltq_f32(out[axis], negativeW), bits[2 * axis]));
+            code = vorrq_u32(code, vandq_u32(vcgtq_f32(out[axis], w), bits[2 * axis + 1]));
+        }
+        all = vandq_u32(all, code);
+        any = vorrq_u32(any, code);
+        uint16x4_t words = vmovn_u32(code);
+        uint32_t packed = vget_lane_u32(vreinterpret_u32_u8(vmovn_u16(vcombine_u16(words, words))), 0);
+        std::memcpy(outcodes + i, &packed, 4);
+    }
+    uint32_t allLanes[4], anyLanes[4];
+    vst1q_u32(allLanes, all);
+    vst1q_u32(anyLanes, any);
+    ClipSummary summary = summarize(allLanes, anyLanes, 4);
+    return summary += transformScalar(m, p, i, count, clip, outcodes);
+}
+
+#endif
+
+} // namespace
+
+ClipSummary& ClipSummary::operator+=(const ClipSummary& other) {
+    allOutside &= other.allOutside;
+    anyOutside |= other.anyOutside;
+    return *this;
+}
+
+const char* transformKernelName(TransformKernel kernel) {
+    switch (kernel) {
+    case TransformKernel::SSE2: return "sse2";
+    case TransformKernel::AVX2: return "avx2";
+    case TransformKernel::AVX512: return "avx512";
+    case TransformKernel::NEON: return "neon";
+    default: return "scalar";
+    }
+}
+
+bool transformKernelSupported(TransformKernel kernel) {
+    switch (kernel) {
+    case TransformKernel::Scalar: return true;
+#if defined(VERTEX_TRANSFORM_X86)
+    case TransformKernel::SSE2: return __builtin_cpu_supports("sse2");
+    case TransformKernel::AVX2: return __builtin_cpu_supports("avx2");
+    case TransformKernel::AVX512: return __builtin_cpu_supports("avx512f");
+#elif defined(__ARM_NEON)
+    case TransformKernel::NEON: return true;
+#endif
+    default: return false;
+    }
+}
+
+TransformKernel bestTransformKernel() {
+    static const TransformKernel best = [] {
+        for (TransformKernel kernel : {TransformKernel::AVX512, TransformKernel::AVX2, TransformKernel::SSE2, TransformKernel::NEON}) {
+            if (transformKernelSupported(kernel))
+                return kernel;
+        }
+        return TransformKernel::Scalar;
+    }();
+    return best;
+}
+
+ClipSummary transformPositions(const glm::mat4& clipFromObject, const PositionArrays& positions, std::size_t count,
+                               const ClipArrays& clip, uint8_t* outcodes, TransformKernel kernel) {
+    switch (kernel) {
+#if defined(VERTEX_TRANSFORM_X86)
+    case TransformKernel::SSE2: return transformSse2(clipFromObject, positions, count, clip, outcodes);
+    case TransformKernel::AVX2: return transformAvx2(clipFromObject, positions, count, clip, outcodes);
+    case TransformKernel::AVX512: return transformAvx512(clipFromObject, positions, count, clip, outcodes);
+#elif defined(__ARM_NEON)
+    case TransformKernel::NEON: return transformNeon(clipFromObject, positions, count, clip, outcodes);
+#endif
+    default: return transformScalar(clipFromObject, positions, 0, count, clip, outcodes);
+    }
+}
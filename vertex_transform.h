@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstddef>                         // For std::size_t
+#include <cstdint>                         // Fixed-width integer types
+#include <glm/glm.hpp>                     // GLM library for handling matrices and vectors
+
+// Outcode bits of a clip-space vertex, one for every plane of the clip volume it lies outside
+const uint8_t outsideLeft = 1;             // x < -w
+const uint8_t outsideRight = 2;            // x > w
+const uint8_t outsideBottom = 4;           // y < -w
+const uint8_t outsideTop = 8;              // y > w
+const uint8_t outsideNear = 16;            // z < -w
+const uint8_t outsideFar = 32;             // z > w
+
+// Outcode of one clip-space vertex
+inline uint8_t clipOutcode(float x, float y, float z, float w) {
+    return static_cast<uint8_t>((x < -w ? outsideLeft : 0) | (x > w ? outsideRight : 0) | (y < -w ? outsideBottom : 0) |
+                                (y > w ? outsideTop : 0) | (z < -w ? outsideNear : 0) | (z > w ? outsideFar : 0));
+}
+
+// Implementations of transformPositions(), named after the widest instructions they use
+enum class TransformKernel { Scalar, SSE2, AVX2, AVX512, NEON };
+
+const char* transformKernelName(TransformKernel kernel);
+// True if kernel was compiled in and the CPU runs it; x86 kernels are detected at run time
+bool transformKernelSupported(TransformKernel kernel);
+// Widest supported kernel, detected once
+TransformKernel bestTransformKernel();
+
+// Object-space positions as separate coordinate arrays
+struct PositionArrays {
+    const float* x;
+    const float* y;
+    const float* z;
+};
+
+// Clip-space positions as separate coordinate arrays
+struct ClipArrays {
+    float* x;
+    float* y;
+    float* z;
+    float* w;
+};
+
+// AND and OR of the outcodes of a batch of vertices: a triangle of the batch can be rejected
+// without looking at it when allOutside is set and needs no clipping when anyOutside is 0
+struct ClipSummary {
+    uint8_t allOutside = 0x3F;
+    uint8_t anyOutside = 0;
+
+    ClipSummary& operator+=(const ClipSummary& other);
+};
+
+// Transform count positions by clipFromObject into clip and write every vertex's outcode to outcodes.
+// Each coordinate is summed in the same order with separate multiplies and adds (no FMA) in every
+// kernel, so all kernels compute the same values as the scalar one.
+ClipSummary transformPositions(const glm::mat4& clipFromObject, const PositionArrays& positions, std::size_t count,
+                               const ClipArrays& clip, uint8_t* outcodes, TransformKernel kernel = bestTransformKernel());